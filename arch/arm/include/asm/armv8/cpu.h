@@ -3,6 +3,11 @@
  * Copyright 2018 NXP
  */
 
+#ifndef __ASM_ARMV8_CPU_H
+#define __ASM_ARMV8_CPU_H
+
+#include <linux/compiler.h>
+
 #define MIDR_PARTNUM_CORTEX_A35	0xD04
 #define MIDR_PARTNUM_CORTEX_A53	0xD03
 #define MIDR_PARTNUM_CORTEX_A72	0xD08
@@ -18,9 +23,28 @@ static inline unsigned int read_midr(void)
 	return val;
 }
 
+#define ID_AA64ISAR0_SHA1_SHIFT		8
+#define ID_AA64ISAR0_SHA2_SHIFT		12
+#define ID_AA64ISAR0_CRC32_SHIFT	16
+#define ID_AA64ISAR0_FIELD_MASK		0xf
+
+static __always_inline unsigned long read_id_aa64isar0(void)
+{
+	unsigned long val;
+
+	asm volatile("mrs %0, id_aa64isar0_el1" : "=r" (val));
+
+	return val;
+}
+
+#define id_aa64isar0_field(shift) \
+	((read_id_aa64isar0() >> (shift)) & ID_AA64ISAR0_FIELD_MASK)
+
 #define is_cortex_a35() (((read_midr() & MIDR_PARTNUM_MASK) >> \
 			 MIDR_PARTNUM_SHIFT) == MIDR_PARTNUM_CORTEX_A35)
 #define is_cortex_a53() (((read_midr() & MIDR_PARTNUM_MASK) >> \
 			 MIDR_PARTNUM_SHIFT) == MIDR_PARTNUM_CORTEX_A53)
 #define is_cortex_a72() (((read_midr() & MIDR_PARTNUM_MASK) >>\
 			 MIDR_PARTNUM_SHIFT) == MIDR_PARTNUM_CORTEX_A72)
+
+#endif /* __ASM_ARMV8_CPU_H */
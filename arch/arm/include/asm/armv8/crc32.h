@@ -0,0 +1,18 @@
+/* SPDX-License-Identifier: GPL-2.0+ */
+/*
+ * CRC-32 using the ARMv8 CRC32 instructions
+ */
+
+#ifndef __ASM_ARMV8_CRC32_H
+#define __ASM_ARMV8_CRC32_H
+
+#include <asm/armv8/cpu.h>
+
+#define crc32_armv8_available() \
+	(id_aa64isar0_field(ID_AA64ISAR0_CRC32_SHIFT) != 0)
+
+/* Same as crc32_no_comp(): no pre- or post-inversion of 'crc' */
+uint32_t crc32_armv8(uint32_t crc, const unsigned char *buf,
+		     unsigned int len);
+
+#endif /* __ASM_ARMV8_CRC32_H */
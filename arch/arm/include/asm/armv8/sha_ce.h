@@ -0,0 +1,28 @@
+/* SPDX-License-Identifier: GPL-2.0+ */
+/*
+ * SHA-1/SHA-256 block functions using the ARMv8 Crypto Extensions
+ */
+
+#ifndef __ASM_ARMV8_SHA_CE_H
+#define __ASM_ARMV8_SHA_CE_H
+
+#include <asm/armv8/cpu.h>
+
+/* Set to force the generic C code, e.g. to test it against the CE code */
+extern bool sha1_ce_disabled;
+extern bool sha256_ce_disabled;
+
+#define sha1_ce_available() \
+	(!sha1_ce_disabled && \
+	 id_aa64isar0_field(ID_AA64ISAR0_SHA1_SHIFT) != 0)
+#define sha256_ce_available() \
+	(!sha256_ce_disabled && \
+	 id_aa64isar0_field(ID_AA64ISAR0_SHA2_SHIFT) != 0)
+
+/* Hash 'blocks' 64-byte blocks of 'data' into 'state' */
+void sha1_ce_transform(uint32_t state[5], const uint8_t *data,
+		       uint32_t blocks);
+void sha256_ce_transform(uint32_t state[8], const uint8_t *data,
+			 uint32_t blocks);
+
+#endif /* __ASM_ARMV8_SHA_CE_H */
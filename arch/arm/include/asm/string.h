@@ -19,7 +19,12 @@ extern char * strchr(const char * s, int c);
 #endif
 extern void * memcpy(void *, const void *, __kernel_size_t);
 
+/* memcpy-arm64.S provides memmove() as well */
+#if CONFIG_IS_ENABLED(USE_ARCH_MEMCPY) && defined(CONFIG_ARM64)
+#define __HAVE_ARCH_MEMMOVE
+#else
 #undef __HAVE_ARCH_MEMMOVE
+#endif
 extern void * memmove(void *, const void *, __kernel_size_t);
 
 #undef __HAVE_ARCH_MEMCHR
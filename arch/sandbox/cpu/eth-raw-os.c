@@ -68,7 +68,10 @@ static int _raw_packet_start(struct eth_sandbox_raw_priv *priv,
 			     unsigned char *ethmac)
 {
 	struct sockaddr_ll *device;
+	struct sockaddr_ll addr;
 	struct packet_mreq mr;
+	struct ifreq ifr;
+	int rcvbuf = 4 << 20;
 	int ret;
 	int flags;
 
@@ -100,19 +103,42 @@ static int _raw_packet_start(struct eth_sandbox_raw_priv *priv,
 		       errno, strerror(errno));
 		return -errno;
 	}
+	/* SO_BINDTODEVICE does not filter what a packet socket receives */
+	memset(&addr, 0, sizeof(addr));
+	addr.sll_family = AF_PACKET;
+	addr.sll_protocol = htons(ETH_P_ALL);
+	addr.sll_ifindex = device->sll_ifindex;
+	ret = bind(priv->sd, (struct sockaddr *)&addr, sizeof(addr));
+	if (ret < 0) {
+		printf("Failed to bind to '%s': %d %s\n", priv->host_ifname,
+		       errno, strerror(errno));
+		return -errno;
+	}
+
+	/* Leave room for a burst of frames, such as a TCP window */
+	if (setsockopt(priv->sd, SOL_SOCKET, SO_RCVBUFFORCE, &rcvbuf,
+		       sizeof(rcvbuf)) < 0)
+		setsockopt(priv->sd, SOL_SOCKET, SO_RCVBUF, &rcvbuf,
+			   sizeof(rcvbuf));
 
 	/* Make the socket non-blocking */
 	flags = fcntl(priv->sd, F_GETFL, 0);
 	fcntl(priv->sd, F_SETFL, flags | O_NONBLOCK);
 
+	/* Let U-Boot use jumbo frames if the host interface does */
+	priv->mtu = 0;
+	memset(&ifr, 0, sizeof(ifr));
+	strncpy(ifr.ifr_name, priv->host_ifname, IFNAMSIZ - 1);
+	if (ioctl(priv->sd, SIOCGIFMTU, &ifr) == 0)
+		priv->mtu = ifr.ifr_mtu;
+
 	/* Enable promiscuous mode to receive responses meant for us */
+	memset(&mr, 0, sizeof(mr));
 	mr.mr_ifindex = device->sll_ifindex;
 	mr.mr_type = PACKET_MR_PROMISC;
 	ret = setsockopt(priv->sd, SOL_PACKET, PACKET_ADD_MEMBERSHIP,
 		   &mr, sizeof(mr));
 	if (ret < 0) {
-		struct ifreq ifr;
-
 		printf("Failed to set promiscuous mode: %d %s\n"
 		       "Falling back to the old \"flags\" way...\n",
 			errno, strerror(errno));
@@ -260,16 +286,21 @@ int sandbox_eth_raw_os_send(void *packet, int length,
 int sandbox_eth_raw_os_recv(void *packet, int *length,
 			    const struct eth_sandbox_raw_priv *priv)
 {
+	struct sockaddr_ll saddr;
+	socklen_t saddr_size;
 	int retval;
-	int saddr_size;
 
 	if (priv->sd < 0 || !priv->device)
 		return -EINVAL;
-	saddr_size = sizeof(struct sockaddr);
-	retval = recvfrom(priv->sd, packet, 1536, 0,
-			  (struct sockaddr *)priv->device,
-			  (socklen_t *)&saddr_size);
+	/* Don't let the source address overwrite the one we send to */
+	saddr_size = sizeof(saddr);
+	retval = recvfrom(priv->sd, packet, *length, 0,
+			  (struct sockaddr *)&saddr, &saddr_size);
 	*length = 0;
+	/* Skip the copies of the frames we send */
+	if (retval >= 0 && !priv->local &&
+	    saddr.sll_pkttype == PACKET_OUTGOING)
+		return 0;
 	if (retval >= 0) {
 		*length = retval;
 		return 0;
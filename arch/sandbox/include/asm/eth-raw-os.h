@@ -23,6 +23,7 @@
  *		 a message to the server claiming the port is
  *		 unreachable
  * local_bind_udp_port: The UDP port number that we bound to
+ * mtu: MTU of the host interface, or 0 if not known
  */
 struct eth_sandbox_raw_priv {
 	int sd;
@@ -32,6 +33,7 @@ struct eth_sandbox_raw_priv {
 	int local;
 	int local_bind_sd;
 	unsigned short local_bind_udp_port;
+	int mtu;
 };
 
 /* A struct to mimic if_nameindex but that does not depend on Linux headers */
@@ -66,6 +68,15 @@ int sandbox_eth_raw_os_start(struct eth_sandbox_raw_priv *priv,
 			     unsigned char *ethmac);
 int sandbox_eth_raw_os_send(void *packet, int length,
 			    struct eth_sandbox_raw_priv *priv);
+/*
+ * Receive a packet, if one is waiting.
+ *
+ * packet - buffer for the packet
+ * length - size of the buffer on entry, length of the packet (or 0 if
+ *	    there was none) on return
+ *
+ * returns - 0 if success, negative if error
+ */
 int sandbox_eth_raw_os_recv(void *packet, int *length,
 			    const struct eth_sandbox_raw_priv *priv);
 void sandbox_eth_raw_os_stop(struct eth_sandbox_raw_priv *priv);
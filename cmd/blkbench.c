@@ -0,0 +1,196 @@
+// SPDX-License-Identifier: GPL-2.0+
+/*
+ * Block device throughput and latency benchmark
+ */
+
+#include <common.h>
+#include <blk.h>
+#include <command.h>
+#include <console.h>
+#include <div64.h>
+#include <display_options.h>
+#include <malloc.h>
+#include <memalign.h>
+#include <part.h>
+#include <time.h>
+#include <linux/math64.h>
+
+struct blkbench_result {
+	ulong ops;
+	ulong min_us;
+	ulong max_us;
+	u64 total_us;
+};
+
+/* xorshift32, good enough to scatter the offsets of random I/O */
+static u32 blkbench_rand(u32 *state)
+{
+	u32 x = *state;
+
+	x ^= x << 13;
+	x ^= x >> 17;
+	x ^= x << 5;
+	*state = x;
+
+	return x;
+}
+
+static int blkbench_run(struct blk_desc *desc, bool write, bool random,
+			lbaint_t start, lbaint_t count, lbaint_t xfer,
+			void *buf, struct blkbench_result *res)
+{
+	ulong slots = lldiv(count, xfer);
+	u32 seed = timer_get_us() | 1;
+	ulong i, t, n;
+	lbaint_t blk;
+
+	res->ops = 0;
+	res->min_us = ~0UL;
+	res->max_us = 0;
+	res->total_us = 0;
+
+	for (i = 0; i < slots; i++) {
+		if (random)
+			blk = start +
+			      (lbaint_t)(blkbench_rand(&seed) % slots) * xfer;
+		else
+			blk = start + i * xfer;
+
+		t = timer_get_us();
+		if (write)
+			n = blk_dwrite(desc, blk, xfer, buf);
+		else
+			n = blk_dread(desc, blk, xfer, buf);
+		t = timer_get_us() - t;
+
+		if (n != xfer) {
+			printf("%s error at block " LBAFU "\n",
+			       write ? "write" : "read", blk);
+			return -EIO;
+		}
+
+		res->ops++;
+		res->total_us += t;
+		if (t < res->min_us)
+			res->min_us = t;
+		if (t > res->max_us)
+			res->max_us = t;
+
+		if (ctrlc())
+			return -EINTR;
+	}
+
+	return 0;
+}
+
+static void blkbench_report(struct blk_desc *desc, lbaint_t xfer,
+			    struct blkbench_result *res)
+{
+	u64 bytes = (u64)res->ops * xfer * desc->blksz;
+	u64 us = res->total_us ? res->total_us : 1;
+
+	printf("%lu ops, %llu bytes in %llu us (", res->ops, bytes,
+	       res->total_us);
+	print_size(div64_u64(bytes * 1000000, us), "/s");
+	printf(", %llu IOPS)\n", div64_u64((u64)res->ops * 1000000, us));
+	printf("latency us: min %lu avg %llu max %lu\n", res->min_us,
+	       div_u64(res->total_us, res->ops), res->max_us);
+}
+
+static int do_blkbench(struct cmd_tbl *cmdtp, int flag, int argc,
+		       char *const argv[])
+{
+#if CONFIG_IS_ENABLED(BLOCK_CACHE)
+	struct block_cache_stats stats;
+#endif
+	struct blkbench_result res;
+	struct blk_desc *desc;
+	lbaint_t start, count, xfer;
+	bool write, random, nocache = false;
+	void *buf;
+	int ret;
+
+	if (argc < 8 || argc > 9)
+		return CMD_RET_USAGE;
+
+	if (!strcmp(argv[3], "read"))
+		write = false;
+	else if (!strcmp(argv[3], "write"))
+		write = true;
+	else
+		return CMD_RET_USAGE;
+
+	if (!strcmp(argv[4], "seq"))
+		random = false;
+	else if (!strcmp(argv[4], "rand"))
+		random = true;
+	else
+		return CMD_RET_USAGE;
+
+	if (argc == 9) {
+		if (strcmp(argv[8], "nocache"))
+			return CMD_RET_USAGE;
+		nocache = true;
+	}
+
+	start = simple_strtoul(argv[5], NULL, 16);
+	count = simple_strtoul(argv[6], NULL, 16);
+	xfer = simple_strtoul(argv[7], NULL, 16);
+	if (!xfer || count < xfer)
+		return CMD_RET_USAGE;
+
+	if (blk_get_device_by_str(argv[1], argv[2], &desc) < 0)
+		return CMD_RET_FAILURE;
+
+	if (start + count > desc->lba) {
+		printf("range exceeds device size (" LBAFU " blocks)\n",
+		       desc->lba);
+		return CMD_RET_FAILURE;
+	}
+
+	buf = memalign(ARCH_DMA_MINALIGN, xfer * desc->blksz);
+	if (!buf) {
+		printf("cannot allocate " LBAFU " byte buffer\n",
+		       xfer * desc->blksz);
+		return CMD_RET_FAILURE;
+	}
+	memset(buf, 0xa5, xfer * desc->blksz);
+
+	printf("%s %s: %s %s, " LBAFU " blocks of %lu bytes per op, range 0x"
+	       LBAF "+0x" LBAF "%s\n", argv[1], argv[2],
+	       random ? "random" : "sequential", write ? "write" : "read",
+	       xfer, desc->blksz, start, count, nocache ? ", no cache" : "");
+
+#if CONFIG_IS_ENABLED(BLOCK_CACHE)
+	if (nocache) {
+		/* a zero-sized read limit makes every access bypass it */
+		blkcache_stats(&stats);
+		blkcache_configure(0, stats.size_kb, 0);
+	}
+#endif
+
+	ret = blkbench_run(desc, write, random, start, count, xfer, buf, &res);
+
+#if CONFIG_IS_ENABLED(BLOCK_CACHE)
+	if (nocache)
+		blkcache_configure(stats.max_blocks_per_entry, stats.size_kb,
+				   stats.max_readahead);
+#endif
+
+	if (res.ops)
+		blkbench_report(desc, xfer, &res);
+	free(buf);
+
+	return ret ? CMD_RET_FAILURE : CMD_RET_SUCCESS;
+}
+
+U_BOOT_CMD(
+	blkbench, 9, 0, do_blkbench,
+	"measure block device throughput and latency",
+	"<interface> <dev[.hwpart]> <read|write> <seq|rand> <start> <count> <xfer> [nocache]\n"
+	"    - issue count/xfer transfers of xfer blocks within the range of\n"
+	"      count blocks from block start (all hexadecimal), sequentially\n"
+	"      or at random offsets, and report MB/s, IOPS and latency.\n"
+	"      'nocache' bypasses the block cache.\n"
+	"      WARNING: 'write' overwrites the data in the range."
+);
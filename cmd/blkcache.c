@@ -18,32 +18,43 @@ static int blkc_show(struct cmd_tbl *cmdtp, int flag,
 
 	printf("hits: %u\n"
 	       "misses: %u\n"
+	       "evictions: %u\n"
+	       "readahead blocks: %u\n"
 	       "entries: %u\n"
-	       "max blocks/entry: %u\n"
-	       "max cache entries: %u\n",
-	       stats.hits, stats.misses, stats.entries,
-	       stats.max_blocks_per_entry, stats.max_entries);
+	       "size: %lu of %u KiB\n"
+	       "max blocks/read: %u\n"
+	       "max readahead: %u\n",
+	       stats.hits, stats.misses, stats.evictions, stats.readahead,
+	       stats.entries, stats.bytes >> 10, stats.size_kb,
+	       stats.max_blocks_per_entry, stats.max_readahead);
 	return 0;
 }
 
 static int blkc_configure(struct cmd_tbl *cmdtp, int flag,
 			  int argc, char *const argv[])
 {
-	unsigned blocks_per_entry, max_entries;
-	if (argc != 3)
+	struct block_cache_stats stats;
+	unsigned blocks_per_entry, size_kb, readahead;
+	if (argc != 3 && argc != 4)
 		return CMD_RET_USAGE;
 
 	blocks_per_entry = simple_strtoul(argv[1], 0, 0);
-	max_entries = simple_strtoul(argv[2], 0, 0);
-	blkcache_configure(blocks_per_entry, max_entries);
-	printf("changed to max of %u entries of %u blocks each\n",
-	       max_entries, blocks_per_entry);
+	size_kb = simple_strtoul(argv[2], 0, 0);
+	if (argc == 4) {
+		readahead = simple_strtoul(argv[3], 0, 0);
+	} else {
+		blkcache_stats(&stats);
+		readahead = stats.max_readahead;
+	}
+	blkcache_configure(blocks_per_entry, size_kb, readahead);
+	printf("changed to %u KiB, reads of up to %u blocks, readahead %u\n",
+	       size_kb, blocks_per_entry, readahead);
 	return 0;
 }
 
 static struct cmd_tbl cmd_blkc_sub[] = {
 	U_BOOT_CMD_MKENT(show, 0, 0, blkc_show, "", ""),
-	U_BOOT_CMD_MKENT(configure, 3, 0, blkc_configure, "", ""),
+	U_BOOT_CMD_MKENT(configure, 4, 0, blkc_configure, "", ""),
 };
 
 static __maybe_unused void blkc_reloc(void)
@@ -80,8 +91,8 @@ static int do_blkcache(struct cmd_tbl *cmdtp, int flag,
 }
 
 U_BOOT_CMD(
-	blkcache, 4, 0, do_blkcache,
+	blkcache, 5, 0, do_blkcache,
 	"block cache diagnostics and control",
 	"show - show and reset statistics\n"
-	"blkcache configure blocks entries\n"
+	"blkcache configure blocks size_kb [readahead]\n"
 );
@@ -47,6 +47,36 @@ static int do_save_wrapper(struct cmd_tbl *cmdtp, int flag, int argc,
 	return do_save(cmdtp, flag, argc, argv, FS_TYPE_ANY);
 }
 
+#ifdef CONFIG_CMD_ZLOAD
+U_BOOT_CMD(
+	zload,	6,	0,	do_zload,
+	"load and decompress a gzip file from a filesystem",
+	"<interface> <dev[:part]> <addr> <filename> [max_size]\n"
+	"    - Read gzip-compressed file 'filename' from partition 'part' on\n"
+	"      device type 'interface' instance 'dev' and decompress it to\n"
+	"      address 'addr' while it is being read, without staging the\n"
+	"      compressed file in memory. 'max_size' limits the size of the\n"
+	"      decompressed data and defaults to the free memory at 'addr'.\n"
+	"      $filesize is set to the decompressed size."
+);
+#endif
+
+#ifdef CONFIG_CMD_IMGLOAD
+U_BOOT_CMD(
+	imgload,	5,	0,	do_imgload,
+	"load a kernel image so that it can run in place",
+	"<interface> <dev[:part]> <filename> [addr]\n"
+	"    - Read legacy or FIT image 'filename' from partition 'part' on\n"
+	"      device type 'interface' instance 'dev' to the address that puts\n"
+	"      its uncompressed kernel on the kernel's load address, so that\n"
+	"      bootm does not have to move it. A FIT must keep its data\n"
+	"      external (mkimage -E); the kernel of its default configuration\n"
+	"      is used. Other images, or a kernel whose placement would\n"
+	"      overwrite reserved memory, are read to 'addr' (default\n"
+	"      $loadaddr). $fileaddr and $filesize are set."
+);
+#endif
+
 U_BOOT_CMD(
 	save,	7,	0,	do_save_wrapper,
 	"save file to a filesystem",
@@ -16,16 +16,21 @@
 #include <cli.h>
 #include <command.h>
 #include <console.h>
+#include <cpu_func.h>
 #include <flash.h>
 #include <hash.h>
 #include <log.h>
 #include <mapmem.h>
 #include <rand.h>
 #include <watchdog.h>
+#include <asm/cache.h>
 #include <asm/io.h>
 #include <linux/bitops.h>
 #include <linux/compiler.h>
 #include <linux/delay.h>
+#include <linux/kernel.h>
+#include <linux/math64.h>
+#include <linux/sizes.h>
 
 DECLARE_GLOBAL_DATA_PTR;
 
@@ -926,10 +931,124 @@ static ulong mem_test_quick(vu_long *buf, ulong start_addr, ulong end_addr,
 	return errs;
 }
 
+/*
+ * The fast test moves whole cache lines, eight 64-bit words at a time, so
+ * the range is trimmed to cache line boundaries. Watchdog and ctrl-c are
+ * only polled once per chunk to keep them out of the inner loops.
+ */
+#define MEM_TEST_FAST_ALIGN	max(64, ARCH_DMA_MINALIGN)
+#define MEM_TEST_FAST_CHUNK	SZ_1M
+
+static noinline void mem_test_fast_write(u64 *buf, ulong len, u64 addr,
+					 u64 seed)
+{
+	u64 *end = buf + len / sizeof(u64);
+	u64 *p;
+
+	for (p = buf; p < end; p += 8, addr += 64) {
+		p[0] = seed ^ addr;
+		p[1] = seed ^ (addr + 8);
+		p[2] = seed ^ (addr + 16);
+		p[3] = seed ^ (addr + 24);
+		p[4] = seed ^ (addr + 32);
+		p[5] = seed ^ (addr + 40);
+		p[6] = seed ^ (addr + 48);
+		p[7] = seed ^ (addr + 56);
+	}
+}
+
+static noinline ulong mem_test_fast_check(u64 *buf, ulong len, u64 addr,
+					  u64 seed)
+{
+	u64 *end = buf + len / sizeof(u64);
+	ulong errs = 0;
+	u64 diff, val;
+	u64 *p;
+	int i;
+
+	for (p = buf; p < end; p += 8, addr += 64) {
+		diff = (p[0] ^ seed ^ addr) |
+		       (p[1] ^ seed ^ (addr + 8)) |
+		       (p[2] ^ seed ^ (addr + 16)) |
+		       (p[3] ^ seed ^ (addr + 24)) |
+		       (p[4] ^ seed ^ (addr + 32)) |
+		       (p[5] ^ seed ^ (addr + 40)) |
+		       (p[6] ^ seed ^ (addr + 48)) |
+		       (p[7] ^ seed ^ (addr + 56));
+		if (likely(!diff))
+			continue;
+
+		/* find out which words of the line are wrong */
+		for (i = 0; i < 8; i++) {
+			val = ((volatile u64 *)p)[i];
+			if (val == (seed ^ (addr + i * 8)))
+				continue;
+			printf("\nMem error @ 0x%08llX: found %016llX, expected %016llX\n",
+			       addr + i * 8, val, seed ^ (addr + i * 8));
+			errs++;
+		}
+	}
+
+	return errs;
+}
+
+/*
+ * Fill the range with each word's own address XORed with a seed, then
+ * read it all back. Odd iterations invert the seed, so every bit is
+ * tested with both values, and the seed rotates from one pair of
+ * iterations to the next. Writing the whole range before reading any of
+ * it, and flushing the data cache in between, makes sure the data
+ * really went through the DRAM.
+ */
+static ulong mem_test_fast(void *buf, ulong start_addr, ulong end_addr,
+			   ulong pattern, int iteration, u64 *tested)
+{
+	ulong len = end_addr - start_addr;
+	int rot = iteration / 2 % 64;
+	ulong errs = 0;
+	ulong off, n;
+	u64 seed;
+
+	seed = (u64)pattern << 32 | (u32)pattern;
+	if (rot)
+		seed = seed << rot | seed >> (64 - rot);
+	if (iteration & 1)
+		seed = ~seed;
+
+	printf("\rPattern %016llX  Writing..."
+	       "%12s"
+	       "\b\b\b\b\b\b\b\b\b\b",
+	       seed, "");
+
+	for (off = 0; off < len; off += n) {
+		n = min(len - off, (ulong)MEM_TEST_FAST_CHUNK);
+		WATCHDOG_RESET();
+		mem_test_fast_write(buf + off, n, start_addr + off, seed);
+		if (ctrlc())
+			return -1;
+	}
+	flush_dcache_range((ulong)buf, (ulong)buf + len);
+
+	puts("Reading...");
+
+	for (off = 0; off < len; off += n) {
+		n = min(len - off, (ulong)MEM_TEST_FAST_CHUNK);
+		WATCHDOG_RESET();
+		errs += mem_test_fast_check(buf + off, n, start_addr + off,
+					    seed);
+		if (ctrlc())
+			return -1;
+	}
+	*tested += len;
+
+	return errs;
+}
+
 /*
  * Perform a memory test. A more complete alternative test can be
- * configured using CONFIG_SYS_ALT_MEMTEST. The complete test loops until
- * interrupted by ctrl-c or by a failure of one of the sub-tests.
+ * configured using CONFIG_SYS_ALT_MEMTEST, a faster one is selected
+ * with -f. The complete test loops until interrupted by ctrl-c or by a
+ * failure of one of the sub-tests.
  */
 static int do_mem_mtest(struct cmd_tbl *cmdtp, int flag, int argc,
 			char *const argv[])
@@ -941,11 +1060,20 @@ static int do_mem_mtest(struct cmd_tbl *cmdtp, int flag, int argc,
 	ulong count = 0;
 	ulong errs = 0;	/* number of errors, or -1 if interrupted */
 	ulong pattern = 0;
+	u64 tested = 0;
+	bool fast = false;
+	ulong time;
 	int iteration;
 
 	start = CONFIG_SYS_MEMTEST_START;
 	end = CONFIG_SYS_MEMTEST_END;
 
+	if (argc > 1 && !strcmp(argv[1], "-f")) {
+		fast = true;
+		argc--;
+		argv++;
+	}
+
 	if (argc > 1)
 		if (strict_strtoul(argv[1], 16, &start) < 0)
 			return CMD_RET_USAGE;
@@ -967,10 +1095,20 @@ static int do_mem_mtest(struct cmd_tbl *cmdtp, int flag, int argc,
 		return -1;
 	}
 
+	if (fast) {
+		start = ALIGN(start, MEM_TEST_FAST_ALIGN);
+		end = ALIGN_DOWN(end, MEM_TEST_FAST_ALIGN);
+		if (end <= start) {
+			printf("Refusing to do empty test\n");
+			return -1;
+		}
+	}
+
 	printf("Testing %08lx ... %08lx:\n", start, end);
 	debug("%s:%d: start %#08lx end %#08lx\n", __func__, __LINE__,
 	      start, end);
 
+	time = get_timer(0);
 	buf = map_sysmem(start, end - start);
 	for (iteration = 0;
 			!iteration_limit || iteration < iteration_limit;
@@ -982,7 +1120,10 @@ static int do_mem_mtest(struct cmd_tbl *cmdtp, int flag, int argc,
 
 		printf("Iteration: %6d\r", iteration + 1);
 		debug("\n");
-		if (IS_ENABLED(CONFIG_SYS_ALT_MEMTEST)) {
+		if (fast) {
+			errs = mem_test_fast((void *)buf, start, end, pattern,
+					     iteration, &tested);
+		} else if (IS_ENABLED(CONFIG_SYS_ALT_MEMTEST)) {
 			errs = mem_test_alt(buf, start, end, dummy);
 			if (errs == -1UL)
 				break;
@@ -1007,6 +1148,12 @@ static int do_mem_mtest(struct cmd_tbl *cmdtp, int flag, int argc,
 		putc('\n');
 	}
 	printf("Tested %d iteration(s) with %lu errors.\n", iteration, count);
+	if (tested) {
+		time = get_timer(time);
+		printf("%llu MiB tested in %lu ms (%llu MiB/s)\n",
+		       tested >> 20, time,
+		       div64_u64(tested * 1000, (u64)(time ? time : 1) << 20));
+	}
 
 	return errs != 0;
 }
@@ -1320,9 +1467,10 @@ U_BOOT_CMD(
 
 #ifdef CONFIG_CMD_MEMTEST
 U_BOOT_CMD(
-	mtest,	5,	1,	do_mem_mtest,
+	mtest,	6,	1,	do_mem_mtest,
 	"simple RAM read/write test",
-	"[start [end [pattern [iterations]]]]"
+	"[-f] [start [end [pattern [iterations]]]]\n"
+	"    -f: fast test of whole cache lines, reports the throughput"
 );
 #endif	/* CONFIG_CMD_MEMTEST */
 
@@ -0,0 +1,135 @@
+// SPDX-License-Identifier: GPL-2.0+
+/*
+ * memcpy/memmove/memset throughput benchmark
+ */
+
+#include <common.h>
+#include <command.h>
+#include <console.h>
+#include <display_options.h>
+#include <mapmem.h>
+#include <time.h>
+#include <linux/math64.h>
+#include <linux/sizes.h>
+
+enum membench_op {
+	MEMBENCH_COPY,
+	MEMBENCH_MOVE,
+	MEMBENCH_SET,
+};
+
+struct membench_test {
+	const char *name;
+	enum membench_op op;
+	int dst_off;
+	int src_off;
+	int val;
+};
+
+/*
+ * The buffer holds the source at offset 0 and the destination at offset
+ * size + 64; memmove copies the source onto itself, 8 bytes higher.
+ */
+static const struct membench_test membench_tests[] = {
+	{ "memcpy",		MEMBENCH_COPY,	64,	0 },
+	{ "memcpy unaligned",	MEMBENCH_COPY,	67,	1 },
+	{ "memmove overlap",	MEMBENCH_MOVE,	8,	0 },
+	{ "memset 0",		MEMBENCH_SET,	64,	0,	0 },
+	{ "memset 0xa5",	MEMBENCH_SET,	64,	0,	0xa5 },
+};
+
+static ulong membench_run(const struct membench_test *test, bool generic,
+			  void *buf, ulong size, ulong loops)
+{
+	void *src = buf + test->src_off;
+	void *dst = buf + test->dst_off;
+	ulong i, start;
+
+	if (test->op != MEMBENCH_MOVE)
+		dst += size;
+
+	start = timer_get_us();
+	for (i = 0; i < loops; i++) {
+		switch (test->op) {
+		case MEMBENCH_COPY:
+			if (generic)
+				generic_memcpy(dst, src, size);
+			else
+				memcpy(dst, src, size);
+			break;
+		case MEMBENCH_MOVE:
+			if (generic)
+				generic_memmove(dst, src, size);
+			else
+				memmove(dst, src, size);
+			break;
+		case MEMBENCH_SET:
+			if (generic)
+				generic_memset(dst, test->val, size);
+			else
+				memset(dst, test->val, size);
+			break;
+		}
+	}
+
+	return timer_get_us() - start;
+}
+
+static void membench_report(u64 bytes, ulong us)
+{
+	printf("%11llu MiB/s",
+	       div64_u64(bytes * 1000000, (u64)(us ? us : 1) * SZ_1M));
+}
+
+static int do_membench(struct cmd_tbl *cmdtp, int flag, int argc,
+		       char *const argv[])
+{
+	ulong addr, size, loops = 10;
+	ulong us_arch, us_gen;
+	void *buf;
+	int i;
+
+	if (argc < 3 || argc > 4)
+		return CMD_RET_USAGE;
+
+	addr = simple_strtoul(argv[1], NULL, 16);
+	size = simple_strtoul(argv[2], NULL, 16);
+	if (argc > 3)
+		loops = simple_strtoul(argv[3], NULL, 10);
+	if (!size || !loops)
+		return CMD_RET_USAGE;
+
+	buf = map_sysmem(addr, 2 * size + 128);
+	printf("%lu x ", loops);
+	print_size(size, "");
+	printf(", buffer at %08lx..%08lx\n", addr, addr + 2 * size + 128);
+	printf("%-20s%17s%17s\n", "", "arch", "generic");
+
+	for (i = 0; i < ARRAY_SIZE(membench_tests); i++) {
+		const struct membench_test *test = &membench_tests[i];
+		u64 bytes = (u64)size * loops;
+
+		us_arch = membench_run(test, false, buf, size, loops);
+		us_gen = membench_run(test, true, buf, size, loops);
+		printf("%-20s", test->name);
+		membench_report(bytes, us_arch);
+		membench_report(bytes, us_gen);
+		printf("\n");
+
+		if (ctrlc())
+			break;
+	}
+	unmap_sysmem(buf);
+
+	return CMD_RET_SUCCESS;
+}
+
+U_BOOT_CMD(
+	membench, 4, 0, do_membench,
+	"compare memcpy/memmove/memset with the generic C versions",
+	"<addr> <size> [loops]\n"
+	"    - time 'loops' (default 10) calls of each function on 'size'\n"
+	"      bytes (hexadecimal), using 2 * size + 128 bytes of scratch\n"
+	"      memory at 'addr', and print the throughput of the\n"
+	"      architecture's implementation next to the generic one."
+);
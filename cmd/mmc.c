@@ -8,8 +8,11 @@
 #include <blk.h>
 #include <command.h>
 #include <console.h>
+#include <display_options.h>
 #include <mmc.h>
 #include <part.h>
+#include <time.h>
+#include <linux/math64.h>
 #include <sparse_format.h>
 #include <image-sparse.h>
 
@@ -349,6 +352,65 @@ static int do_mmc_read(struct cmd_tbl *cmdtp, int flag,
 	return (n == cnt) ? CMD_RET_SUCCESS : CMD_RET_FAILURE;
 }
 
+#ifdef CONFIG_CMD_MMC_BENCH
+static int do_mmc_bench(struct cmd_tbl *cmdtp, int flag,
+			int argc, char *const argv[])
+{
+	struct blk_desc *desc;
+	struct mmc *mmc;
+	u32 blk, cnt, loops = 1, i;
+	ulong time;
+	u64 bytes;
+	void *addr;
+
+	if (argc < 4 || argc > 5)
+		return CMD_RET_USAGE;
+
+	addr = (void *)simple_strtoul(argv[1], NULL, 16);
+	blk = simple_strtoul(argv[2], NULL, 16);
+	cnt = simple_strtoul(argv[3], NULL, 16);
+	if (argc == 5)
+		loops = simple_strtoul(argv[4], NULL, 10);
+	if (!cnt || !loops)
+		return CMD_RET_USAGE;
+
+	mmc = init_mmc_device(curr_device, false);
+	if (!mmc)
+		return CMD_RET_FAILURE;
+	desc = mmc_get_blk_desc(mmc);
+
+	printf("MMC bench: dev # %d, block # %d, count %d, %d loop(s), "
+	       "max %d blocks per command, CMD23 %s\n", curr_device, blk, cnt,
+	       loops, mmc->cfg->b_max,
+	       (mmc->card_caps & mmc->host_caps & MMC_CAP_CMD23) ?
+	       "on" : "off");
+
+	time = get_timer(0);
+	for (i = 0; i < loops; i++) {
+		/* measure the device, not the block cache */
+		blkcache_invalidate(desc->if_type, desc->devnum);
+		if (blk_dread(desc, blk, cnt, addr) != cnt) {
+			printf("read error\n");
+			return CMD_RET_FAILURE;
+		}
+		if (ctrlc())
+			return CMD_RET_FAILURE;
+	}
+	time = get_timer(time);
+
+	bytes = (u64)cnt * desc->blksz * loops;
+	printf("%llu bytes read in %lu ms", bytes, time);
+	if (time > 0) {
+		puts(" (");
+		print_size(div_u64(bytes, time) * 1000, "/s");
+		puts(")");
+	}
+	puts("\n");
+
+	return CMD_RET_SUCCESS;
+}
+#endif
+
 #if CONFIG_IS_ENABLED(CMD_MMC_SWRITE)
 static lbaint_t mmc_sparse_write(struct sparse_storage *info, lbaint_t blk,
 				 lbaint_t blkcnt, const void *buffer)
@@ -933,6 +995,9 @@ static int do_mmc_boot_wp(struct cmd_tbl *cmdtp, int flag,
 static struct cmd_tbl cmd_mmc[] = {
 	U_BOOT_CMD_MKENT(info, 1, 0, do_mmcinfo, "", ""),
 	U_BOOT_CMD_MKENT(read, 4, 1, do_mmc_read, "", ""),
+#ifdef CONFIG_CMD_MMC_BENCH
+	U_BOOT_CMD_MKENT(bench, 5, 0, do_mmc_bench, "", ""),
+#endif
 	U_BOOT_CMD_MKENT(wp, 1, 0, do_mmc_boot_wp, "", ""),
 #if CONFIG_IS_ENABLED(MMC_WRITE)
 	U_BOOT_CMD_MKENT(write, 4, 0, do_mmc_write, "", ""),
@@ -996,6 +1061,9 @@ U_BOOT_CMD(
 	"info - display info of the current MMC device\n"
 	"mmc read addr blk# cnt\n"
 	"mmc write addr blk# cnt\n"
+#ifdef CONFIG_CMD_MMC_BENCH
+	"mmc bench addr blk# cnt [loops] - measure read throughput\n"
+#endif
 #if CONFIG_IS_ENABLED(CMD_MMC_SWRITE)
 	"mmc swrite addr blk#\n"
 #endif
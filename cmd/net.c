@@ -13,6 +13,8 @@
 #include <env.h>
 #include <image.h>
 #include <net.h>
+#include <part.h>
+#include <net/wget.h>
 
 static int netboot_common(enum proto_t, struct cmd_tbl *, int, char * const []);
 
@@ -121,6 +123,53 @@ U_BOOT_CMD(
 );
 #endif
 
+#if defined(CONFIG_CMD_WGET)
+static int do_wget(struct cmd_tbl *cmdtp, int flag, int argc,
+		   char *const argv[])
+{
+	struct disk_partition info;
+	struct blk_desc *desc;
+	int ret;
+
+	if (argc < 2 || strcmp(argv[1], "-b")) {
+		if (argc > 3)
+			return CMD_RET_USAGE;
+		return netboot_common(WGET, cmdtp, argc, argv);
+	}
+
+	/* stream onto a block device rather than into memory */
+	if (argc < 4 || argc > 5)
+		return CMD_RET_USAGE;
+	if (blk_get_device_part_str(argv[2], argv[3], &desc, &info, 1) < 0)
+		return CMD_RET_FAILURE;
+	if (!desc) {
+		printf("** %s is not a block device **\n", argv[2]);
+		return CMD_RET_FAILURE;
+	}
+
+	net_boot_file_name_explicit = argc == 5;
+	copy_filename(net_boot_file_name,
+		      argc == 5 ? argv[4] : env_get("bootfile"),
+		      sizeof(net_boot_file_name));
+
+	wget_set_blk(desc, info.start, info.size);
+	ret = net_loop(WGET);
+	wget_set_blk(NULL, 0, 0);
+
+	return ret < 0 ? CMD_RET_FAILURE : CMD_RET_SUCCESS;
+}
+
+U_BOOT_CMD(
+	wget,	5,	1,	do_wget,
+	"load a file via network using HTTP",
+	"[loadAddress] [[hostIPaddr:]path]\n"
+	"    - load the file into memory at loadAddress\n"
+	"wget -b <interface> <dev[:part]> [[hostIPaddr:]path]\n"
+	"    - write the file to the device or partition, from its first block\n"
+	"The server port is 80 unless set in 'httpdstp'."
+);
+#endif
+
 static void netboot_update_env(void)
 {
 	char tmp[22];
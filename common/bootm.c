@@ -63,14 +63,41 @@ static void boot_start_lmb(bootm_headers_t *images)
 	lmb_init_and_reserve_range(&images->lmb, (phys_addr_t)mem_start,
 				   mem_size, NULL);
 }
+
+/**
+ * bootm_free_size() - Get the space available to load the OS to
+ *
+ * @images: Images information
+ * @load: Load address of the OS
+ * @return number of bytes from @load up to the next reserved region, 0 if
+ *	@load itself is reserved, ~0 if @load is outside the memory known to
+ *	lmb and cannot be checked
+ */
+static phys_size_t bootm_free_size(bootm_headers_t *images, ulong load)
+{
+	phys_size_t size = lmb_get_free_size(&images->lmb, load);
+
+	if (!size && !lmb_is_reserved(&images->lmb, load))
+		return ~(phys_size_t)0;
+
+	return size;
+}
 #else
 #define lmb_reserve(lmb, base, size)
 static inline void boot_start_lmb(bootm_headers_t *images) { }
+static inline phys_size_t bootm_free_size(bootm_headers_t *images, ulong load)
+{
+	return ~(phys_size_t)0;
+}
 #endif
 
 static int bootm_start(struct cmd_tbl *cmdtp, int flag, int argc,
 		       char *const argv[])
 {
+#ifdef CONFIG_LMB
+	/* release the regions a previous bootm moved to the heap */
+	lmb_uninit(&images.lmb);
+#endif
 	memset((void *)&images, 0, sizeof(images));
 	images.verify = env_get_yesno("verify");
 
@@ -351,15 +378,33 @@ static int bootm_load_os(bootm_headers_t *images, int boot_progress)
 	ulong image_start = os.image_start;
 	ulong image_len = os.image_len;
 	ulong flush_start = ALIGN_DOWN(load, ARCH_DMA_MINALIGN);
+	ulong unc_len = CONFIG_SYS_BOOTM_LEN;
+	phys_size_t free_size;
 	bool no_overlap;
 	void *load_buf, *image_buf;
 	int err;
 
+	/*
+	 * An uncompressed OS already sitting at its load address runs in
+	 * place. Otherwise it is copied or decompressed to the load address,
+	 * which must not clobber memory reserved for U-Boot, the device tree
+	 * and the like, so limit the output to the free space there.
+	 */
+	if (os.comp != IH_COMP_NONE || load != image_start) {
+		free_size = bootm_free_size(images, load);
+		if (free_size < (os.comp == IH_COMP_NONE ? image_len : 1)) {
+			printf("ERROR: loading the OS to %08lx would overwrite reserved memory\n",
+			       load);
+			return -ENOSPC;
+		}
+		if (free_size < unc_len)
+			unc_len = free_size;
+	}
+
 	load_buf = map_sysmem(load, 0);
 	image_buf = map_sysmem(os.image_start, image_len);
 	err = image_decomp(os.comp, load, os.image_start, os.type,
-			   load_buf, image_buf, image_len,
-			   CONFIG_SYS_BOOTM_LEN, &load_end);
+			   load_buf, image_buf, image_len, unc_len, &load_end);
 	if (err) {
 		err = handle_decomp_error(os.comp, load_end - load, err);
 		bootstage_error(BOOTSTAGE_ID_DECOMP_IMAGE);
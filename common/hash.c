@@ -31,6 +31,8 @@
 #include <u-boot/crc.h>
 #include <u-boot/sha1.h>
 #include <u-boot/sha256.h>
+#include <u-boot/sha512.h>
+#include <u-boot/blake2b.h>
 #include <u-boot/md5.h>
 
 #if !defined(USE_HOSTCC) && defined(CONFIG_NEEDS_MANUAL_RELOC)
@@ -95,6 +97,84 @@ static int hash_finish_sha256(struct hash_algo *algo, void *ctx, void
 }
 #endif
 
+#if defined(CONFIG_SHA384)
+static int hash_init_sha384(struct hash_algo *algo, void **ctxp)
+{
+	sha512_context *ctx = malloc(sizeof(sha512_context));
+	sha384_starts(ctx);
+	*ctxp = ctx;
+	return 0;
+}
+
+static int hash_finish_sha384(struct hash_algo *algo, void *ctx, void
+			      *dest_buf, int size)
+{
+	if (size < algo->digest_size)
+		return -1;
+
+	sha384_finish((sha512_context *)ctx, dest_buf);
+	free(ctx);
+	return 0;
+}
+#endif
+
+#if defined(CONFIG_SHA512)
+static int hash_init_sha512(struct hash_algo *algo, void **ctxp)
+{
+	sha512_context *ctx = malloc(sizeof(sha512_context));
+	sha512_starts(ctx);
+	*ctxp = ctx;
+	return 0;
+}
+
+/* SHA-384 shares the SHA-512 context and update function */
+static int hash_update_sha512(struct hash_algo *algo, void *ctx,
+			      const void *buf, unsigned int size, int is_last)
+{
+	sha512_update((sha512_context *)ctx, buf, size);
+	return 0;
+}
+
+static int hash_finish_sha512(struct hash_algo *algo, void *ctx, void
+			      *dest_buf, int size)
+{
+	if (size < algo->digest_size)
+		return -1;
+
+	sha512_finish((sha512_context *)ctx, dest_buf);
+	free(ctx);
+	return 0;
+}
+#endif
+
+#if defined(CONFIG_BLAKE2B)
+static int hash_init_blake2b(struct hash_algo *algo, void **ctxp)
+{
+	blake2b_context *ctx = malloc(sizeof(blake2b_context));
+	blake2b_starts(ctx);
+	*ctxp = ctx;
+	return 0;
+}
+
+static int hash_update_blake2b(struct hash_algo *algo, void *ctx,
+			       const void *buf, unsigned int size, int is_last)
+{
+	blake2b_update((blake2b_context *)ctx, buf, size);
+	return 0;
+}
+
+static int hash_finish_blake2b(struct hash_algo *algo, void *ctx, void
+			       *dest_buf, int size)
+{
+	if (size < algo->digest_size)
+		return -1;
+
+	blake2b_finish((blake2b_context *)ctx, dest_buf);
+	free(ctx);
+	return 0;
+}
+#endif
+
 static int hash_init_crc16_ccitt(struct hash_algo *algo, void **ctxp)
 {
 	uint16_t *ctx = malloc(sizeof(uint16_t));
@@ -195,6 +275,39 @@ static struct hash_algo hash_algo[] = {
 		.hash_finish	= hash_finish_sha256,
 #endif
 	},
+#endif
+#ifdef CONFIG_SHA384
+	{
+		.name		= "sha384",
+		.digest_size	= SHA384_SUM_LEN,
+		.chunk_size	= CHUNKSZ_SHA384,
+		.hash_func_ws	= sha384_csum_wd,
+		.hash_init	= hash_init_sha384,
+		.hash_update	= hash_update_sha512,
+		.hash_finish	= hash_finish_sha384,
+	},
+#endif
+#ifdef CONFIG_SHA512
+	{
+		.name		= "sha512",
+		.digest_size	= SHA512_SUM_LEN,
+		.chunk_size	= CHUNKSZ_SHA512,
+		.hash_func_ws	= sha512_csum_wd,
+		.hash_init	= hash_init_sha512,
+		.hash_update	= hash_update_sha512,
+		.hash_finish	= hash_finish_sha512,
+	},
+#endif
+#ifdef CONFIG_BLAKE2B
+	{
+		.name		= "blake2b",
+		.digest_size	= BLAKE2B_SUM_LEN,
+		.chunk_size	= CHUNKSZ_BLAKE2B,
+		.hash_func_ws	= blake2b_csum_wd,
+		.hash_init	= hash_init_blake2b,
+		.hash_update	= hash_update_blake2b,
+		.hash_finish	= hash_finish_blake2b,
+	},
 #endif
 	{
 		.name		= "crc16-ccitt",
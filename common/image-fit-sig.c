@@ -16,9 +16,15 @@ DECLARE_GLOBAL_DATA_PTR;
 #include <image.h>
 #include <u-boot/rsa.h>
 #include <u-boot/rsa-checksum.h>
+#ifndef USE_HOSTCC
+#include <bootstage.h>
+#endif
 
 #define IMAGE_MAX_HASHED_NODES		100
 
+/* Number of verified configuration signatures to remember */
+#define FIT_SIG_CACHE_SIZE		4
+
 #ifdef USE_HOSTCC
 void *host_blob;
 
@@ -119,11 +125,41 @@ static int fit_image_setup_verify(struct image_sign_info *info,
 	return 0;
 }
 
+/*
+ * Image signatures cover a single region, the image data, which has often
+ * been hashed already by a hash node or by another signature node.
+ */
+static int fit_image_calculate_digest(const char *name,
+				      const struct image_region region[],
+				      int region_count, uint8_t *checksum)
+{
+	struct hash_algo *algo;
+	int ret;
+
+	if (region_count == 1 &&
+	    !fit_digest_lookup(region->data, region->size, name, checksum,
+			       NULL)) {
+		debug("%s: reusing %s digest\n", __func__, name);
+		return 0;
+	}
+
+	ret = hash_calculate(name, region, region_count, checksum);
+	if (ret || region_count != 1)
+		return ret;
+
+	if (!hash_progressive_lookup_algo(name, &algo))
+		fit_digest_store(region->data, region->size, name, checksum,
+				 algo->digest_size);
+
+	return 0;
+}
+
 int fit_image_check_sig(const void *fit, int noffset, const void *data,
 			size_t size, int required_keynode, char **err_msgp)
 {
 	struct image_sign_info info;
 	struct image_region region;
+	struct checksum_algo checksum;
 	uint8_t *fit_value;
 	int fit_value_len;
 
@@ -132,6 +168,12 @@ int fit_image_check_sig(const void *fit, int noffset, const void *data,
 				   err_msgp))
 		return -1;
 
+	if (info.checksum->calculate == hash_calculate) {
+		memcpy(&checksum, info.checksum, sizeof(checksum));
+		checksum.calculate = fit_image_calculate_digest;
+		info.checksum = &checksum;
+	}
+
 	if (fit_image_hash_get_value(fit, noffset, &fit_value,
 				     &fit_value_len)) {
 		*err_msgp = "Can't get hash value property";
@@ -231,6 +273,168 @@ int fit_image_verify_required_sigs(const void *fit, int image_noffset,
 	return 0;
 }
 
+#if defined(CONFIG_FIT_SIGNATURE_CACHE) && !defined(USE_HOSTCC) && \
+	!defined(CONFIG_SPL_BUILD)
+/**
+ * struct fit_sig_cache_entry - a configuration signature known to be good
+ *
+ * @fit:		FIT image
+ * @key_blob:		Device tree holding the key
+ * @conf_noffset:	Configuration node offset in @fit
+ * @sig_noffset:	Signature node offset in @fit
+ * @key_noffset:	Key node offset in @key_blob
+ * @fingerprint:	Hash of the signed regions, signature and key node
+ */
+struct fit_sig_cache_entry {
+	const void *fit;
+	const void *key_blob;
+	int conf_noffset;
+	int sig_noffset;
+	int key_noffset;
+	uint8_t fingerprint[FIT_MAX_HASH_LEN];
+};
+
+static struct fit_sig_cache_entry fit_sig_cache[FIT_SIG_CACHE_SIZE];
+static int fit_sig_cache_next;
+static int fit_sig_cache_hits;
+/* bootstage record name, which carries the hit count */
+static char fit_sig_cache_stage[32] = "fit_sig_cache";
+
+/**
+ * fit_sig_cache_fingerprint() - hash everything a verification depends on
+ *
+ * The signed regions are extended with the signature value and the key
+ * node, so that a change to the FIT, its signature or the key all give a
+ * different fingerprint.
+ *
+ * @info:	Signature information, giving the hash algorithm and key
+ * @region:	Signed regions, with room for two more entries after @count
+ * @count:	Number of signed regions
+ * @sig:	Signature value
+ * @sig_len:	Length of @sig in bytes
+ * @fingerprint: Returns the fingerprint, info->checksum->checksum_len bytes
+ * @return 0 if OK, -ve on error
+ */
+static int fit_sig_cache_fingerprint(const struct image_sign_info *info,
+				     struct image_region region[], int count,
+				     const uint8_t *sig, int sig_len,
+				     uint8_t *fingerprint)
+{
+	const void *blob = info->fdt_blob;
+	int noffset = info->required_keynode;
+	int next, depth = 0;
+
+	/* the key node ends where the next node at its level starts */
+	next = noffset;
+	do
+		next = fdt_next_node(blob, next, &depth);
+	while (next >= 0 && depth > 0);
+	if (next < 0)
+		next = fdt_size_dt_struct(blob);
+
+	region[count].data = sig;
+	region[count].size = sig_len;
+	region[count + 1].data = blob + fdt_off_dt_struct(blob) + noffset;
+	region[count + 1].size = next - noffset;
+
+	return info->checksum->calculate(info->checksum->name, region,
+					 count + 2, fingerprint);
+}
+
+static struct fit_sig_cache_entry *
+fit_sig_cache_find(const struct image_sign_info *info, int conf_noffset,
+		   const uint8_t *fingerprint)
+{
+	struct fit_sig_cache_entry *entry;
+	int i;
+
+	for (i = 0; i < FIT_SIG_CACHE_SIZE; i++) {
+		entry = &fit_sig_cache[i];
+		if (entry->fit == info->fit &&
+		    entry->key_blob == info->fdt_blob &&
+		    entry->conf_noffset == conf_noffset &&
+		    entry->sig_noffset == info->node_offset &&
+		    entry->key_noffset == info->required_keynode &&
+		    !memcmp(entry->fingerprint, fingerprint,
+			    info->checksum->checksum_len))
+			return entry;
+	}
+
+	return NULL;
+}
+
+/**
+ * fit_sig_cache_check() - check whether a signature was verified before
+ *
+ * @info:	Signature information
+ * @conf_noffset: Configuration node offset
+ * @region:	Signed regions, with room for two more entries after @count
+ * @count:	Number of signed regions
+ * @sig:	Signature value
+ * @sig_len:	Length of @sig in bytes
+ * @fingerprint: Returns the fingerprint, for fit_sig_cache_add()
+ * @return 1 if this exact signature was verified already, 0 if not, -ve if
+ * the signature cannot be cached (@fingerprint is not set then)
+ */
+static int fit_sig_cache_check(const struct image_sign_info *info,
+			       int conf_noffset, struct image_region region[],
+			       int count, const uint8_t *sig, int sig_len,
+			       uint8_t *fingerprint)
+{
+	int ret;
+
+	/* .bss is not available before relocation */
+	if (!(gd->flags & GD_FLG_RELOC) || info->required_keynode < 0 ||
+	    info->checksum->checksum_len > FIT_MAX_HASH_LEN)
+		return -EINVAL;
+
+	/* the accumulated time is the overhead of the cache */
+	bootstage_start(BOOTSTAGE_ID_ACCUM_FIT_SIG_CACHE, fit_sig_cache_stage);
+	ret = fit_sig_cache_fingerprint(info, region, count, sig, sig_len,
+					fingerprint);
+	if (!ret && fit_sig_cache_find(info, conf_noffset, fingerprint)) {
+		debug("%s: signature already verified\n", __func__);
+		fit_sig_cache_hits++;
+		snprintf(fit_sig_cache_stage, sizeof(fit_sig_cache_stage),
+			 "fit_sig_cache, %d hit%s", fit_sig_cache_hits,
+			 fit_sig_cache_hits == 1 ? "" : "s");
+		ret = 1;
+	}
+	bootstage_accum(BOOTSTAGE_ID_ACCUM_FIT_SIG_CACHE);
+
+	return ret;
+}
+
+static void fit_sig_cache_add(const struct image_sign_info *info,
+			      int conf_noffset, const uint8_t *fingerprint)
+{
+	struct fit_sig_cache_entry *entry;
+
+	entry = &fit_sig_cache[fit_sig_cache_next];
+	fit_sig_cache_next = (fit_sig_cache_next + 1) % FIT_SIG_CACHE_SIZE;
+
+	entry->fit = info->fit;
+	entry->key_blob = info->fdt_blob;
+	entry->conf_noffset = conf_noffset;
+	entry->sig_noffset = info->node_offset;
+	entry->key_noffset = info->required_keynode;
+	memcpy(entry->fingerprint, fingerprint, info->checksum->checksum_len);
+}
+#else
+static int fit_sig_cache_check(const struct image_sign_info *info,
+			       int conf_noffset, struct image_region region[],
+			       int count, const uint8_t *sig, int sig_len,
+			       uint8_t *fingerprint)
+{
+	return -ENOSYS;
+}
+
+static void fit_sig_cache_add(const struct image_sign_info *info,
+			      int conf_noffset, const uint8_t *fingerprint)
+{
+}
+#endif
+
 /**
  * fit_config_check_sig() - Check the signature of a config
  *
@@ -262,6 +466,7 @@ static int fit_config_check_sig(const void *fit, int noffset,
 	int i, prop_len;
 	char path[200];
 	int count;
+	int cached;
 
 	config_name = fit_get_name(fit, conf_noffset, NULL);
 	debug("%s: fdt=%p, conf='%s', sig='%s'\n", __func__, gd_fdt_blob(),
@@ -357,15 +562,26 @@ static int fit_config_check_sig(const void *fit, int noffset,
 		count++;
 	}
 
-	/* Allocate the region list on the stack */
-	struct image_region region[count];
+	/*
+	 * Allocate the region list on the stack, leaving room for the extra
+	 * regions of the cache fingerprint
+	 */
+	struct image_region region[count + 2];
+	uint8_t fingerprint[FIT_MAX_HASH_LEN];
 
 	fit_region_make_list(fit, fdt_regions, count, region);
+	cached = fit_sig_cache_check(&info, conf_noffset, region, count,
+				     fit_value, fit_value_len, fingerprint);
+	if (cached > 0)
+		return 0;
+
 	if (info.crypto->verify(&info, region, count, fit_value,
 				fit_value_len)) {
 		*err_msgp = "Verification failed";
 		return -1;
 	}
+	if (!cached)
+		fit_sig_cache_add(&info, conf_noffset, fingerprint);
 
 	return 0;
 }
@@ -32,6 +32,8 @@ DECLARE_GLOBAL_DATA_PTR;
 #include <u-boot/md5.h>
 #include <u-boot/sha1.h>
 #include <u-boot/sha256.h>
+#include <u-boot/sha512.h>
+#include <u-boot/blake2b.h>
 
 /*****************************************************************************/
 /* New uImage format routines */
@@ -1206,6 +1208,18 @@ int calculate_hash(const void *data, int data_len, const char *algo,
 		sha256_csum_wd((unsigned char *)data, data_len,
 			       (unsigned char *)value, CHUNKSZ_SHA256);
 		*value_len = SHA256_SUM_LEN;
+	} else if (IMAGE_ENABLE_SHA384 && strcmp(algo, "sha384") == 0) {
+		sha384_csum_wd((unsigned char *)data, data_len,
+			       (unsigned char *)value, CHUNKSZ_SHA384);
+		*value_len = SHA384_SUM_LEN;
+	} else if (IMAGE_ENABLE_SHA512 && strcmp(algo, "sha512") == 0) {
+		sha512_csum_wd((unsigned char *)data, data_len,
+			       (unsigned char *)value, CHUNKSZ_SHA512);
+		*value_len = SHA512_SUM_LEN;
+	} else if (IMAGE_ENABLE_BLAKE2B && strcmp(algo, "blake2b") == 0) {
+		blake2b_csum_wd((unsigned char *)data, data_len,
+				(unsigned char *)value, CHUNKSZ_BLAKE2B);
+		*value_len = BLAKE2B_SUM_LEN;
 	} else if (IMAGE_ENABLE_MD5 && strcmp(algo, "md5") == 0) {
 		md5_wd((unsigned char *)data, data_len, value, CHUNKSZ_MD5);
 		*value_len = 16;
@@ -1216,6 +1230,109 @@ int calculate_hash(const void *data, int data_len, const char *algo,
 	return 0;
 }
 
+/*
+ * Digests computed while verifying a single image. An image node usually
+ * has a hash node and one or more signature nodes over the same data, and
+ * each signature node may be checked once per required key, so keep the
+ * digests around instead of hashing the (possibly huge) data every time.
+ *
+ * Like the signature cache this lives in static data, so it is only used
+ * in U-Boot proper after relocation.
+ */
+#if !defined(USE_HOSTCC) && !defined(CONFIG_SPL_BUILD)
+#define FIT_DIGEST_CACHE_SIZE	4
+
+struct fit_digest {
+	const void *data;
+	size_t size;
+	char algo[16];
+	uint8_t value[FIT_MAX_HASH_LEN];
+	int len;
+};
+
+static struct fit_digest fit_digests[FIT_DIGEST_CACHE_SIZE];
+static int fit_digest_count;
+static bool fit_digest_enabled;
+
+static void fit_digest_cache_start(void)
+{
+	if (!(gd->flags & GD_FLG_RELOC))
+		return;
+
+	fit_digest_count = 0;
+	fit_digest_enabled = true;
+}
+
+static void fit_digest_cache_stop(void)
+{
+	if (!(gd->flags & GD_FLG_RELOC))
+		return;
+
+	fit_digest_count = 0;
+	fit_digest_enabled = false;
+}
+
+int fit_digest_lookup(const void *data, size_t size, const char *algo,
+		      uint8_t *value, int *value_len)
+{
+	struct fit_digest *d;
+	int i;
+
+	if (!(gd->flags & GD_FLG_RELOC) || !fit_digest_enabled)
+		return -ENOENT;
+
+	for (i = 0; i < fit_digest_count; i++) {
+		d = &fit_digests[i];
+		if (d->data == data && d->size == size &&
+		    !strcmp(d->algo, algo)) {
+			memcpy(value, d->value, d->len);
+			if (value_len)
+				*value_len = d->len;
+			return 0;
+		}
+	}
+
+	return -ENOENT;
+}
+
+void fit_digest_store(const void *data, size_t size, const char *algo,
+		      const uint8_t *value, int value_len)
+{
+	struct fit_digest *d;
+
+	if (!(gd->flags & GD_FLG_RELOC) || !fit_digest_enabled ||
+	    fit_digest_count == FIT_DIGEST_CACHE_SIZE ||
+	    strlen(algo) >= sizeof(d->algo) || value_len > FIT_MAX_HASH_LEN)
+		return;
+
+	d = &fit_digests[fit_digest_count++];
+	d->data = data;
+	d->size = size;
+	strcpy(d->algo, algo);
+	memcpy(d->value, value, value_len);
+	d->len = value_len;
+}
+#else
+static void fit_digest_cache_start(void)
+{
+}
+
+static void fit_digest_cache_stop(void)
+{
+}
+
+int fit_digest_lookup(const void *data, size_t size, const char *algo,
+		      uint8_t *value, int *value_len)
+{
+	return -ENOENT;
+}
+
+void fit_digest_store(const void *data, size_t size, const char *algo,
+		      const uint8_t *value, int value_len)
+{
+}
+#endif
+
 static int fit_image_check_hash(const void *fit, int noffset, const void *data,
 				size_t size, char **err_msgp)
 {
@@ -1248,9 +1365,13 @@ static int fit_image_check_hash(const void *fit, int noffset, const void *data,
 		return -1;
 	}
 
-	if (calculate_hash(data, size, algo, value, &value_len)) {
+	if (!fit_digest_lookup(data, size, algo, value, &value_len)) {
+		debug("%s: reusing %s digest\n", __func__, algo);
+	} else if (calculate_hash(data, size, algo, value, &value_len)) {
 		*err_msgp = "Unsupported hash algorithm";
 		return -1;
+	} else {
+		fit_digest_store(data, size, algo, value, value_len);
 	}
 
 	if (value_len != fit_value_len) {
@@ -1272,6 +1393,8 @@ int fit_image_verify_with_data(const void *fit, int image_noffset,
 	int verify_all = 1;
 	int ret;
 
+	fit_digest_cache_start();
+
 	/* Verify all required signatures */
 	if (FIT_IMAGE_ENABLE_VERIFY &&
 	    fit_image_verify_required_sigs(fit, image_noffset, data, size,
@@ -1319,9 +1442,11 @@ int fit_image_verify_with_data(const void *fit, int image_noffset,
 		goto error;
 	}
 
+	fit_digest_cache_stop();
 	return 1;
 
 error:
+	fit_digest_cache_stop();
 	printf(" error!\n%s for '%s' hash node in '%s' image node\n",
 	       err_msg, fit_get_name(fit, noffset, NULL),
 	       fit_get_name(fit, image_noffset, NULL));
@@ -9,6 +9,7 @@
 #include <dm.h>
 #include <log.h>
 #include <malloc.h>
+#include <memalign.h>
 #include <part.h>
 #include <dm/device-internal.h>
 #include <dm/lists.h>
@@ -436,6 +437,7 @@ unsigned long blk_dread(struct blk_desc *block_dev, lbaint_t start,
 	struct udevice *dev = block_dev->bdev;
 	const struct blk_ops *ops = blk_get_ops(dev);
 	ulong blks_read;
+	lbaint_t racnt;
 
 	if (!ops->read)
 		return -ENOSYS;
@@ -443,6 +445,26 @@ unsigned long blk_dread(struct blk_desc *block_dev, lbaint_t start,
 	if (blkcache_read(block_dev->if_type, block_dev->devnum,
 			  start, blkcnt, block_dev->blksz, buffer))
 		return blkcnt;
+
+	racnt = blkcache_readahead(block_dev->if_type, block_dev->devnum,
+				   start, blkcnt);
+	if (racnt > block_dev->lba - start)
+		racnt = block_dev->lba - start;
+	if (racnt > blkcnt) {
+		void *rabuf = memalign(ARCH_DMA_MINALIGN,
+				       racnt * block_dev->blksz);
+
+		if (rabuf && ops->read(dev, start, racnt, rabuf) == racnt) {
+			blkcache_fill(block_dev->if_type, block_dev->devnum,
+				      start, racnt, block_dev->blksz, rabuf);
+			memcpy(buffer, rabuf, blkcnt * block_dev->blksz);
+			free(rabuf);
+			return blkcnt;
+		}
+		/* fall back to reading just what was asked for */
+		free(rabuf);
+	}
+
 	blks_read = ops->read(dev, start, blkcnt, buffer);
 	if (blks_read == blkcnt)
 		blkcache_fill(block_dev->if_type, block_dev->devnum,
@@ -456,12 +478,19 @@ unsigned long blk_dwrite(struct blk_desc *block_dev, lbaint_t start,
 {
 	struct udevice *dev = block_dev->bdev;
 	const struct blk_ops *ops = blk_get_ops(dev);
+	ulong blks_written;
 
 	if (!ops->write)
 		return -ENOSYS;
 
-	blkcache_invalidate(block_dev->if_type, block_dev->devnum);
-	return ops->write(dev, start, blkcnt, buffer);
+	blks_written = ops->write(dev, start, blkcnt, buffer);
+	if (blks_written == blkcnt)
+		blkcache_write(block_dev->if_type, block_dev->devnum,
+			       start, blkcnt, block_dev->blksz, buffer);
+	else
+		blkcache_invalidate(block_dev->if_type, block_dev->devnum);
+
+	return blks_written;
 }
 
 unsigned long blk_derase(struct blk_desc *block_dev, lbaint_t start,
@@ -473,7 +502,8 @@ unsigned long blk_derase(struct blk_desc *block_dev, lbaint_t start,
 	if (!ops->erase)
 		return -ENOSYS;
 
-	blkcache_invalidate(block_dev->if_type, block_dev->devnum);
+	blkcache_write(block_dev->if_type, block_dev->devnum,
+		       start, blkcnt, block_dev->blksz, NULL);
 	return ops->erase(dev, start, blkcnt);
 }
 
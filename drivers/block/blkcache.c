@@ -11,15 +11,33 @@
 #include <part.h>
 #include <linux/ctype.h>
 #include <linux/list.h>
+#include <linux/log2.h>
 
+/*
+ * The cache holds individual blocks, keyed by (iftype, devnum, blknr) and
+ * looked up through a hash table. All cached blocks are also kept on an LRU
+ * list so that the least recently used one can be dropped once the memory
+ * budget is exhausted.
+ */
 struct block_cache_node {
 	struct list_head lh;
+	struct hlist_node hn;
 	int iftype;
 	int devnum;
-	lbaint_t start;
-	lbaint_t blkcnt;
+	lbaint_t blknr;
 	unsigned long blksz;
-	char *cache;
+	char cache[];
+};
+
+/* sequential stream detection for readahead */
+struct block_cache_stream {
+	int iftype;
+	int devnum;
+	lbaint_t next;
+	lbaint_t window;
+	/* readahead handed out by blkcache_readahead(), not filled yet */
+	lbaint_t ra_start;
+	lbaint_t ra_count;
 };
 
 #ifndef CONFIG_M68K
@@ -28,9 +46,14 @@ static LIST_HEAD(block_cache);
 static struct list_head block_cache;
 #endif
 
+static struct hlist_head *cache_hash;
+static unsigned int cache_hash_bits;
+static struct block_cache_stream cache_stream = { .iftype = -1 };
+
 static struct block_cache_stats _stats = {
-	.max_blocks_per_entry = 8,
-	.max_entries = 32
+	.max_blocks_per_entry = CONFIG_BLOCK_CACHE_MAX_FILL,
+	.max_readahead = CONFIG_BLOCK_CACHE_READAHEAD,
+	.size_kb = CONFIG_VAL(BLOCK_CACHE_SIZE),
 };
 
 #ifdef CONFIG_M68K
@@ -42,140 +65,309 @@ int blkcache_init(void)
 }
 #endif
 
+static inline ulong cache_budget(void)
+{
+	return (ulong)_stats.size_kb << 10;
+}
+
+static unsigned int cache_hashfn(int iftype, int devnum, lbaint_t blknr)
+{
+	u64 key = (u64)blknr ^ ((u64)iftype << 56) ^ ((u64)devnum << 48);
+	u32 val = (u32)key ^ (u32)(key >> 32);
+
+	/* multiplicative (Fibonacci) hashing, keep the high bits */
+	return (val * 0x9e370001U) >> (32 - cache_hash_bits);
+}
+
+static int cache_alloc_hash(void)
+{
+	ulong buckets;
+
+	if (cache_hash)
+		return 0;
+
+	/* aim for an average chain length of about four 512-byte blocks */
+	buckets = cache_budget() / 512 / 4;
+	if (buckets < 64)
+		buckets = 64;
+	cache_hash_bits = ilog2(roundup_pow_of_two(buckets));
+	cache_hash = calloc(1 << cache_hash_bits, sizeof(*cache_hash));
+	if (!cache_hash)
+		return -ENOMEM;
+
+	return 0;
+}
+
 static struct block_cache_node *cache_find(int iftype, int devnum,
-					   lbaint_t start, lbaint_t blkcnt,
-					   unsigned long blksz)
+					   lbaint_t blknr, unsigned long blksz)
 {
 	struct block_cache_node *node;
+	struct hlist_node *pos;
 
-	list_for_each_entry(node, &block_cache, lh)
-		if ((node->iftype == iftype) &&
-		    (node->devnum == devnum) &&
-		    (node->blksz == blksz) &&
-		    (node->start <= start) &&
-		    (node->start + node->blkcnt >= start + blkcnt)) {
-			if (block_cache.next != &node->lh) {
-				/* maintain MRU ordering */
-				list_del(&node->lh);
-				list_add(&node->lh, &block_cache);
-			}
+	if (!cache_hash)
+		return NULL;
+
+	hlist_for_each_entry(node, pos,
+			     &cache_hash[cache_hashfn(iftype, devnum, blknr)],
+			     hn)
+		if (node->blknr == blknr && node->devnum == devnum &&
+		    node->iftype == iftype && node->blksz == blksz)
 			return node;
-		}
-	return 0;
+
+	return NULL;
+}
+
+static void cache_drop(struct block_cache_node *node)
+{
+	list_del(&node->lh);
+	hlist_del(&node->hn);
+	_stats.entries--;
+	_stats.bytes -= node->blksz;
+	free(node);
+}
+
+static void cache_touch(struct block_cache_node *node)
+{
+	/* maintain MRU ordering */
+	if (block_cache.next != &node->lh) {
+		list_del(&node->lh);
+		list_add(&node->lh, &block_cache);
+	}
+}
+
+static void cache_stream_update(int iftype, int devnum, lbaint_t start,
+				lbaint_t blkcnt)
+{
+	if (cache_stream.iftype == iftype && cache_stream.devnum == devnum &&
+	    cache_stream.next == start) {
+		cache_stream.next = start + blkcnt;
+		return;
+	}
+
+	cache_stream.iftype = iftype;
+	cache_stream.devnum = devnum;
+	cache_stream.next = start + blkcnt;
+	cache_stream.window = 0;
+	cache_stream.ra_count = 0;
+}
+
+/* check whether a fill is the readahead asked for by blkcache_readahead() */
+static bool cache_stream_readahead(int iftype, int devnum, lbaint_t start,
+				   lbaint_t blkcnt)
+{
+	return cache_stream.iftype == iftype &&
+	       cache_stream.devnum == devnum &&
+	       cache_stream.ra_count && cache_stream.ra_start == start &&
+	       blkcnt <= cache_stream.ra_count;
 }
 
 int blkcache_read(int iftype, int devnum,
 		  lbaint_t start, lbaint_t blkcnt,
 		  unsigned long blksz, void *buffer)
 {
-	struct block_cache_node *node = cache_find(iftype, devnum, start,
-						   blkcnt, blksz);
-	if (node) {
-		const char *src = node->cache + (start - node->start) * blksz;
-		memcpy(buffer, src, blksz * blkcnt);
-		debug("hit: start " LBAF ", count " LBAFU "\n",
-		      start, blkcnt);
-		++_stats.hits;
-		return 1;
+	struct block_cache_node *node;
+	lbaint_t i;
+
+	if (!blkcnt || blkcnt > _stats.max_blocks_per_entry)
+		goto miss;
+
+	/* make sure the whole range is present before copying anything */
+	for (i = 0; i < blkcnt; i++)
+		if (!cache_find(iftype, devnum, start + i, blksz))
+			goto miss;
+
+	for (i = 0; i < blkcnt; i++) {
+		node = cache_find(iftype, devnum, start + i, blksz);
+		memcpy(buffer + i * blksz, node->cache, blksz);
+		cache_touch(node);
 	}
 
+	debug("hit: start " LBAF ", count " LBAFU "\n",
+	      start, blkcnt);
+	++_stats.hits;
+	cache_stream_update(iftype, devnum, start, blkcnt);
+	return 1;
+
+miss:
 	debug("miss: start " LBAF ", count " LBAFU "\n",
 	      start, blkcnt);
 	++_stats.misses;
 	return 0;
 }
 
+lbaint_t blkcache_readahead(int iftype, int devnum,
+			    lbaint_t start, lbaint_t blkcnt)
+{
+	lbaint_t window;
+
+	if (blkcnt > _stats.max_blocks_per_entry || !_stats.max_readahead ||
+	    !_stats.size_kb) {
+		cache_stream_update(iftype, devnum, start, blkcnt);
+		return blkcnt;
+	}
+
+	/*
+	 * Only read ahead once a sequential run has been seen, doubling the
+	 * window on each further sequential miss, like the Linux page cache
+	 * does.
+	 */
+	if (cache_stream.iftype != iftype || cache_stream.devnum != devnum ||
+	    cache_stream.next != start) {
+		cache_stream_update(iftype, devnum, start, blkcnt);
+		return blkcnt;
+	}
+
+	window = cache_stream.window ? cache_stream.window * 2 : blkcnt * 2;
+	if (window > _stats.max_readahead)
+		window = _stats.max_readahead;
+	if (window < blkcnt)
+		window = blkcnt;
+
+	cache_stream.window = window;
+	cache_stream.next = start + blkcnt;
+	if (window > blkcnt) {
+		_stats.readahead += window - blkcnt;
+		cache_stream.ra_start = start;
+		cache_stream.ra_count = window;
+	}
+
+	return window;
+}
+
 void blkcache_fill(int iftype, int devnum,
 		   lbaint_t start, lbaint_t blkcnt,
 		   unsigned long blksz, void const *buffer)
 {
-	lbaint_t bytes;
 	struct block_cache_node *node;
+	lbaint_t i;
 
-	/* don't cache big stuff */
-	if (blkcnt > _stats.max_blocks_per_entry)
-		return;
+	/* don't cache big stuff, unless it is readahead we asked for */
+	if (blkcnt > _stats.max_blocks_per_entry) {
+		if (!cache_stream_readahead(iftype, devnum, start, blkcnt))
+			return;
+		cache_stream.ra_count = 0;
+	}
 
-	if (_stats.max_entries == 0)
+	if (blksz > cache_budget() || cache_alloc_hash())
 		return;
 
-	bytes = blksz * blkcnt;
-	if (_stats.max_entries <= _stats.entries) {
-		/* pop LRU */
-		node = (struct block_cache_node *)block_cache.prev;
-		list_del(&node->lh);
-		_stats.entries--;
-		debug("drop: start " LBAF ", count " LBAFU "\n",
-		      node->start, node->blkcnt);
-		if (node->blkcnt * node->blksz < bytes) {
-			free(node->cache);
-			node->cache = 0;
+	for (i = 0; i < blkcnt; i++) {
+		const char *src = buffer + i * blksz;
+
+		node = cache_find(iftype, devnum, start + i, blksz);
+		if (node) {
+			memcpy(node->cache, src, blksz);
+			cache_touch(node);
+			continue;
+		}
+
+		/* pop LRU until the new block fits in the budget */
+		while (_stats.bytes + blksz > cache_budget()) {
+			node = list_last_entry(&block_cache,
+					       struct block_cache_node, lh);
+			debug("drop: blknr " LBAF "\n", node->blknr);
+			cache_drop(node);
+			_stats.evictions++;
 		}
-	} else {
-		node = malloc(sizeof(*node));
+
+		node = malloc(sizeof(*node) + blksz);
 		if (!node)
 			return;
-		node->cache = 0;
-	}
 
-	if (!node->cache) {
-		node->cache = malloc(bytes);
-		if (!node->cache) {
-			free(node);
-			return;
-		}
+		node->iftype = iftype;
+		node->devnum = devnum;
+		node->blknr = start + i;
+		node->blksz = blksz;
+		memcpy(node->cache, src, blksz);
+		list_add(&node->lh, &block_cache);
+		hlist_add_head(&node->hn,
+			       &cache_hash[cache_hashfn(iftype, devnum,
+							node->blknr)]);
+		_stats.entries++;
+		_stats.bytes += blksz;
 	}
 
 	debug("fill: start " LBAF ", count " LBAFU "\n",
 	      start, blkcnt);
+}
+
+void blkcache_write(int iftype, int devnum,
+		    lbaint_t start, lbaint_t blkcnt,
+		    unsigned long blksz, void const *buffer)
+{
+	struct block_cache_node *node, *n;
+	lbaint_t i;
+
+	if (!_stats.entries)
+		return;
+
+	/* write-through: refresh any block we already hold */
+	if (blkcnt > _stats.entries) {
+		/* large write, cheaper to walk the cache than the range */
+		list_for_each_entry_safe(node, n, &block_cache, lh) {
+			if (node->iftype != iftype || node->devnum != devnum ||
+			    node->blksz != blksz || node->blknr < start ||
+			    node->blknr >= start + blkcnt)
+				continue;
+			if (buffer)
+				memcpy(node->cache,
+				       buffer + (node->blknr - start) * blksz,
+				       blksz);
+			else
+				cache_drop(node);
+		}
+		return;
+	}
 
-	node->iftype = iftype;
-	node->devnum = devnum;
-	node->start = start;
-	node->blkcnt = blkcnt;
-	node->blksz = blksz;
-	memcpy(node->cache, buffer, bytes);
-	list_add(&node->lh, &block_cache);
-	_stats.entries++;
+	for (i = 0; i < blkcnt; i++) {
+		node = cache_find(iftype, devnum, start + i, blksz);
+		if (!node)
+			continue;
+		if (buffer)
+			memcpy(node->cache, buffer + i * blksz, blksz);
+		else
+			cache_drop(node);
+	}
 }
 
 void blkcache_invalidate(int iftype, int devnum)
 {
-	struct list_head *entry, *n;
-	struct block_cache_node *node;
+	struct block_cache_node *node, *n;
 
-	list_for_each_safe(entry, n, &block_cache) {
-		node = (struct block_cache_node *)entry;
+	list_for_each_entry_safe(node, n, &block_cache, lh) {
 		if ((node->iftype == iftype) &&
-		    (node->devnum == devnum)) {
-			list_del(entry);
-			free(node->cache);
-			free(node);
-			--_stats.entries;
-		}
+		    (node->devnum == devnum))
+			cache_drop(node);
 	}
+
+	if (cache_stream.iftype == iftype && cache_stream.devnum == devnum)
+		cache_stream.iftype = -1;
 }
 
-void blkcache_configure(unsigned blocks, unsigned entries)
+void blkcache_configure(unsigned blocks, unsigned size_kb,
+			unsigned readahead)
 {
-	struct block_cache_node *node;
+	struct block_cache_node *node, *n;
+
 	if ((blocks != _stats.max_blocks_per_entry) ||
-	    (entries != _stats.max_entries)) {
+	    (size_kb != _stats.size_kb)) {
 		/* invalidate cache */
-		while (!list_empty(&block_cache)) {
-			node = (struct block_cache_node *)block_cache.next;
-			list_del(&node->lh);
-			free(node->cache);
-			free(node);
-		}
-		_stats.entries = 0;
+		list_for_each_entry_safe(node, n, &block_cache, lh)
+			cache_drop(node);
+		/* the hash table is sized from the budget */
+		free(cache_hash);
+		cache_hash = NULL;
+		cache_stream.iftype = -1;
 	}
 
 	_stats.max_blocks_per_entry = blocks;
-	_stats.max_entries = entries;
+	_stats.size_kb = size_kb;
+	_stats.max_readahead = readahead;
 
 	_stats.hits = 0;
 	_stats.misses = 0;
+	_stats.evictions = 0;
+	_stats.readahead = 0;
 }
 
 void blkcache_stats(struct block_cache_stats *stats)
@@ -183,4 +375,6 @@ void blkcache_stats(struct block_cache_stats *stats)
 	memcpy(stats, &_stats, sizeof(*stats));
 	_stats.hits = 0;
 	_stats.misses = 0;
+	_stats.evictions = 0;
+	_stats.readahead = 0;
 }
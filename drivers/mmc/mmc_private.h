@@ -16,6 +16,18 @@ int mmc_send_status(struct mmc *mmc, unsigned int *status);
 int mmc_poll_for_busy(struct mmc *mmc, int timeout);
 
 int mmc_set_blocklen(struct mmc *mmc, int len);
+int mmc_set_block_count(struct mmc *mmc, unsigned int blkcnt);
+
+/*
+ * Whether a multiple block transfer can be bounded with SET_BLOCK_COUNT
+ * (CMD23) up front instead of being ended with STOP_TRANSMISSION (CMD12)
+ */
+static inline bool mmc_can_set_block_count(struct mmc *mmc,
+					   lbaint_t blkcnt)
+{
+	return blkcnt > 1 && blkcnt <= 0xffff &&
+	       (mmc->card_caps & mmc->host_caps & MMC_CAP_CMD23);
+}
 #ifdef CONFIG_FSL_ESDHC_ADAPTER_IDENT
 void mmc_adapter_card_type_ident(void);
 #endif
@@ -833,6 +833,10 @@ int sdhci_setup_cfg(struct mmc_config *cfg, struct sdhci_host *host,
 
 	cfg->host_caps |= MMC_MODE_HS | MMC_MODE_HS_52MHz | MMC_MODE_4BIT;
 
+	/* No auto CMD12 is used, so multi-block transfers may use CMD23 */
+	if (!(host->quirks & SDHCI_QUIRK_BROKEN_CMD23))
+		cfg->host_caps |= MMC_CAP_CMD23;
+
 	/* Since Host Controller Version3.0 */
 	if (SDHCI_GET_VERSION(host) >= SDHCI_SPEC_300) {
 		if (!(caps & SDHCI_CAN_DO_8BIT))
@@ -361,9 +361,12 @@ int designware_eth_enable(struct dw_eth_dev *priv)
 
 #define ETH_ZLEN	60
 
-static int _dw_eth_send(struct dw_eth_dev *priv, void *packet, int length)
+/* How long to wait for the DMA to give back a full ring, in ms */
+#define DW_TX_TIMEOUT	100
+
+/* Put a frame on the ring, the caller then kicks the DMA */
+static int _dw_eth_queue(struct dw_eth_dev *priv, void *packet, int length)
 {
-	struct eth_dma_regs *dma_p = priv->dma_regs_p;
 	u32 desc_num = priv->tx_currdescnum;
 	struct dmamacdescr *desc_p = &priv->tx_mac_descrtable[desc_num];
 	ulong desc_start = (ulong)desc_p;
@@ -371,6 +374,7 @@ static int _dw_eth_send(struct dw_eth_dev *priv, void *packet, int length)
 		roundup(sizeof(*desc_p), ARCH_DMA_MINALIGN);
 	ulong data_start = desc_p->dmamac_addr;
 	ulong data_end = data_start + roundup(length, ARCH_DMA_MINALIGN);
+	ulong start;
 	/*
 	 * Strictly we only need to invalidate the "txrx_status" field
 	 * for the following check, but on some platforms we cannot
@@ -381,10 +385,17 @@ static int _dw_eth_send(struct dw_eth_dev *priv, void *packet, int length)
 	 */
 	invalidate_dcache_range(desc_start, desc_end);
 
-	/* Check if the descriptor is owned by CPU */
-	if (desc_p->txrx_status & DESC_TXSTS_OWNBYDMA) {
-		printf("CPU not owner of tx frame\n");
-		return -EPERM;
+	/*
+	 * Sent descriptors are only reclaimed here: if the ring is full, wait
+	 * for the DMA to be done with the oldest one
+	 */
+	start = get_timer(0);
+	while (desc_p->txrx_status & DESC_TXSTS_OWNBYDMA) {
+		if (get_timer(start) >= DW_TX_TIMEOUT) {
+			printf("CPU not owner of tx frame\n");
+			return -EPERM;
+		}
+		invalidate_dcache_range(desc_start, desc_end);
 	}
 
 	memcpy((void *)data_start, packet, length);
@@ -422,15 +433,50 @@ static int _dw_eth_send(struct dw_eth_dev *priv, void *packet, int length)
 
 	priv->tx_currdescnum = desc_num;
 
+	return 0;
+}
+
+static int _dw_eth_send(struct dw_eth_dev *priv, void *packet, int length)
+{
+	struct eth_dma_regs *dma_p = priv->dma_regs_p;
+	int ret;
+
+	ret = _dw_eth_queue(priv, packet, length);
+	if (ret)
+		return ret;
+
 	/* Start the transmission */
 	writel(POLL_DATA, &dma_p->txpolldemand);
 
 	return 0;
 }
 
-static int _dw_eth_recv(struct dw_eth_dev *priv, uchar **packetp)
+static int _dw_eth_send_batch(struct dw_eth_dev *priv, void **packets,
+			      int *lengths, int count)
+{
+	struct eth_dma_regs *dma_p = priv->dma_regs_p;
+	int ret = 0;
+	int i;
+
+	for (i = 0; i < count; i++) {
+		ret = _dw_eth_queue(priv, packets[i], lengths[i]);
+		if (ret)
+			break;
+	}
+
+	/* One poll demand starts the transmission of the whole batch */
+	if (i)
+		writel(POLL_DATA, &dma_p->txpolldemand);
+
+	return i ? i : ret;
+}
+
+/* Check for a frame in the descriptor @ahead places after the oldest one */
+static int _dw_eth_recv_at(struct dw_eth_dev *priv, u32 ahead,
+			   uchar **packetp)
 {
-	u32 status, desc_num = priv->rx_currdescnum;
+	u32 status, desc_num = (priv->rx_currdescnum + ahead) %
+			       CONFIG_RX_DESCR_NUM;
 	struct dmamacdescr *desc_p = &priv->rx_mac_descrtable[desc_num];
 	int length = -EAGAIN;
 	ulong desc_start = (ulong)desc_p;
@@ -459,6 +505,30 @@ static int _dw_eth_recv(struct dw_eth_dev *priv, uchar **packetp)
 	return length;
 }
 
+static int _dw_eth_recv(struct dw_eth_dev *priv, uchar **packetp)
+{
+	return _dw_eth_recv_at(priv, 0, packetp);
+}
+
+/*
+ * Frames are handed out without giving their descriptors back, which
+ * _dw_free_pkt() does in order once the stack is done with them
+ */
+static int _dw_eth_recv_batch(struct dw_eth_dev *priv,
+			      struct eth_rx_pkt *pkts, int max)
+{
+	int i;
+
+	max = min(max, CONFIG_RX_DESCR_NUM);
+	for (i = 0; i < max; i++) {
+		pkts[i].length = _dw_eth_recv_at(priv, i, &pkts[i].packet);
+		if (pkts[i].length < 0)
+			break;
+	}
+
+	return i ? i : -EAGAIN;
+}
+
 static int _dw_free_pkt(struct dw_eth_dev *priv)
 {
 	u32 desc_num = priv->rx_currdescnum;
@@ -638,6 +708,22 @@ int designware_eth_recv(struct udevice *dev, int flags, uchar **packetp)
 	return _dw_eth_recv(priv, packetp);
 }
 
+int designware_eth_send_batch(struct udevice *dev, void **packets,
+			      int *lengths, int count)
+{
+	struct dw_eth_dev *priv = dev_get_priv(dev);
+
+	return _dw_eth_send_batch(priv, packets, lengths, count);
+}
+
+int designware_eth_recv_batch(struct udevice *dev, int flags,
+			      struct eth_rx_pkt *pkts, int max)
+{
+	struct dw_eth_dev *priv = dev_get_priv(dev);
+
+	return _dw_eth_recv_batch(priv, pkts, max);
+}
+
 int designware_eth_free_pkt(struct udevice *dev, uchar *packet, int length)
 {
 	struct dw_eth_dev *priv = dev_get_priv(dev);
@@ -805,6 +891,8 @@ const struct eth_ops designware_eth_ops = {
 	.start			= designware_eth_start,
 	.send			= designware_eth_send,
 	.recv			= designware_eth_recv,
+	.send_batch		= designware_eth_send_batch,
+	.recv_batch		= designware_eth_recv_batch,
 	.free_pkt		= designware_eth_free_pkt,
 	.stop			= designware_eth_stop,
 	.write_hwaddr		= designware_eth_write_hwaddr,
@@ -67,12 +67,57 @@ tested on both gig copper and gig fiber boards
  * Normally U-Boot does not support this anyway. To fix it in this driver,
  * move these buffers and the tx/rx pointers to struct e1000_hw.
  */
-DEFINE_ALIGN_BUFFER(struct e1000_tx_desc, tx_base, 16, E1000_BUFFER_ALIGN);
-DEFINE_ALIGN_BUFFER(struct e1000_rx_desc, rx_base, 16, E1000_BUFFER_ALIGN);
-DEFINE_ALIGN_BUFFER(unsigned char, packet, 4096, E1000_BUFFER_ALIGN);
+/*
+ * Each descriptor has a buffer of its own, so that several frames can be
+ * received before the stack gives the first one back, and frames are copied
+ * for transmission so that the caller does not wait for the hardware. The
+ * ring lengths must be multiples of 8 descriptors.
+ */
+#define E1000_NUM_TX_DESC	16
+#define E1000_NUM_RX_DESC	32
+#define E1000_TX_BUF_SIZE	PKTSIZE_ALIGN
+
+/* The smallest receive buffer size RCTL can select that holds PKTSIZE */
+#if PKTSIZE <= 2048
+#define E1000_RX_BUF_SIZE	2048
+#define E1000_RCTL_BUF_SIZE	E1000_RCTL_SZ_2048
+#elif PKTSIZE <= 4096
+#define E1000_RX_BUF_SIZE	4096
+#define E1000_RCTL_BUF_SIZE	(E1000_RCTL_SZ_4096 | E1000_RCTL_BSEX)
+#elif PKTSIZE <= 8192
+#define E1000_RX_BUF_SIZE	8192
+#define E1000_RCTL_BUF_SIZE	(E1000_RCTL_SZ_8192 | E1000_RCTL_BSEX)
+#else
+#define E1000_RX_BUF_SIZE	16384
+#define E1000_RCTL_BUF_SIZE	(E1000_RCTL_SZ_16384 | E1000_RCTL_BSEX)
+#endif
 
-static int tx_tail;
-static int rx_tail, rx_last;
+/* Largest MTU of the controllers that support jumbo frames */
+#define E1000_MAX_JUMBO_MTU	9000
+
+/*
+ * Receive descriptors sharing a cache line are handed back to the hardware
+ * together, so that writing back one of them cannot clobber the status the
+ * hardware is writing to another.
+ */
+#define E1000_RX_DESC_PER_LINE	\
+	max_t(int, 1, ARCH_DMA_MINALIGN / sizeof(struct e1000_rx_desc))
+
+DEFINE_ALIGN_BUFFER(struct e1000_tx_desc, tx_base, E1000_NUM_TX_DESC,
+		    E1000_BUFFER_ALIGN);
+DEFINE_ALIGN_BUFFER(struct e1000_rx_desc, rx_base, E1000_NUM_RX_DESC,
+		    E1000_BUFFER_ALIGN);
+DEFINE_ALIGN_BUFFER(unsigned char, tx_buf,
+		    E1000_NUM_TX_DESC * E1000_TX_BUF_SIZE, E1000_BUFFER_ALIGN);
+DEFINE_ALIGN_BUFFER(unsigned char, rx_buf,
+		    E1000_NUM_RX_DESC * E1000_RX_BUF_SIZE, E1000_BUFFER_ALIGN);
+
+static int tx_tail;	/* next descriptor to fill (TDT) */
+static int tx_clean;	/* oldest descriptor not known to be sent */
+static int rx_tail;	/* first descriptor held back from the hardware (RDT) */
+static int rx_next;	/* next descriptor to check for a frame */
+static int rx_free;	/* oldest frame not given back by the stack */
+static int rx_pending;	/* frames received but not given back */
 #ifdef CONFIG_DM_ETH
 static int num_cards;	/* Number of E1000 devices seen so far */
 #endif
@@ -5136,33 +5181,81 @@ e1000_sw_init(struct e1000_hw *hw)
 	return E1000_SUCCESS;
 }
 
-void
-fill_rx(struct e1000_hw *hw)
+static void e1000_flush_desc(void *desc, int size)
 {
-	struct e1000_rx_desc *rd;
-	unsigned long flush_start, flush_end;
+	unsigned long start = (unsigned long)desc & ~(ARCH_DMA_MINALIGN - 1);
+
+	flush_dcache_range(start, start + roundup(size, ARCH_DMA_MINALIGN));
+}
+
+static void e1000_invalidate_desc(void *desc, int size)
+{
+	unsigned long start = (unsigned long)desc & ~(ARCH_DMA_MINALIGN - 1);
+
+	invalidate_dcache_range(start, start + roundup(size, ARCH_DMA_MINALIGN));
+}
 
-	rx_last = rx_tail;
-	rd = rx_base + rx_tail;
-	rx_tail = (rx_tail + 1) % 8;
-	memset(rd, 0, 16);
-	rd->buffer_addr = cpu_to_le64((unsigned long)packet);
+/* Give @count descriptors from @first to the hardware again */
+static void e1000_arm_rx(int first, int count)
+{
+	struct e1000_rx_desc *rd = rx_base + first;
+	unsigned char *buf = rx_buf + first * E1000_RX_BUF_SIZE;
+	int i;
+
+	for (i = 0; i < count; i++) {
+		memset(&rd[i], 0, sizeof(*rd));
+		rd[i].buffer_addr = cpu_to_le64((unsigned long)buf +
+						i * E1000_RX_BUF_SIZE);
+	}
 
 	/*
 	 * Make sure there are no stale data in WB over this area, which
 	 * might get written into the memory while the e1000 also writes
 	 * into the same memory area.
 	 */
-	invalidate_dcache_range((unsigned long)packet,
-				(unsigned long)packet + 4096);
-	/* Dump the DMA descriptor into RAM. */
-	flush_start = ((unsigned long)rd) & ~(ARCH_DMA_MINALIGN - 1);
-	flush_end = flush_start + roundup(sizeof(*rd), ARCH_DMA_MINALIGN);
-	flush_dcache_range(flush_start, flush_end);
+	invalidate_dcache_range((unsigned long)buf,
+				(unsigned long)buf + count * E1000_RX_BUF_SIZE);
+	/* Dump the DMA descriptors into RAM. */
+	e1000_flush_desc(rd, count * sizeof(*rd));
+}
+
+static void
+fill_rx(struct e1000_hw *hw)
+{
+	/* Keep the last cache line of descriptors back, the ring is full */
+	e1000_arm_rx(0, E1000_NUM_RX_DESC);
+	rx_tail = E1000_NUM_RX_DESC - E1000_RX_DESC_PER_LINE;
+	rx_next = 0;
+	rx_free = 0;
+	rx_pending = 0;
 
 	E1000_WRITE_REG(hw, RDT, rx_tail);
 }
 
+/* The stack is done with the oldest received frame */
+static void e1000_free_rx(struct e1000_hw *hw)
+{
+	if (!rx_pending)
+		return;
+
+	rx_pending--;
+	rx_free = (rx_free + 1) % E1000_NUM_RX_DESC;
+	if (rx_free % E1000_RX_DESC_PER_LINE == 0) {
+		/*
+		 * A whole cache line is free: give it to the hardware and
+		 * hold it back in place of the one released by moving the
+		 * tail onto it
+		 */
+		rx_tail = (rx_free + E1000_NUM_RX_DESC -
+			   E1000_RX_DESC_PER_LINE) % E1000_NUM_RX_DESC;
+		e1000_arm_rx(rx_tail, E1000_RX_DESC_PER_LINE);
+	}
+
+	/* One tail update for a whole batch of frames */
+	if (!rx_pending)
+		E1000_WRITE_REG(hw, RDT, rx_tail);
+}
+
 /**
  * e1000_configure_tx - Configure 8254x Transmit Unit after Reset
  * @adapter: board private structure
@@ -5180,12 +5273,13 @@ e1000_configure_tx(struct e1000_hw *hw)
 	E1000_WRITE_REG(hw, TDBAL, lower_32_bits((unsigned long)tx_base));
 	E1000_WRITE_REG(hw, TDBAH, upper_32_bits((unsigned long)tx_base));
 
-	E1000_WRITE_REG(hw, TDLEN, 128);
+	E1000_WRITE_REG(hw, TDLEN, E1000_NUM_TX_DESC * sizeof(*tx_base));
 
 	/* Setup the HW Tx Head and Tail descriptor pointers */
 	E1000_WRITE_REG(hw, TDH, 0);
 	E1000_WRITE_REG(hw, TDT, 0);
 	tx_tail = 0;
+	tx_clean = 0;
 
 	/* Set the default values for the Tx Inter Packet Gap timer */
 	if (hw->mac_type <= e1000_82547_rev_2 &&
@@ -5263,6 +5357,24 @@ e1000_configure_tx(struct e1000_hw *hw)
 
 }
 
+/**
+ * e1000_max_mtu - largest MTU the controller can receive
+ * @hw: Struct containing variables accessed by shared code
+ **/
+static int
+e1000_max_mtu(struct e1000_hw *hw)
+{
+	switch (hw->mac_type) {
+	case e1000_82542_rev2_0:
+	case e1000_82542_rev2_1:
+	case e1000_82573:
+	case e1000_ich8lan:
+		return ETH_DATA_LEN;
+	default:
+		return E1000_MAX_JUMBO_MTU;
+	}
+}
+
 /**
  * e1000_setup_rctl - configure the receive control register
  * @adapter: Board private structure
@@ -5285,9 +5397,11 @@ e1000_setup_rctl(struct e1000_hw *hw)
 	else
 		rctl &= ~E1000_RCTL_SBP;
 
-	rctl &= ~(E1000_RCTL_SZ_4096);
-		rctl |= E1000_RCTL_SZ_2048;
-		rctl &= ~(E1000_RCTL_BSEX | E1000_RCTL_LPE);
+	rctl &= ~(E1000_RCTL_SZ_4096 | E1000_RCTL_BSEX | E1000_RCTL_LPE);
+	rctl |= E1000_RCTL_BUF_SIZE;
+	/* jumbo frames need long packet reception */
+	if (NET_MTU > ETH_DATA_LEN && e1000_max_mtu(hw) > ETH_DATA_LEN)
+		rctl |= E1000_RCTL_LPE;
 	E1000_WRITE_REG(hw, RCTL, rctl);
 }
 
@@ -5325,7 +5439,7 @@ e1000_configure_rx(struct e1000_hw *hw)
 	E1000_WRITE_REG(hw, RDBAL, lower_32_bits((unsigned long)rx_base));
 	E1000_WRITE_REG(hw, RDBAH, upper_32_bits((unsigned long)rx_base));
 
-	E1000_WRITE_REG(hw, RDLEN, 128);
+	E1000_WRITE_REG(hw, RDLEN, E1000_NUM_RX_DESC * sizeof(*rx_base));
 
 	/* Setup the HW Rx Head and Tail Descriptor Pointers */
 	E1000_WRITE_REG(hw, RDH, 0);
@@ -5340,6 +5454,11 @@ e1000_configure_rx(struct e1000_hw *hw)
 		mdelay(20);
 	}
 
+	/* Have the hardware check IP, TCP and UDP checksums */
+	if (hw->mac_type >= e1000_82543)
+		E1000_WRITE_REG(hw, RXCSUM, E1000_READ_REG(hw, RXCSUM) |
+				E1000_RXCSUM_IPOFL | E1000_RXCSUM_TUOFL);
+
 	E1000_WRITE_REG(hw, RCTL, rctl);
 
 	fill_rx(hw);
@@ -5348,68 +5467,128 @@ e1000_configure_rx(struct e1000_hw *hw)
 /**************************************************************************
 POLL - Wait for a frame
 ***************************************************************************/
+/* Turn the checksum status of a receive descriptor into ETH_CSUM_... flags */
+static uint e1000_rx_csum(struct e1000_rx_desc *rd)
+{
+	uint csum = 0;
+
+	if (rd->status & E1000_RXD_STAT_IXSM)
+		return 0;
+
+	if (rd->status & E1000_RXD_STAT_IPCS)
+		csum |= rd->errors & E1000_RXD_ERR_IPE ? ETH_CSUM_BAD :
+			ETH_CSUM_IP;
+	if (rd->status & (E1000_RXD_STAT_TCPCS | E1000_RXD_STAT_UDPCS))
+		csum |= rd->errors & E1000_RXD_ERR_TCPE ? ETH_CSUM_BAD :
+			ETH_CSUM_L4;
+	if (csum & ETH_CSUM_BAD)
+		csum = ETH_CSUM_BAD;
+
+	return csum;
+}
+
 static int
-_e1000_poll(struct e1000_hw *hw)
+_e1000_poll(struct e1000_hw *hw, uchar **packetp, uint *csum)
 {
 	struct e1000_rx_desc *rd;
-	unsigned long inval_start, inval_end;
+	unsigned char *buf;
 	uint32_t len;
 
+	/* The hardware cannot have filled what it does not own */
+	if (rx_next == rx_tail)
+		return 0;
+
 	/* return true if there's an ethernet packet ready to read */
-	rd = rx_base + rx_last;
+	rd = rx_base + rx_next;
 
 	/* Re-load the descriptor from RAM. */
-	inval_start = ((unsigned long)rd) & ~(ARCH_DMA_MINALIGN - 1);
-	inval_end = inval_start + roundup(sizeof(*rd), ARCH_DMA_MINALIGN);
-	invalidate_dcache_range(inval_start, inval_end);
+	e1000_invalidate_desc(rd, sizeof(*rd));
 
 	if (!(rd->status & E1000_RXD_STAT_DD))
 		return 0;
 	/* DEBUGOUT("recv: packet len=%d\n", rd->length); */
 	/* Packet received, make sure the data are re-loaded from RAM. */
 	len = le16_to_cpu(rd->length);
-	invalidate_dcache_range((unsigned long)packet,
-				(unsigned long)packet +
+	buf = rx_buf + rx_next * E1000_RX_BUF_SIZE;
+	invalidate_dcache_range((unsigned long)buf,
+				(unsigned long)buf +
 				roundup(len, ARCH_DMA_MINALIGN));
+
+	rx_next = (rx_next + 1) % E1000_NUM_RX_DESC;
+	rx_pending++;
+	*packetp = buf;
+	if (csum)
+		*csum = e1000_rx_csum(rd);
+
 	return len;
 }
 
-static int _e1000_transmit(struct e1000_hw *hw, void *txpacket, int length)
+/*
+ * Forget about the descriptors the hardware is done with. They complete in
+ * order, so a descriptor reported done also completes the ones before it,
+ * even if their own status was lost to a write-back of a neighbouring
+ * descriptor in the same cache line.
+ */
+static void e1000_reap_tx(void)
 {
-	void *nv_packet = (void *)txpacket;
 	struct e1000_tx_desc *txp;
+	int i;
+
+	for (i = tx_clean; i != tx_tail; i = (i + 1) % E1000_NUM_TX_DESC) {
+		txp = tx_base + i;
+		e1000_invalidate_desc(txp, sizeof(*txp));
+		if (le32_to_cpu(txp->upper.data) & E1000_TXD_STAT_DD)
+			tx_clean = (i + 1) % E1000_NUM_TX_DESC;
+	}
+}
+
+/* Copy a frame to the ring, the caller then moves the tail */
+static int e1000_queue_tx(struct e1000_hw *hw, void *txpacket, int length)
+{
+	struct e1000_tx_desc *txp;
+	unsigned char *buf;
 	int i = 0;
-	unsigned long flush_start, flush_end;
+
+	if (length > E1000_TX_BUF_SIZE)
+		return -EINVAL;
+
+	e1000_reap_tx();
+	while ((tx_tail + 1) % E1000_NUM_TX_DESC == tx_clean) {
+		if (i++ > TOUT_LOOP) {
+			DEBUGOUT("e1000: tx timeout\n");
+			return -ETIMEDOUT;
+		}
+		udelay(10);	/* give the nic a chance to write to the register */
+		e1000_reap_tx();
+	}
 
 	txp = tx_base + tx_tail;
-	tx_tail = (tx_tail + 1) % 8;
+	buf = tx_buf + tx_tail * E1000_TX_BUF_SIZE;
+	memcpy(buf, txpacket, length);
+	/* Dump the packet into RAM so e1000 can pick them. */
+	flush_dcache_range((unsigned long)buf,
+			   (unsigned long)buf + roundup(length, ARCH_DMA_MINALIGN));
 
-	txp->buffer_addr = cpu_to_le64(virt_to_bus(hw->pdev, nv_packet));
+	e1000_invalidate_desc(txp, sizeof(*txp));
+	txp->buffer_addr = cpu_to_le64(virt_to_bus(hw->pdev, buf));
 	txp->lower.data = cpu_to_le32(hw->txd_cmd | length);
 	txp->upper.data = 0;
-
-	/* Dump the packet into RAM so e1000 can pick them. */
-	flush_dcache_range((unsigned long)nv_packet,
-			   (unsigned long)nv_packet +
-			   roundup(length, ARCH_DMA_MINALIGN));
 	/* Dump the descriptor into RAM as well. */
-	flush_start = ((unsigned long)txp) & ~(ARCH_DMA_MINALIGN - 1);
-	flush_end = flush_start + roundup(sizeof(*txp), ARCH_DMA_MINALIGN);
-	flush_dcache_range(flush_start, flush_end);
+	e1000_flush_desc(txp, sizeof(*txp));
 
-	E1000_WRITE_REG(hw, TDT, tx_tail);
+	tx_tail = (tx_tail + 1) % E1000_NUM_TX_DESC;
 
+	return 0;
+}
+
+static int _e1000_transmit(struct e1000_hw *hw, void *txpacket, int length)
+{
+	if (e1000_queue_tx(hw, txpacket, length))
+		return 0;
+
+	E1000_WRITE_REG(hw, TDT, tx_tail);
 	E1000_WRITE_FLUSH(hw);
-	while (1) {
-		invalidate_dcache_range(flush_start, flush_end);
-		if (le32_to_cpu(txp->upper.data) & E1000_TXD_STAT_DD)
-			break;
-		if (i++ > TOUT_LOOP) {
-			DEBUGOUT("e1000: tx timeout\n");
-			return 0;
-		}
-		udelay(10);	/* give the nic a chance to write to the register */
-	}
+
 	return 1;
 }
 
@@ -5645,12 +5824,13 @@ static int
 e1000_poll(struct eth_device *nic)
 {
 	struct e1000_hw *hw = nic->priv;
+	uchar *packet;
 	int len;
 
-	len = _e1000_poll(hw);
+	len = _e1000_poll(hw, &packet, NULL);
 	if (len) {
-		net_process_received_packet((uchar *)packet, len);
-		fill_rx(hw);
+		net_process_received_packet(packet, len);
+		e1000_free_rx(hw);
 	}
 
 	return len ? 1 : 0;
@@ -5862,23 +6042,58 @@ static int e1000_eth_send(struct udevice *dev, void *packet, int length)
 	return ret ? 0 : -ETIMEDOUT;
 }
 
+static int e1000_eth_send_batch(struct udevice *dev, void **packets,
+				int *lengths, int count)
+{
+	struct e1000_hw *hw = dev_get_priv(dev);
+	int ret = 0;
+	int i;
+
+	for (i = 0; i < count; i++) {
+		ret = e1000_queue_tx(hw, packets[i], lengths[i]);
+		if (ret)
+			break;
+	}
+
+	if (i) {
+		E1000_WRITE_REG(hw, TDT, tx_tail);
+		E1000_WRITE_FLUSH(hw);
+	}
+
+	return i ? i : ret;
+}
+
 static int e1000_eth_recv(struct udevice *dev, int flags, uchar **packetp)
 {
 	struct e1000_hw *hw = dev_get_priv(dev);
 	int len;
 
-	len = _e1000_poll(hw);
-	if (len)
-		*packetp = packet;
+	len = _e1000_poll(hw, packetp, NULL);
 
 	return len ? len : -EAGAIN;
 }
 
+static int e1000_eth_recv_batch(struct udevice *dev, int flags,
+				struct eth_rx_pkt *pkts, int max)
+{
+	struct e1000_hw *hw = dev_get_priv(dev);
+	int i;
+
+	for (i = 0; i < max; i++) {
+		pkts[i].length = _e1000_poll(hw, &pkts[i].packet,
+					     &pkts[i].csum);
+		if (!pkts[i].length)
+			break;
+	}
+
+	return i ? i : -EAGAIN;
+}
+
 static int e1000_free_pkt(struct udevice *dev, uchar *packet, int length)
 {
 	struct e1000_hw *hw = dev_get_priv(dev);
 
-	fill_rx(hw);
+	e1000_free_rx(hw);
 
 	return 0;
 }
@@ -5897,6 +6112,11 @@ static int e1000_eth_probe(struct udevice *dev)
 		return ret;
 	}
 
+	/* see e1000_configure_rx() */
+	if (hw->mac_type >= e1000_82543)
+		plat->rx_csum = ETH_CSUM_IP | ETH_CSUM_L4;
+	plat->max_mtu = e1000_max_mtu(hw);
+
 	return 0;
 }
 
@@ -5919,6 +6139,8 @@ static const struct eth_ops e1000_eth_ops = {
 	.start	= e1000_eth_start,
 	.send	= e1000_eth_send,
 	.recv	= e1000_eth_recv,
+	.send_batch = e1000_eth_send_batch,
+	.recv_batch = e1000_eth_recv_batch,
 	.stop	= e1000_eth_stop,
 	.free_pkt = e1000_free_pkt,
 };
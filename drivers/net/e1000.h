@@ -499,6 +499,7 @@ struct e1000_rx_desc {
 #define E1000_RXD_STAT_EOP	0x02	/* End of Packet */
 #define E1000_RXD_STAT_IXSM	0x04	/* Ignore checksum */
 #define E1000_RXD_STAT_VP	0x08	/* IEEE VLAN Packet */
+#define E1000_RXD_STAT_UDPCS	0x10	/* UDP xsum calculated (82571+) */
 #define E1000_RXD_STAT_TCPCS	0x20	/* TCP xsum calculated */
 #define E1000_RXD_STAT_IPCS	0x40	/* IP xsum calculated */
 #define E1000_RXD_STAT_PIF	0x80	/* passed in-exact filter */
@@ -28,6 +28,7 @@ static int sb_eth_raw_start(struct udevice *dev)
 	debug("eth_sandbox_raw: Start\n");
 
 	ret = sandbox_eth_raw_os_start(priv, pdata->enetaddr);
+	pdata->max_mtu = priv->mtu;
 	if (priv->local) {
 		env_set("ipaddr", "127.0.0.1");
 		env_set("serverip", "127.0.0.1");
@@ -100,6 +101,7 @@ static int sb_eth_raw_recv(struct udevice *dev, int flags, uchar **packetp)
 		uchar *pktptr = priv->local ?
 			net_rx_packets[0] + ETHER_HDR_SIZE : net_rx_packets[0];
 
+		length = net_rx_packets[0] + PKTSIZE_ALIGN - pktptr;
 		retval = sandbox_eth_raw_os_recv(pktptr, &length, priv);
 	}
 
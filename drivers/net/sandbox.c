@@ -346,6 +346,20 @@ static int sb_eth_send(struct udevice *dev, void *packet, int length)
 	return priv->tx_handler(dev, packet, length);
 }
 
+static int sb_eth_send_batch(struct udevice *dev, void **packets,
+			     int *lengths, int count)
+{
+	int i, ret;
+
+	for (i = 0; i < count; i++) {
+		ret = sb_eth_send(dev, packets[i], lengths[i]);
+		if (ret)
+			return i ? i : ret;
+	}
+
+	return count;
+}
+
 static int sb_eth_recv(struct udevice *dev, int flags, uchar **packetp)
 {
 	struct eth_sandbox_priv *priv = dev_get_priv(dev);
@@ -366,6 +380,26 @@ static int sb_eth_recv(struct udevice *dev, int flags, uchar **packetp)
 	return 0;
 }
 
+static int sb_eth_recv_batch(struct udevice *dev, int flags,
+			     struct eth_rx_pkt *pkts, int max)
+{
+	struct eth_sandbox_priv *priv = dev_get_priv(dev);
+	int i;
+
+	if (skip_timeout) {
+		timer_test_add_offset(11000UL);
+		skip_timeout = false;
+	}
+
+	for (i = 0; i < priv->recv_packets && i < max; i++) {
+		pkts[i].packet = priv->recv_packet_buffer[i];
+		pkts[i].length = priv->recv_packet_length[i];
+	}
+	debug("eth_sandbox: received %d packets\n", i);
+
+	return i;
+}
+
 static int sb_eth_free_pkt(struct udevice *dev, uchar *packet, int length)
 {
 	struct eth_sandbox_priv *priv = dev_get_priv(dev);
@@ -404,6 +438,8 @@ static const struct eth_ops sb_eth_ops = {
 	.start			= sb_eth_start,
 	.send			= sb_eth_send,
 	.recv			= sb_eth_recv,
+	.send_batch		= sb_eth_send_batch,
+	.recv_batch		= sb_eth_recv_batch,
 	.free_pkt		= sb_eth_free_pkt,
 	.stop			= sb_eth_stop,
 	.write_hwaddr		= sb_eth_write_hwaddr,
@@ -18,13 +18,13 @@
 #include <linux/compat.h>
 #include "nvme.h"
 
-#define NVME_Q_DEPTH		2
+#define NVME_Q_DEPTH		CONFIG_NVME_QUEUE_DEPTH
 #define NVME_AQ_DEPTH		2
 #define NVME_SQ_SIZE(depth)	(depth * sizeof(struct nvme_command))
 #define NVME_CQ_SIZE(depth)	(depth * sizeof(struct nvme_completion))
 #define ADMIN_TIMEOUT		60
 #define IO_TIMEOUT		30
-#define MAX_PRP_POOL		512
+#define NVME_MAX_TRANSFER_SHIFT	20
 
 enum nvme_queue_id {
 	NVME_ADMIN_Q,
@@ -32,6 +32,18 @@ enum nvme_queue_id {
 	NVME_Q_NUM,
 };
 
+/*
+ * A command slot in an I/O queue. The slot index is used as the command
+ * identifier, so a completion can be matched to its request even when the
+ * controller completes commands out of order. Each slot owns a PRP list so
+ * that several large transfers can be in flight at once.
+ */
+struct nvme_io_slot {
+	u64 *prp_list;
+	u64 slba;
+	bool busy;
+};
+
 /*
  * An NVM Express queue. Each device has at least two (one for admin
  * commands and one for I/O commands).
@@ -50,6 +62,9 @@ struct nvme_queue {
 	u16 qid;
 	u8 cq_phase;
 	u8 cqe_seen;
+	struct nvme_io_slot *slots;
+	u16 nr_busy;
+	bool dead;	/* I/O timed out, the controller has been disabled */
 	unsigned long cmdid_data[];
 };
 
@@ -71,7 +86,7 @@ static int nvme_wait_ready(struct nvme_dev *dev, bool enabled)
 	return -ETIME;
 }
 
-static int nvme_setup_prps(struct nvme_dev *dev, u64 *prp2,
+static int nvme_setup_prps(struct nvme_dev *dev, u64 *prp_list, u64 *prp2,
 			   int total_len, u64 dma_addr)
 {
 	u32 page_size = dev->page_size;
@@ -101,36 +116,28 @@ static int nvme_setup_prps(struct nvme_dev *dev, u64 *prp2,
 	num_pages = DIV_ROUND_UP(nprps, prps_per_page);
 
 	if (nprps > dev->prp_entry_num) {
-		free(dev->prp_pool);
-		/*
-		 * Always increase in increments of pages.  It doesn't waste
-		 * much memory and reduces the number of allocations.
-		 */
-		dev->prp_pool = memalign(page_size, num_pages * page_size);
-		if (!dev->prp_pool) {
-			printf("Error: malloc prp_pool fail\n");
-			return -ENOMEM;
-		}
-		dev->prp_entry_num = prps_per_page * num_pages;
+		printf("Error: transfer needs %d PRP entries, only %u available\n",
+		       nprps, dev->prp_entry_num);
+		return -EINVAL;
 	}
 
-	prp_pool = dev->prp_pool;
+	prp_pool = prp_list;
 	i = 0;
 	while (nprps) {
 		if (i == ((page_size >> 3) - 1)) {
 			*(prp_pool + i) = cpu_to_le64((ulong)prp_pool +
 					page_size);
 			i = 0;
-			prp_pool += page_size;
+			prp_pool += page_size >> 3;
 		}
 		*(prp_pool + i++) = cpu_to_le64(dma_addr);
 		dma_addr += page_size;
 		nprps--;
 	}
-	*prp2 = (ulong)dev->prp_pool;
+	*prp2 = (ulong)prp_list;
 
-	flush_dcache_range((ulong)dev->prp_pool, (ulong)dev->prp_pool +
-			   dev->prp_entry_num * sizeof(u64));
+	flush_dcache_range((ulong)prp_list,
+			   (ulong)prp_list + num_pages * page_size);
 
 	return 0;
 }
@@ -172,6 +179,70 @@ static void nvme_submit_cmd(struct nvme_queue *nvmeq, struct nvme_command *cmd)
 	nvmeq->sq_tail = tail;
 }
 
+/**
+ * nvme_queue_cmd() - copy a command into a queue without ringing the doorbell
+ *
+ * This allows several commands to be made visible to the controller with a
+ * single doorbell write, see nvme_ring_sq().
+ *
+ * @nvmeq:	The queue to use
+ * @cmd:	The command to send
+ */
+static void nvme_queue_cmd(struct nvme_queue *nvmeq, struct nvme_command *cmd)
+{
+	u16 tail = nvmeq->sq_tail;
+
+	memcpy(&nvmeq->sq_cmds[tail], cmd, sizeof(*cmd));
+	flush_dcache_range((ulong)&nvmeq->sq_cmds[tail],
+			   (ulong)&nvmeq->sq_cmds[tail] + sizeof(*cmd));
+
+	if (++tail == nvmeq->q_depth)
+		tail = 0;
+	nvmeq->sq_tail = tail;
+}
+
+static void nvme_ring_sq(struct nvme_queue *nvmeq)
+{
+	writel(nvmeq->sq_tail, nvmeq->q_db);
+}
+
+/**
+ * nvme_poll_cq() - pick up the next completion of a queue, if any
+ *
+ * The completion queue head doorbell is not written, the caller does that
+ * once for a batch of completions with nvme_ring_cq().
+ *
+ * @nvmeq:	The queue to poll
+ * @cmdid:	Returns the command identifier of the completed command
+ * @status:	Returns the status field (without the phase bit)
+ * @return true if a completion was consumed, false if the queue is empty
+ */
+static bool nvme_poll_cq(struct nvme_queue *nvmeq, u16 *cmdid, u16 *status)
+{
+	u16 head = nvmeq->cq_head;
+	u16 val;
+
+	val = nvme_read_completion_status(nvmeq, head);
+	if ((val & 0x01) != nvmeq->cq_phase)
+		return false;
+
+	*status = val >> 1;
+	*cmdid = le16_to_cpu(readw(&nvmeq->cqes[head].command_id));
+
+	if (++head == nvmeq->q_depth) {
+		head = 0;
+		nvmeq->cq_phase = !nvmeq->cq_phase;
+	}
+	nvmeq->cq_head = head;
+
+	return true;
+}
+
+static void nvme_ring_cq(struct nvme_queue *nvmeq)
+{
+	writel(nvmeq->cq_head, nvmeq->q_db + nvmeq->dev->db_stride);
+}
+
 static int nvme_submit_sync_cmd(struct nvme_queue *nvmeq,
 				struct nvme_command *cmd,
 				u32 *result, unsigned timeout)
@@ -310,8 +381,22 @@ static int nvme_disable_ctrl(struct nvme_dev *dev)
 	return nvme_wait_ready(dev, false);
 }
 
+static void nvme_free_slots(struct nvme_queue *nvmeq)
+{
+	int i;
+
+	if (!nvmeq->slots)
+		return;
+
+	for (i = 0; i < nvmeq->q_depth; i++)
+		free(nvmeq->slots[i].prp_list);
+	free(nvmeq->slots);
+	nvmeq->slots = NULL;
+}
+
 static void nvme_free_queue(struct nvme_queue *nvmeq)
 {
+	nvme_free_slots(nvmeq);
 	free((void *)nvmeq->cqes);
 	free(nvmeq->sq_cmds);
 	free(nvmeq);
@@ -623,19 +708,60 @@ static int nvme_get_info_from_identify(struct nvme_dev *dev)
 		 * the following algorithm for maximum number of logic blocks
 		 * per transfer:
 		 *
-		 * u16 lbas = 1 << (dev->max_transfer_shift - ns->lba_shift);
+		 * u32 lbas = 1 << (dev->max_transfer_shift - ns->lba_shift);
 		 *
-		 * In order for lbas not to overflow, the maximum number is 15
-		 * which means dev->max_transfer_shift = 15 + 9 (ns->lba_shift).
+		 * and the command's 16-bit block count must not overflow, so
+		 * the maximum number is 16 which means
+		 * dev->max_transfer_shift = 16 + 9 (ns->lba_shift).
 		 * Let's use 20 which provides 1MB size.
 		 */
 		dev->max_transfer_shift = 20;
 	}
 
+	/*
+	 * Each in-flight command owns a PRP list sized for the largest
+	 * transfer, so keep that bounded; with a deep queue there is little
+	 * to gain from bigger commands.
+	 */
+	if (dev->max_transfer_shift > NVME_MAX_TRANSFER_SHIFT)
+		dev->max_transfer_shift = NVME_MAX_TRANSFER_SHIFT;
+
 	free(ctrl);
 	return 0;
 }
 
+static int nvme_alloc_io_slots(struct nvme_dev *dev)
+{
+	struct nvme_queue *nvmeq = dev->queues[NVME_IO_Q];
+	u32 prps_per_page = (dev->page_size >> 3) - 1;
+	u32 nprps, num_pages;
+	int i;
+
+	if (!nvmeq)
+		return -ENODEV;
+
+	/* one extra entry in case the buffer is not page aligned */
+	nprps = ((1 << dev->max_transfer_shift) / dev->page_size) + 1;
+	num_pages = DIV_ROUND_UP(nprps, prps_per_page);
+	dev->prp_entry_num = prps_per_page * num_pages;
+
+	nvmeq->slots = calloc(nvmeq->q_depth, sizeof(*nvmeq->slots));
+	if (!nvmeq->slots)
+		return -ENOMEM;
+
+	for (i = 0; i < nvmeq->q_depth; i++) {
+		nvmeq->slots[i].prp_list = memalign(dev->page_size,
+						    num_pages * dev->page_size);
+		if (!nvmeq->slots[i].prp_list) {
+			nvme_free_slots(nvmeq);
+			return -ENOMEM;
+		}
+	}
+	nvmeq->nr_busy = 0;
+
+	return 0;
+}
+
 int nvme_get_namespace_id(struct udevice *udev, u32 *ns_id, u8 *eui64)
 {
 	struct nvme_ns *ns = dev_get_priv(udev);
@@ -710,64 +836,151 @@ static int nvme_blk_probe(struct udevice *udev)
 	return 0;
 }
 
+/**
+ * nvme_reap_io() - collect completions of outstanding I/O commands
+ *
+ * @nvmeq:	The I/O queue
+ * @failed_lba:	Updated with the lowest start LBA of a failed command
+ * @wait:	true to wait (up to IO_TIMEOUT) for at least one completion
+ * @return 0 if OK, -ETIMEDOUT if nothing completed in time
+ */
+static int nvme_reap_io(struct nvme_queue *nvmeq, u64 *failed_lba, bool wait)
+{
+	ulong start_time = timer_get_us();
+	ulong timeout_us = IO_TIMEOUT * 100000;
+	struct nvme_io_slot *slot;
+	u16 cmdid, status;
+	int reaped = 0;
+
+	for (;;) {
+		while (nvme_poll_cq(nvmeq, &cmdid, &status)) {
+			reaped++;
+			if (cmdid >= nvmeq->q_depth ||
+			    !nvmeq->slots[cmdid].busy) {
+				printf("ERROR: spurious completion, id = %x\n",
+				       cmdid);
+				continue;
+			}
+			slot = &nvmeq->slots[cmdid];
+			slot->busy = false;
+			nvmeq->nr_busy--;
+			if (status) {
+				printf("ERROR: status = %x, lba = %llx\n",
+				       status, slot->slba);
+				if (slot->slba < *failed_lba)
+					*failed_lba = slot->slba;
+			}
+		}
+		if (reaped) {
+			nvme_ring_cq(nvmeq);
+			return 0;
+		}
+		if (!wait || !nvmeq->nr_busy)
+			return 0;
+		if (timer_get_us() - start_time >= timeout_us)
+			return -ETIMEDOUT;
+	}
+}
+
 static ulong nvme_blk_rw(struct udevice *udev, lbaint_t blknr,
 			 lbaint_t blkcnt, void *buffer, bool read)
 {
 	struct nvme_ns *ns = dev_get_priv(udev);
 	struct nvme_dev *dev = ns->dev;
+	struct nvme_queue *nvmeq = dev->queues[NVME_IO_Q];
 	struct nvme_command c;
 	struct blk_desc *desc = dev_get_uclass_platdata(udev);
-	int status;
+	struct nvme_io_slot *slot;
 	u64 prp2;
 	u64 total_len = blkcnt << desc->log2blksz;
-	u64 temp_len = total_len;
+	void *start = buffer;
 
 	u64 slba = blknr;
-	u16 lbas = 1 << (dev->max_transfer_shift - ns->lba_shift);
-	u64 total_lbas = blkcnt;
+	u64 end = blknr + blkcnt;
+	u64 failed_lba = end;
+	u32 lbas = 1 << (dev->max_transfer_shift - ns->lba_shift);
+	u32 n;
+	u16 cmdid = 0;
+	bool queued;
+
+	if (nvmeq->dead)
+		return 0;
 
 	flush_dcache_range((unsigned long)buffer,
 			   (unsigned long)buffer + total_len);
 
+	memset(&c, 0, sizeof(c));
 	c.rw.opcode = read ? nvme_cmd_read : nvme_cmd_write;
-	c.rw.flags = 0;
 	c.rw.nsid = cpu_to_le32(ns->ns_id);
-	c.rw.control = 0;
-	c.rw.dsmgmt = 0;
-	c.rw.reftag = 0;
-	c.rw.apptag = 0;
-	c.rw.appmask = 0;
-	c.rw.metadata = 0;
-
-	while (total_lbas) {
-		if (total_lbas < lbas) {
-			lbas = (u16)total_lbas;
-			total_lbas = 0;
-		} else {
-			total_lbas -= lbas;
+
+	/*
+	 * Keep up to q_depth - 1 commands in flight (one submission queue
+	 * entry must stay empty to tell a full ring from an empty one),
+	 * ringing the doorbell once per batch of new commands and refilling
+	 * the queue as completions arrive.
+	 */
+	while (slba < end || nvmeq->nr_busy) {
+		queued = false;
+		while (slba < end && failed_lba == end &&
+		       nvmeq->nr_busy < nvmeq->q_depth - 1) {
+			while (nvmeq->slots[cmdid].busy)
+				cmdid = (cmdid + 1) % nvmeq->q_depth;
+			slot = &nvmeq->slots[cmdid];
+
+			n = min_t(u64, lbas, end - slba);
+			if (nvme_setup_prps(dev, slot->prp_list, &prp2,
+					    n << ns->lba_shift,
+					    (ulong)buffer)) {
+				failed_lba = slba;
+				break;
+			}
+			c.rw.command_id = cpu_to_le16(cmdid);
+			c.rw.slba = cpu_to_le64(slba);
+			c.rw.length = cpu_to_le16(n - 1);
+			c.rw.prp1 = cpu_to_le64((ulong)buffer);
+			c.rw.prp2 = cpu_to_le64(prp2);
+			nvme_queue_cmd(nvmeq, &c);
+
+			slot->slba = slba;
+			slot->busy = true;
+			nvmeq->nr_busy++;
+			queued = true;
+
+			slba += n;
+			buffer += n << ns->lba_shift;
 		}
+		if (queued)
+			nvme_ring_sq(nvmeq);
 
-		if (nvme_setup_prps(dev, &prp2,
-				    lbas << ns->lba_shift, (ulong)buffer))
-			return -EIO;
-		c.rw.slba = cpu_to_le64(slba);
-		slba += lbas;
-		c.rw.length = cpu_to_le16(lbas - 1);
-		c.rw.prp1 = cpu_to_le64((ulong)buffer);
-		c.rw.prp2 = cpu_to_le64(prp2);
-		status = nvme_submit_sync_cmd(dev->queues[NVME_IO_Q],
-				&c, NULL, IO_TIMEOUT);
-		if (status)
+		if (!nvmeq->nr_busy)
 			break;
-		temp_len -= (u32)lbas << ns->lba_shift;
-		buffer += lbas << ns->lba_shift;
+
+		if (nvme_reap_io(nvmeq, &failed_lba, true)) {
+			/*
+			 * The controller stopped responding. The outstanding
+			 * commands still own their slots, PRP lists and
+			 * buffers, so disable the controller to make it drop
+			 * them, and fail all further I/O until the device is
+			 * probed again.
+			 */
+			printf("ERROR: I/O timeout, %u commands pending\n",
+			       nvmeq->nr_busy);
+			if (nvme_disable_ctrl(dev))
+				printf("ERROR: cannot disable the controller\n");
+			nvmeq->dead = true;
+			failed_lba = blknr;
+			break;
+		}
 	}
 
+	if (failed_lba > slba)
+		failed_lba = slba;
+
 	if (read)
-		invalidate_dcache_range((unsigned long)buffer,
-					(unsigned long)buffer + total_len);
+		invalidate_dcache_range((unsigned long)start,
+					(unsigned long)start + total_len);
 
-	return (total_len - temp_len) >> desc->log2blksz;
+	return failed_lba - blknr;
 }
 
 static ulong nvme_blk_read(struct udevice *udev, lbaint_t blknr,
@@ -838,21 +1051,19 @@ static int nvme_probe(struct udevice *udev)
 	if (ret)
 		goto free_queue;
 
-	/* Allocate after the page size is known */
-	ndev->prp_pool = memalign(ndev->page_size, MAX_PRP_POOL);
-	if (!ndev->prp_pool) {
-		ret = -ENOMEM;
-		printf("Error: %s: Out of memory!\n", udev->name);
-		goto free_nvme;
-	}
-	ndev->prp_entry_num = MAX_PRP_POOL >> 3;
-
 	ret = nvme_setup_io_queues(ndev);
 	if (ret)
 		goto free_queue;
 
 	nvme_get_info_from_identify(ndev);
 
+	/* Allocate after the page size and transfer size are known */
+	ret = nvme_alloc_io_slots(ndev);
+	if (ret) {
+		printf("Error: %s: Out of memory!\n", udev->name);
+		goto free_queue;
+	}
+
 	return 0;
 
 free_queue:
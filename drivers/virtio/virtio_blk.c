@@ -7,52 +7,156 @@
 #include <common.h>
 #include <blk.h>
 #include <dm.h>
+#include <log.h>
+#include <malloc.h>
 #include <part.h>
 #include <virtio_types.h>
 #include <virtio.h>
 #include <virtio_ring.h>
 #include "virtio_blk.h"
 
+/* Upper limit on the size of a single request, in 512-byte sectors */
+#define VIRTIO_BLK_MAX_REQ_SECTORS	2048
+
+/*
+ * Per-request state that must stay valid while the request is in flight.
+ * The header address doubles as the token virtqueue_get_buf() hands back.
+ */
+struct virtio_blk_req {
+	struct virtio_blk_outhdr out_hdr;
+	u64 sector;
+	u8 status;
+	bool busy;
+};
+
 struct virtio_blk_priv {
 	struct virtqueue *vq;
+	struct virtio_blk_req *reqs;	/* one per ring entry */
+	unsigned int num_reqs;
+	struct virtio_sg *sg;		/* scratch list to build a request */
+	struct virtio_sg **sgs;
+	u32 seg_max;			/* data segments per request */
+	u32 size_max;			/* bytes per data segment */
+	lbaint_t max_sectors;		/* sectors per request */
 };
 
+static int virtio_blk_add_req(struct udevice *dev, struct virtio_blk_req *req,
+			      u64 sector, lbaint_t blkcnt, void *buffer,
+			      u32 type)
+{
+	struct virtio_blk_priv *priv = dev_get_priv(dev);
+	unsigned int num_out = 0, num_in = 0, nsg = 0;
+	ulong len = blkcnt * 512;
+	ulong seg;
+
+	req->out_hdr.type = cpu_to_virtio32(dev, type);
+	req->out_hdr.ioprio = 0;
+	req->out_hdr.sector = cpu_to_virtio64(dev, sector);
+	req->status = VIRTIO_BLK_S_IOERR;
+
+	priv->sg[nsg].addr = &req->out_hdr;
+	priv->sg[nsg].length = sizeof(req->out_hdr);
+	priv->sgs[nsg] = &priv->sg[nsg];
+	nsg++;
+	num_out++;
+
+	/* Split the data into segments no larger than the device allows */
+	while (len) {
+		seg = min_t(ulong, len, priv->size_max);
+		priv->sg[nsg].addr = buffer;
+		priv->sg[nsg].length = seg;
+		priv->sgs[nsg] = &priv->sg[nsg];
+		nsg++;
+		if (type & VIRTIO_BLK_T_OUT)
+			num_out++;
+		else
+			num_in++;
+		buffer += seg;
+		len -= seg;
+	}
+
+	priv->sg[nsg].addr = &req->status;
+	priv->sg[nsg].length = sizeof(req->status);
+	priv->sgs[nsg] = &priv->sg[nsg];
+	num_in++;
+
+	return virtqueue_add(priv->vq, priv->sgs, num_out, num_in);
+}
+
 static ulong virtio_blk_do_req(struct udevice *dev, u64 sector,
 			       lbaint_t blkcnt, void *buffer, u32 type)
 {
 	struct virtio_blk_priv *priv = dev_get_priv(dev);
-	unsigned int num_out = 0, num_in = 0;
-	struct virtio_sg *sgs[3];
-	u8 status;
+	struct virtio_blk_req *req;
+	u64 start = sector;
+	u64 end = sector + blkcnt;
+	u64 failed = end;
+	unsigned int inflight = 0, slot = 0;
+	lbaint_t n;
+	bool queued;
+	void *token;
 	int ret;
 
-	struct virtio_blk_outhdr out_hdr = {
-		.type = cpu_to_virtio32(dev, type),
-		.sector = cpu_to_virtio64(dev, sector),
-	};
-	struct virtio_sg hdr_sg = { &out_hdr, sizeof(out_hdr) };
-	struct virtio_sg data_sg = { buffer, blkcnt * 512 };
-	struct virtio_sg status_sg = { &status, sizeof(status) };
+	/*
+	 * Split the transfer into requests of up to max_sectors, put as
+	 * many in the ring as fit, kick the device once for the batch and
+	 * top the ring up again as completions come back.
+	 */
+	while (sector < end || inflight) {
+		queued = false;
+		while (sector < end && failed == end &&
+		       inflight < priv->num_reqs) {
+			while (priv->reqs[slot].busy)
+				slot = (slot + 1) % priv->num_reqs;
+			req = &priv->reqs[slot];
 
-	sgs[num_out++] = &hdr_sg;
+			n = min_t(u64, priv->max_sectors, end - sector);
+			ret = virtio_blk_add_req(dev, req, sector, n, buffer,
+						 type);
+			if (ret == -ENOSPC)
+				break;
+			if (ret) {
+				failed = sector;
+				break;
+			}
+			req->sector = sector;
+			req->busy = true;
+			inflight++;
+			queued = true;
 
-	if (type & VIRTIO_BLK_T_OUT)
-		sgs[num_out++] = &data_sg;
-	else
-		sgs[num_out + num_in++] = &data_sg;
+			sector += n;
+			buffer += n * 512;
+		}
+		if (queued)
+			virtqueue_kick(priv->vq);
 
-	sgs[num_out + num_in++] = &status_sg;
+		if (!inflight)
+			break;
 
-	ret = virtqueue_add(priv->vq, sgs, num_out, num_in);
-	if (ret)
-		return ret;
+		while (!(token = virtqueue_get_buf(priv->vq, NULL)))
+			;
 
-	virtqueue_kick(priv->vq);
+		do {
+			req = container_of(token, struct virtio_blk_req,
+					   out_hdr);
+			if (req < priv->reqs ||
+			    req >= priv->reqs + priv->num_reqs || !req->busy) {
+				printf("%s: unexpected buffer %p\n", dev->name,
+				       token);
+				continue;
+			}
+			req->busy = false;
+			inflight--;
+			if (req->status != VIRTIO_BLK_S_OK &&
+			    req->sector < failed)
+				failed = req->sector;
+		} while ((token = virtqueue_get_buf(priv->vq, NULL)));
+	}
 
-	while (!virtqueue_get_buf(priv->vq, NULL))
-		;
+	if (failed > sector)
+		failed = sector;
 
-	return status == VIRTIO_BLK_S_OK ? blkcnt : -EIO;
+	return failed - start;
 }
 
 static ulong virtio_blk_read(struct udevice *dev, lbaint_t start,
@@ -69,6 +173,11 @@ static ulong virtio_blk_write(struct udevice *dev, lbaint_t start,
 				 VIRTIO_BLK_T_OUT);
 }
 
+static const u32 feature[] = {
+	VIRTIO_BLK_F_SIZE_MAX,
+	VIRTIO_BLK_F_SEG_MAX,
+};
+
 static int virtio_blk_bind(struct udevice *dev)
 {
 	struct virtio_dev_priv *uc_priv = dev_get_uclass_priv(dev->parent);
@@ -98,7 +207,8 @@ static int virtio_blk_bind(struct udevice *dev)
 	desc->bdev = dev;
 
 	/* Indicate what driver features we support */
-	virtio_driver_features_init(uc_priv, NULL, 0, NULL, 0);
+	virtio_driver_features_init(uc_priv, feature, ARRAY_SIZE(feature),
+				    NULL, 0);
 
 	return 0;
 }
@@ -107,6 +217,8 @@ static int virtio_blk_probe(struct udevice *dev)
 {
 	struct virtio_blk_priv *priv = dev_get_priv(dev);
 	struct blk_desc *desc = dev_get_uclass_platdata(dev);
+	unsigned int ring_size;
+	u64 max_bytes;
 	u64 cap;
 	int ret;
 
@@ -118,9 +230,66 @@ static int virtio_blk_probe(struct udevice *dev)
 	virtio_cread(dev, struct virtio_blk_config, capacity, &cap);
 	desc->lba = cap;
 
+	ring_size = virtqueue_get_vring_size(priv->vq);
+
+	/* Without VIRTIO_BLK_F_SEG_MAX only one data segment is allowed */
+	priv->seg_max = 1;
+	if (virtio_has_feature(dev, VIRTIO_BLK_F_SEG_MAX)) {
+		virtio_cread(dev, struct virtio_blk_config, seg_max,
+			     &priv->seg_max);
+		if (!priv->seg_max)
+			priv->seg_max = 1;
+	}
+	/* A direct request also needs a descriptor for header and status */
+	if (!priv->vq->indirect && priv->seg_max > ring_size - 2)
+		priv->seg_max = ring_size - 2;
+
+	priv->size_max = U32_MAX;
+	if (virtio_has_feature(dev, VIRTIO_BLK_F_SIZE_MAX)) {
+		virtio_cread(dev, struct virtio_blk_config, size_max,
+			     &priv->size_max);
+		priv->size_max &= ~511;
+		if (!priv->size_max)
+			priv->size_max = 512;
+	}
+
+	max_bytes = (u64)priv->seg_max * priv->size_max;
+	priv->max_sectors = min_t(u64, max_bytes / 512,
+				  VIRTIO_BLK_MAX_REQ_SECTORS);
+
+	/* There can never be more requests in flight than ring entries */
+	priv->num_reqs = ring_size;
+	priv->reqs = calloc(priv->num_reqs, sizeof(*priv->reqs));
+	priv->sg = calloc(priv->seg_max + 2, sizeof(*priv->sg));
+	priv->sgs = calloc(priv->seg_max + 2, sizeof(*priv->sgs));
+	if (!priv->reqs || !priv->sg || !priv->sgs) {
+		free(priv->reqs);
+		free(priv->sg);
+		free(priv->sgs);
+		return -ENOMEM;
+	}
+
+	debug("%s: %u ring entries, %u sectors per request%s\n", dev->name,
+	      ring_size, (uint)priv->max_sectors,
+	      priv->vq->indirect ? ", indirect" : "");
+
 	return 0;
 }
 
+static int virtio_blk_remove(struct udevice *dev)
+{
+	struct virtio_blk_priv *priv = dev_get_priv(dev);
+
+	free(priv->reqs);
+	free(priv->sg);
+	free(priv->sgs);
+	priv->reqs = NULL;
+	priv->sg = NULL;
+	priv->sgs = NULL;
+
+	return virtio_reset(dev);
+}
+
 static const struct blk_ops virtio_blk_ops = {
 	.read	= virtio_blk_read,
 	.write	= virtio_blk_write,
@@ -132,7 +301,7 @@ U_BOOT_DRIVER(virtio_blk) = {
 	.ops	= &virtio_blk_ops,
 	.bind	= virtio_blk_bind,
 	.probe	= virtio_blk_probe,
-	.remove	= virtio_reset,
+	.remove	= virtio_blk_remove,
 	.priv_auto_alloc_size = sizeof(struct virtio_blk_priv),
 	.flags	= DM_FLAG_ACTIVE_DMA,
 };
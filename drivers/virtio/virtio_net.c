@@ -6,6 +6,7 @@
 
 #include <common.h>
 #include <dm.h>
+#include <malloc.h>
 #include <net.h>
 #include <virtio_types.h>
 #include <virtio.h>
@@ -18,8 +19,23 @@
 /*
  * This value comes from the VirtIO spec: 1500 for maximum packet size,
  * 14 for the Ethernet header, 12 for virtio_net_hdr. In total 1526 bytes.
+ * The packet size follows NET_MTU, or the mtu of the device when
+ * VIRTIO_NET_F_MTU is negotiated, see virtio_net_probe().
  */
-#define VIRTIO_NET_RX_BUF_SIZE	1526
+#define VIRTIO_NET_RX_BUF_SIZE(mtu)	\
+	(sizeof(struct virtio_net_hdr_v1) + ETHER_HDR_SIZE + (mtu))
+
+/*
+ * Frames are copied to driver-owned buffers behind their virtio_net_hdr, so
+ * that send() can return before the device has consumed them. Completed
+ * buffers are reaped when more are needed.
+ */
+#define VIRTIO_NET_NUM_TX_BUFS	16
+#define VIRTIO_NET_TX_BUF_SIZE	\
+	(sizeof(struct virtio_net_hdr_v1) + PKTSIZE_ALIGN)
+
+/* How long to wait for the device to free a transmit buffer, in ms */
+#define VIRTIO_NET_TX_TIMEOUT	1000
 
 struct virtio_net_priv {
 	union {
@@ -30,22 +46,32 @@ struct virtio_net_priv {
 		};
 	};
 
-	char rx_buff[VIRTIO_NET_NUM_RX_BUFS][VIRTIO_NET_RX_BUF_SIZE];
+	char *rx_buff;		/* VIRTIO_NET_NUM_RX_BUFS of rx_buf_size */
+	unsigned int rx_buf_size;
+	char tx_buff[VIRTIO_NET_NUM_TX_BUFS][VIRTIO_NET_TX_BUF_SIZE];
+	u32 tx_busy;		/* bitmap of tx_buff[] owned by the device */
+	u32 rx_out;		/* bitmap of rx_buff[] handed to the stack */
 	bool rx_running;
 	int net_hdr_len;
 };
 
 /*
- * For simplicity, the driver only negotiates the VIRTIO_NET_F_MAC feature.
- * For the VIRTIO_NET_F_STATUS feature, we don't negotiate it, hence per spec
- * we should assume the link is always active.
+ * For simplicity, the driver only negotiates the VIRTIO_NET_F_MAC feature,
+ * VIRTIO_NET_F_GUEST_CSUM to learn which received packets have correct
+ * checksums and VIRTIO_NET_F_MTU to learn whether jumbo frames can be used.
+ * For the VIRTIO_NET_F_STATUS feature, we don't negotiate it, hence per
+ * spec we should assume the link is always active.
  */
 static const u32 feature[] = {
-	VIRTIO_NET_F_MAC
+	VIRTIO_NET_F_MAC,
+	VIRTIO_NET_F_GUEST_CSUM,
+	VIRTIO_NET_F_MTU
 };
 
 static const u32 feature_legacy[] = {
-	VIRTIO_NET_F_MAC
+	VIRTIO_NET_F_MAC,
+	VIRTIO_NET_F_GUEST_CSUM,
+	VIRTIO_NET_F_MTU
 };
 
 static int virtio_net_start(struct udevice *dev)
@@ -55,13 +81,25 @@ static int virtio_net_start(struct udevice *dev)
 	struct virtio_sg *sgs[] = { &sg };
 	int i;
 
+	/* Take back buffers the stack did not give back before a restart */
+	if (priv->rx_out) {
+		sg.length = priv->rx_buf_size;
+		for (i = 0; i < VIRTIO_NET_NUM_RX_BUFS; i++) {
+			if (priv->rx_out & BIT(i)) {
+				sg.addr = priv->rx_buff + i * priv->rx_buf_size;
+				virtqueue_add(priv->rx_vq, sgs, 0, 1);
+			}
+		}
+		priv->rx_out = 0;
+		virtqueue_kick(priv->rx_vq);
+	}
+
 	if (!priv->rx_running) {
-		/* receive buffer length is always 1526 */
-		sg.length = VIRTIO_NET_RX_BUF_SIZE;
+		sg.length = priv->rx_buf_size;
 
 		/* setup the receive buffer address */
 		for (i = 0; i < VIRTIO_NET_NUM_RX_BUFS; i++) {
-			sg.addr = priv->rx_buff[i];
+			sg.addr = priv->rx_buff + i * priv->rx_buf_size;
 			virtqueue_add(priv->rx_vq, sgs, 0, 1);
 		}
 
@@ -74,62 +112,198 @@ static int virtio_net_start(struct udevice *dev)
 	return 0;
 }
 
-static int virtio_net_send(struct udevice *dev, void *packet, int length)
+static void virtio_net_tx_reap(struct virtio_net_priv *priv)
 {
-	struct virtio_net_priv *priv = dev_get_priv(dev);
-	struct virtio_net_hdr hdr;
-	struct virtio_net_hdr_v1 hdr_v1;
-	struct virtio_sg hdr_sg;
-	struct virtio_sg data_sg = { packet, length };
+	char *buf;
+
+	while ((buf = virtqueue_get_buf(priv->tx_vq, NULL))) {
+		int i = (buf - priv->tx_buff[0]) / VIRTIO_NET_TX_BUF_SIZE;
+
+		priv->tx_busy &= ~BIT(i);
+	}
+}
+
+/* Queue a frame without notifying the device */
+static int virtio_net_tx_add(struct virtio_net_priv *priv, void *packet,
+			     int length)
+{
+	const u32 all = BIT(VIRTIO_NET_NUM_TX_BUFS) - 1;
+	struct virtio_sg hdr_sg, data_sg;
 	struct virtio_sg *sgs[] = { &hdr_sg, &data_sg };
-	int ret;
+	ulong start;
+	char *buf;
+	int i, ret;
+
+	if (length > PKTSIZE_ALIGN)
+		return -EINVAL;
+
+	virtio_net_tx_reap(priv);
+	if (priv->tx_busy == all) {
+		/* make sure the device has seen what it is waiting for */
+		virtqueue_kick(priv->tx_vq);
+		start = get_timer(0);
+		while (priv->tx_busy == all) {
+			if (get_timer(start) > VIRTIO_NET_TX_TIMEOUT)
+				return -ETIMEDOUT;
+			virtio_net_tx_reap(priv);
+		}
+	}
 
-	if (priv->net_hdr_len == sizeof(struct virtio_net_hdr))
-		hdr_sg.addr = &hdr;
-	else
-		hdr_sg.addr = &hdr_v1;
-	hdr_sg.length = priv->net_hdr_len;
+	i = ffs(~priv->tx_busy) - 1;
+	buf = priv->tx_buff[i];
+	memset(buf, 0, priv->net_hdr_len);
+	memcpy(buf + priv->net_hdr_len, packet, length);
 
-	memset(hdr_sg.addr, 0, priv->net_hdr_len);
+	hdr_sg.addr = buf;
+	hdr_sg.length = priv->net_hdr_len;
+	data_sg.addr = buf + priv->net_hdr_len;
+	data_sg.length = length;
 
 	ret = virtqueue_add(priv->tx_vq, sgs, 2, 0);
+	if (ret)
+		return ret;
+	priv->tx_busy |= BIT(i);
+
+	return 0;
+}
+
+static int virtio_net_send(struct udevice *dev, void *packet, int length)
+{
+	struct virtio_net_priv *priv = dev_get_priv(dev);
+	int ret;
+
+	ret = virtio_net_tx_add(priv, packet, length);
 	if (ret)
 		return ret;
 
 	virtqueue_kick(priv->tx_vq);
 
-	while (1) {
-		if (virtqueue_get_buf(priv->tx_vq, NULL))
+	return 0;
+}
+
+static int virtio_net_send_batch(struct udevice *dev, void **packets,
+				 int *lengths, int count)
+{
+	struct virtio_net_priv *priv = dev_get_priv(dev);
+	int ret = 0;
+	int i;
+
+	for (i = 0; i < count; i++) {
+		ret = virtio_net_tx_add(priv, packets[i], lengths[i]);
+		if (ret)
 			break;
 	}
 
-	return 0;
+	if (i)
+		virtqueue_kick(priv->tx_vq);
+
+	return i ? i : ret;
 }
 
-static int virtio_net_recv(struct udevice *dev, int flags, uchar **packetp)
+/*
+ * Packets from the host itself may only carry the sum of the pseudo-header
+ * in their UDP or TCP checksum, which is completed here so that nobody sees
+ * a wrong checksum. Returns the ETH_CSUM_... flags of the packet.
+ */
+static uint virtio_net_rx_csum(struct udevice *dev,
+			       struct virtio_net_hdr *hdr, uchar *pkt, int len)
+{
+	uint start, offset;
+	u16 sum;
+
+	if (hdr->flags & VIRTIO_NET_HDR_F_DATA_VALID)
+		return ETH_CSUM_L4;
+	if (!(hdr->flags & VIRTIO_NET_HDR_F_NEEDS_CSUM))
+		return 0;
+
+	start = virtio16_to_cpu(dev, hdr->csum_start);
+	offset = virtio16_to_cpu(dev, hdr->csum_offset);
+	if ((start & 1) || start + offset + sizeof(sum) > len)
+		return 0;
+
+	sum = compute_ip_checksum(pkt + start, len - start);
+	/* zero means no checksum for UDP */
+	if (!sum)
+		sum = 0xffff;
+	memcpy(pkt + start + offset, &sum, sizeof(sum));
+
+	return ETH_CSUM_L4;
+}
+
+static int virtio_net_recv_pkt(struct udevice *dev, uchar **packetp,
+			       uint *csum)
 {
 	struct virtio_net_priv *priv = dev_get_priv(dev);
+	struct virtio_sg sg = { NULL, priv->rx_buf_size };
+	struct virtio_sg *sgs[] = { &sg };
 	unsigned int len;
 	void *buf;
 
-	buf = virtqueue_get_buf(priv->rx_vq, &len);
-	if (!buf)
-		return -EAGAIN;
+	while (1) {
+		buf = virtqueue_get_buf(priv->rx_vq, &len);
+		if (!buf)
+			return -EAGAIN;
+		/* the device mtu may exceed what the stack is built for */
+		if (len - priv->net_hdr_len <= PKTSIZE)
+			break;
+		sg.addr = buf;
+		virtqueue_add(priv->rx_vq, sgs, 0, 1);
+		virtqueue_kick(priv->rx_vq);
+	}
 
+	priv->rx_out |= BIT(((char *)buf - priv->rx_buff) / priv->rx_buf_size);
 	*packetp = buf + priv->net_hdr_len;
-	return len - priv->net_hdr_len;
+	len -= priv->net_hdr_len;
+	*csum = virtio_net_rx_csum(dev, buf, *packetp, len);
+
+	return len;
+}
+
+static int virtio_net_recv(struct udevice *dev, int flags, uchar **packetp)
+{
+	uint csum;
+
+	return virtio_net_recv_pkt(dev, packetp, &csum);
+}
+
+static int virtio_net_recv_batch(struct udevice *dev, int flags,
+				 struct eth_rx_pkt *pkts, int max)
+{
+	int i;
+
+	for (i = 0; i < max; i++) {
+		pkts[i].length = virtio_net_recv_pkt(dev, &pkts[i].packet,
+						     &pkts[i].csum);
+		if (pkts[i].length < 0)
+			break;
+	}
+
+	return i ? i : -EAGAIN;
 }
 
 static int virtio_net_free_pkt(struct udevice *dev, uchar *packet, int length)
 {
 	struct virtio_net_priv *priv = dev_get_priv(dev);
 	void *buf = packet - priv->net_hdr_len;
-	struct virtio_sg sg = { buf, VIRTIO_NET_RX_BUF_SIZE };
+	struct virtio_sg sg = { buf, priv->rx_buf_size };
 	struct virtio_sg *sgs[] = { &sg };
+	u32 bit = BIT(((char *)buf - priv->rx_buff) / priv->rx_buf_size);
+
+	/* Already taken back by virtio_net_start() */
+	if (!(priv->rx_out & bit))
+		return 0;
+	priv->rx_out &= ~bit;
 
 	/* Put the buffer back to the rx ring */
 	virtqueue_add(priv->rx_vq, sgs, 0, 1);
 
+	/*
+	 * Let the device know once the whole batch is back, in case it ran
+	 * out of buffers and is waiting for more
+	 */
+	if (!priv->rx_out)
+		virtqueue_kick(priv->rx_vq);
+
 	return 0;
 }
 
@@ -194,6 +368,7 @@ static int virtio_net_bind(struct udevice *dev)
 static int virtio_net_probe(struct udevice *dev)
 {
 	struct virtio_net_priv *priv = dev_get_priv(dev);
+	struct eth_pdata *pdata = dev_get_platdata(dev);
 	struct virtio_dev_priv *uc_priv = dev_get_uclass_priv(dev->parent);
 	int ret;
 
@@ -213,13 +388,50 @@ static int virtio_net_probe(struct udevice *dev)
 	else
 		priv->net_hdr_len = sizeof(struct virtio_net_hdr_v1);
 
+	if (virtio_has_feature(dev, VIRTIO_NET_F_GUEST_CSUM))
+		pdata->rx_csum = ETH_CSUM_L4;
+
+	/*
+	 * Having negotiated VIRTIO_NET_F_MTU, the buffers must hold a packet
+	 * of the device mtu, even if it is larger than NET_MTU. Such packets
+	 * are dropped by virtio_net_recv_pkt().
+	 */
+	priv->rx_buf_size = VIRTIO_NET_RX_BUF_SIZE(NET_MTU);
+	if (virtio_has_feature(dev, VIRTIO_NET_F_MTU)) {
+		u16 mtu;
+
+		virtio_cread(dev, struct virtio_net_config, mtu, &mtu);
+		pdata->max_mtu = mtu;
+		priv->rx_buf_size = VIRTIO_NET_RX_BUF_SIZE(mtu);
+	}
+
+	priv->rx_buff = malloc(VIRTIO_NET_NUM_RX_BUFS * priv->rx_buf_size);
+	if (!priv->rx_buff) {
+		virtio_del_vqs(dev);
+		return -ENOMEM;
+	}
+
 	return 0;
 }
 
+static int virtio_net_remove(struct udevice *dev)
+{
+	struct virtio_net_priv *priv = dev_get_priv(dev);
+	int ret;
+
+	/* Stop the device before it can write to the buffers again */
+	ret = virtio_reset(dev);
+	free(priv->rx_buff);
+
+	return ret;
+}
+
 static const struct eth_ops virtio_net_ops = {
 	.start = virtio_net_start,
 	.send = virtio_net_send,
 	.recv = virtio_net_recv,
+	.send_batch = virtio_net_send_batch,
+	.recv_batch = virtio_net_recv_batch,
 	.free_pkt = virtio_net_free_pkt,
 	.stop = virtio_net_stop,
 	.write_hwaddr = virtio_net_write_hwaddr,
@@ -231,7 +443,7 @@ U_BOOT_DRIVER(virtio_net) = {
 	.id	= UCLASS_ETH,
 	.bind	= virtio_net_bind,
 	.probe	= virtio_net_probe,
-	.remove = virtio_reset,
+	.remove = virtio_net_remove,
 	.ops	= &virtio_net_ops,
 	.priv_auto_alloc_size = sizeof(struct virtio_net_priv),
 	.platdata_auto_alloc_size = sizeof(struct eth_pdata),
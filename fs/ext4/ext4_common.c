@@ -1642,6 +1642,58 @@ int ext4fs_read_inode(struct ext2_data *data, int ino, struct ext2_inode *inode)
 	return 1;
 }
 
+/*
+ * Map 'fileblock' of an extent-mapped inode to a filesystem block, like
+ * read_allocated_block(), and also return in *count how many file blocks
+ * starting at 'fileblock' are covered by the same mapping: blocks that are
+ * contiguous on disk, or the length of the hole when 0 is returned.
+ */
+long int read_allocated_extent(struct ext2_inode *inode, int fileblock,
+			       struct ext_block_cache *cache, long int *count)
+{
+	long int startblock, endblock;
+	struct ext4_extent_header *ext_block;
+	struct ext4_extent *extent;
+	unsigned long long start;
+	int log2_blksz;
+	int i;
+
+	log2_blksz = LOG2_BLOCK_SIZE(ext4fs_root)
+		- get_fs()->dev_desc->log2blksz;
+
+	ext_block = ext4fs_get_extent_block(ext4fs_root, cache,
+					    (struct ext4_extent_header *)
+					    inode->b.blocks.dir_blocks,
+					    fileblock, log2_blksz);
+	if (!ext_block) {
+		printf("invalid extent block\n");
+		return -EINVAL;
+	}
+
+	extent = (struct ext4_extent *)(ext_block + 1);
+
+	for (i = 0; i < le16_to_cpu(ext_block->eh_entries); i++) {
+		startblock = le32_to_cpu(extent[i].ee_block);
+		endblock = startblock + le16_to_cpu(extent[i].ee_len);
+
+		if (startblock > fileblock) {
+			/* Sparse file, the hole ends at this extent */
+			*count = startblock - fileblock;
+			return 0;
+		} else if (fileblock < endblock) {
+			start = le16_to_cpu(extent[i].ee_start_hi);
+			start = (start << 32) +
+				le32_to_cpu(extent[i].ee_start_lo);
+			*count = endblock - fileblock;
+			return (fileblock - startblock) + start;
+		}
+	}
+
+	/* Past the last extent of this leaf, the next one may be in another */
+	*count = 1;
+	return 0;
+}
+
 long int read_allocated_block(struct ext2_inode *inode, int fileblock,
 			      struct ext_block_cache *cache)
 {
@@ -2341,6 +2393,9 @@ int ext4fs_open(const char *filename, loff_t *len)
 	if (ext4fs_root == NULL)
 		return -1;
 
+	/* Drop the node of a previous open that was not closed */
+	if (ext4fs_file)
+		ext4fs_free_node(ext4fs_file, &ext4fs_root->diropen);
 	ext4fs_file = NULL;
 	status = ext4fs_find_file(filename, &ext4fs_root->diropen, &fdiro,
 				  FILETYPE_REG);
@@ -44,6 +44,83 @@ void ext4fs_free_node(struct ext2fs_node *node, struct ext2fs_node *currroot)
 		free(node);
 }
 
+/* Largest single device read issued by ext4fs_read_extents() */
+#define EXT4_MAX_RUN	(1 << 30)
+
+/*
+ * Read 'len' bytes at 'pos' of an extent-mapped file. The extent tree is
+ * used to map whole runs of blocks at once; runs which are contiguous on
+ * disk, even across extents, are read with a single device read straight
+ * into 'buf' and holes are zero-filled.
+ */
+static int ext4fs_read_extents(struct ext2fs_node *node, loff_t pos,
+			       loff_t len, char *buf)
+{
+	int log2blksz = get_fs()->dev_desc->log2blksz;
+	int log2_fs_blocksize = LOG2_BLOCK_SIZE(node->data);
+	int blocksize = 1 << log2_fs_blocksize;
+	int fileblock = pos >> log2_fs_blocksize;
+	int skipfirst = pos & (blocksize - 1);
+	lbaint_t run_start = 0, run_next = 0;
+	loff_t run_len = 0;
+	int run_skip = 0;
+	char *run_buf = NULL;
+	struct ext_block_cache cache;
+	int ret = -1;
+
+	ext_cache_init(&cache);
+
+	while (len > 0) {
+		long int blknr, count;
+		loff_t bytes;
+
+		blknr = read_allocated_extent(&node->inode, fileblock, &cache,
+					      &count);
+		if (blknr < 0)
+			goto out;
+
+		if (count > EXT4_MAX_RUN >> log2_fs_blocksize)
+			count = EXT4_MAX_RUN >> log2_fs_blocksize;
+		bytes = ((loff_t)count << log2_fs_blocksize) - skipfirst;
+		if (bytes > len)
+			bytes = len;
+
+		/* Flush the pending run if this one does not extend it */
+		if (run_len && (!blknr || run_next != blknr ||
+				run_len + bytes > EXT4_MAX_RUN)) {
+			if (!ext4fs_devread(run_start, run_skip, run_len,
+					    run_buf))
+				goto out;
+			run_len = 0;
+		}
+
+		if (blknr) {
+			if (!run_len) {
+				run_start = (lbaint_t)blknr <<
+					    (log2_fs_blocksize - log2blksz);
+				run_skip = skipfirst;
+				run_buf = buf;
+			}
+			run_len += bytes;
+			run_next = blknr + count;
+		} else {
+			memset(buf, 0, bytes);
+		}
+		buf += bytes;
+		len -= bytes;
+		fileblock += count;
+		skipfirst = 0;
+	}
+
+	if (run_len && !ext4fs_devread(run_start, run_skip, run_len, run_buf))
+		goto out;
+
+	ret = 0;
+out:
+	ext_cache_fini(&cache);
+	return ret;
+}
+
 /*
  * Taken from openmoko-kernel mailing list: By Andy green
  * Optimized read file API : collects and defers contiguous sector
@@ -80,6 +157,14 @@ int ext4fs_read_file(struct ext2fs_node *node, loff_t pos,
 		return -1;
 	}
 
+	if (le32_to_cpu(node->inode.flags) & EXT4_EXTENTS_FL) {
+		ext_cache_fini(&cache);
+		if (ext4fs_read_extents(node, pos, len, buf))
+			return -1;
+		*actread = len;
+		return 0;
+	}
+
 	blockcnt = lldiv(((len + pos) + blocksize - 1), blocksize);
 
 	for (i = lldiv(pos, blocksize); i < blockcnt; i++) {
@@ -147,6 +147,7 @@ static void get_name(dir_entry *dirent, char *s_name)
 }
 
 static int flush_dirty_fat_buffer(fsdata *mydata);
+static int flush_fat_window(fsdata *mydata, struct fat_cache_window *win);
 
 #if !CONFIG_IS_ENABLED(FAT_WRITE)
 /* Stub for read only operation */
@@ -155,14 +156,91 @@ int flush_dirty_fat_buffer(fsdata *mydata)
 	(void)(mydata);
 	return 0;
 }
+
+static int flush_fat_window(fsdata *mydata, struct fat_cache_window *win)
+{
+	return 0;
+}
 #endif
 
+/*
+ * Allocate the FAT cache and mark all of its windows unused.
+ * Return 0 on success, -1 otherwise.
+ */
+static int fat_cache_init(fsdata *mydata)
+{
+	int i;
+
+	for (i = 0; i < FATBUFWINDOWS; i++) {
+		mydata->fatwin[i].bufnum = -1;
+		mydata->fatwin[i].dirty = 0;
+		mydata->fatwin[i].stamp = 0;
+	}
+	mydata->fatstamp = 0;
+	mydata->fat_dirty = 0;
+
+	mydata->fatbuf = malloc_cache_aligned(FATBUFSIZE * FATBUFWINDOWS);
+	if (!mydata->fatbuf) {
+		debug("Error: allocating memory\n");
+		return -1;
+	}
+
+	return 0;
+}
+
+/*
+ * Return the buffer caching window 'bufnum' of the FAT, reading it from
+ * disk if needed. When no window is free the least recently used one is
+ * written back, if dirty, and reused. On failure NULL is returned.
+ */
+static __u8 *fat_cache_get(fsdata *mydata, __u32 bufnum)
+{
+	struct fat_cache_window *win, *victim = NULL;
+	__u32 getsize = FATBUFBLOCKS;
+	__u32 startblock = bufnum * FATBUFBLOCKS;
+	__u8 *bufptr;
+	int i;
+
+	for (i = 0; i < FATBUFWINDOWS; i++) {
+		win = &mydata->fatwin[i];
+		if (win->bufnum == (int)bufnum) {
+			win->stamp = ++mydata->fatstamp;
+			return mydata->fatbuf + i * FATBUFSIZE;
+		}
+		/* unused windows have a zero stamp and are picked first */
+		if (!victim || win->stamp < victim->stamp)
+			victim = win;
+	}
+
+	/* Write back the evicted window to the disk */
+	if (flush_fat_window(mydata, victim) < 0)
+		return NULL;
+
+	/* Cap length if fatlength is not a multiple of FATBUFBLOCKS */
+	if (startblock + getsize > mydata->fatlength)
+		getsize = mydata->fatlength - startblock;
+
+	startblock += mydata->fat_sect;	/* Offset from start of disk */
+
+	bufptr = mydata->fatbuf + (victim - mydata->fatwin) * FATBUFSIZE;
+	victim->bufnum = -1;
+	if (disk_read(startblock, getsize, bufptr) < 0) {
+		debug("Error reading FAT blocks\n");
+		return NULL;
+	}
+	victim->bufnum = bufnum;
+	victim->stamp = ++mydata->fatstamp;
+
+	return bufptr;
+}
+
 /*
  * Get the entry at index 'entry' in a FAT (12/16/32) table.
  * On failure 0x00 is returned.
  */
 static __u32 get_fatent(fsdata *mydata, __u32 entry)
 {
+	__u8 *fatbuf;
 	__u32 bufnum;
 	__u32 offset, off8;
 	__u32 ret = 0x00;
@@ -194,42 +272,23 @@ static __u32 get_fatent(fsdata *mydata, __u32 entry)
 	debug("FAT%d: entry: 0x%08x = %d, offset: 0x%04x = %d\n",
 	       mydata->fatsize, entry, entry, offset, offset);
 
-	/* Read a new block of FAT entries into the cache. */
-	if (bufnum != mydata->fatbufnum) {
-		__u32 getsize = FATBUFBLOCKS;
-		__u8 *bufptr = mydata->fatbuf;
-		__u32 fatlength = mydata->fatlength;
-		__u32 startblock = bufnum * FATBUFBLOCKS;
-
-		/* Cap length if fatlength is not a multiple of FATBUFBLOCKS */
-		if (startblock + getsize > fatlength)
-			getsize = fatlength - startblock;
-
-		startblock += mydata->fat_sect;	/* Offset from start of disk */
-
-		/* Write back the fatbuf to the disk */
-		if (flush_dirty_fat_buffer(mydata) < 0)
-			return -1;
-
-		if (disk_read(startblock, getsize, bufptr) < 0) {
-			debug("Error reading FAT blocks\n");
-			return ret;
-		}
-		mydata->fatbufnum = bufnum;
-	}
+	/* Look the window of FAT entries up in the cache. */
+	fatbuf = fat_cache_get(mydata, bufnum);
+	if (!fatbuf)
+		return ret;
 
 	/* Get the actual entry from the table */
 	switch (mydata->fatsize) {
 	case 32:
-		ret = FAT2CPU32(((__u32 *) mydata->fatbuf)[offset]);
+		ret = FAT2CPU32(((__u32 *)fatbuf)[offset]);
 		break;
 	case 16:
-		ret = FAT2CPU16(((__u16 *) mydata->fatbuf)[offset]);
+		ret = FAT2CPU16(((__u16 *)fatbuf)[offset]);
 		break;
 	case 12:
 		off8 = (offset * 3) / 2;
 		/* fatbut + off8 may be unaligned, read in byte granularity */
-		ret = mydata->fatbuf[off8] + (mydata->fatbuf[off8 + 1] << 8);
+		ret = fatbuf[off8] + (fatbuf[off8 + 1] << 8);
 
 		if (offset & 0x1)
 			ret >>= 4;
@@ -303,6 +362,64 @@ get_cluster(fsdata *mydata, __u32 clustnum, __u8 *buffer, unsigned long size)
 	return 0;
 }
 
+/* Run of contiguous clusters in a cluster chain */
+struct fat_extent {
+	__u32 clust;	/* First cluster of the run */
+	__u32 count;	/* Number of clusters in the run */
+};
+
+#define FAT_EXTENTS	32
+
+/**
+ * get_extents() - map a cluster chain to runs of contiguous clusters
+ *
+ * Walk the chain starting at 'clust' far enough to cover 'size' bytes, or
+ * until 'max' runs have been found. The FAT is not read past the last
+ * cluster that is needed.
+ *
+ * @mydata:	file system description
+ * @clust:	first cluster of the chain
+ * @size:	number of bytes to map
+ * @ext:	array receiving the runs
+ * @max:	number of entries in 'ext'
+ * @next:	set to the cluster following the last run if 'ext' filled up
+ * Return:	number of runs found, -1 on an invalid chain
+ */
+static int get_extents(fsdata *mydata, __u32 clust, loff_t size,
+		       struct fat_extent *ext, int max, __u32 *next)
+{
+	unsigned int bytesperclust = mydata->clust_size * mydata->sect_size;
+	__u32 newclust;
+	int n = 0;
+
+	ext[0].clust = clust;
+	ext[0].count = 1;
+
+	while (size > bytesperclust) {
+		newclust = get_fatent(mydata, clust);
+		if (CHECK_CLUST(newclust, mydata->fatsize)) {
+			debug("curclust: 0x%x\n", newclust);
+			printf("Invalid FAT entry\n");
+			return -1;
+		}
+
+		if (newclust == clust + 1) {
+			ext[n].count++;
+		} else {
+			if (++n == max) {
+				*next = newclust;
+				return n;
+			}
+			ext[n].clust = newclust;
+			ext[n].count = 1;
+		}
+		clust = newclust;
+		size -= bytesperclust;
+	}
+
+	return n + 1;
+}
+
 /**
  * get_contents() - read from file
  *
@@ -324,7 +441,6 @@ static int get_contents(fsdata *mydata, dir_entry *dentptr, loff_t pos,
 	loff_t filesize = FAT2CPU32(dentptr->size);
 	unsigned int bytesperclust = mydata->clust_size * mydata->sect_size;
 	__u32 curclust = START(dentptr);
-	__u32 endclust, newclust;
 	loff_t actsize;
 
 	*gotsize = 0;
@@ -391,50 +507,31 @@ static int get_contents(fsdata *mydata, dir_entry *dentptr, loff_t pos,
 		}
 	}
 
-	actsize = bytesperclust;
-	endclust = curclust;
-
-	do {
-		/* search for consecutive clusters */
-		while (actsize < filesize) {
-			newclust = get_fatent(mydata, endclust);
-			if ((newclust - 1) != endclust)
-				goto getit;
-			if (CHECK_CLUST(newclust, mydata->fatsize)) {
-				debug("curclust: 0x%x\n", newclust);
-				printf("Invalid FAT entry\n");
-				return -1;
-			}
-			endclust = newclust;
-			actsize += bytesperclust;
-		}
+	while (filesize > 0) {
+		struct fat_extent ext[FAT_EXTENTS];
+		int i, n;
 
-		/* get remaining bytes */
-		actsize = filesize;
-		if (get_cluster(mydata, curclust, buffer, (int)actsize) != 0) {
-			printf("Error reading cluster\n");
-			return -1;
-		}
-		*gotsize += actsize;
-		return 0;
-getit:
-		if (get_cluster(mydata, curclust, buffer, (int)actsize) != 0) {
-			printf("Error reading cluster\n");
+		/* resolve the chain first, then read each run in one go */
+		n = get_extents(mydata, curclust, filesize, ext, FAT_EXTENTS,
+				&curclust);
+		if (n < 0)
 			return -1;
-		}
-		*gotsize += (int)actsize;
-		filesize -= actsize;
-		buffer += actsize;
 
-		curclust = get_fatent(mydata, endclust);
-		if (CHECK_CLUST(curclust, mydata->fatsize)) {
-			debug("curclust: 0x%x\n", curclust);
-			printf("Invalid FAT entry\n");
-			return -1;
+		for (i = 0; i < n; i++) {
+			actsize = min(filesize,
+				      (loff_t)ext[i].count * bytesperclust);
+			if (get_cluster(mydata, ext[i].clust, buffer,
+					actsize) != 0) {
+				printf("Error reading cluster\n");
+				return -1;
+			}
+			*gotsize += actsize;
+			filesize -= actsize;
+			buffer += actsize;
 		}
-		actsize = bytesperclust;
-		endclust = curclust;
-	} while (1);
+	}
+
+	return 0;
 }
 
 /*
@@ -623,13 +720,8 @@ static int get_fs_info(fsdata *mydata)
 		mydata->root_cluster = 0;
 	}
 
-	mydata->fatbufnum = -1;
-	mydata->fat_dirty = 0;
-	mydata->fatbuf = malloc_cache_aligned(FATBUFSIZE);
-	if (mydata->fatbuf == NULL) {
-		debug("Error: allocating memory\n");
+	if (fat_cache_init(mydata))
 		return -1;
-	}
 
 	debug("FAT%d, fat_sect: %d, fatlength: %d\n",
 	       mydata->fatsize, mydata->fat_sect, mydata->fatlength);
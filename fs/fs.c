@@ -15,12 +15,16 @@
 #include <ext4fs.h>
 #include <fat.h>
 #include <fs.h>
+#include <gzip.h>
+#include <image.h>
+#include <malloc.h>
 #include <sandboxfs.h>
 #include <ubifs_uboot.h>
 #include <btrfs.h>
 #include <asm/io.h>
 #include <div64.h>
 #include <linux/math64.h>
+#include <linux/sizes.h>
 #include <efi_loader.h>
 
 DECLARE_GLOBAL_DATA_PTR;
@@ -487,11 +491,12 @@ static int fs_read_lmb_check(const char *filename, ulong addr, loff_t offset,
 	lmb_init_and_reserve(&lmb, gd->bd, (void *)gd->fdt_blob);
 	lmb_dump_all(&lmb);
 
-	if (lmb_alloc_addr(&lmb, addr, read_len) == addr)
-		return 0;
+	ret = lmb_alloc_addr(&lmb, addr, read_len) == addr ? 0 : -ENOSPC;
+	lmb_uninit(&lmb);
+	if (ret)
+		printf("** Reading file would overwrite reserved memory **\n");
 
-	printf("** Reading file would overwrite reserved memory **\n");
-	return -ENOSPC;
+	return ret;
 }
 #endif
 
@@ -739,6 +744,280 @@ int do_load(struct cmd_tbl *cmdtp, int flag, int argc, char *const argv[],
 	return 0;
 }
 
+#ifdef CONFIG_CMD_ZLOAD
+/* Number of compressed bytes read from the file at a time */
+#define FS_UNZIP_CHUNK	SZ_1M
+
+static long fs_unzip_read(void *priv, ulong pos, void *buf, ulong len)
+{
+	struct fstype_info *info = fs_get_info(fs_type);
+	loff_t actread;
+
+	if (info->read(priv, buf, pos, len, &actread))
+		return -EIO;
+
+	return actread;
+}
+
+int fs_read_unzip(const char *filename, ulong addr, loff_t maxsize,
+		  loff_t *actread)
+{
+	ulong len;
+	void *buf;
+	int ret;
+
+	buf = map_sysmem(addr, maxsize);
+	ret = gunzip_stream(buf, maxsize, FS_UNZIP_CHUNK, fs_unzip_read,
+			    (void *)filename, &len);
+	unmap_sysmem(buf);
+	fs_close();
+
+	*actread = len;
+
+	return ret;
+}
+
+int do_zload(struct cmd_tbl *cmdtp, int flag, int argc, char *const argv[])
+{
+#ifdef CONFIG_LMB
+	struct lmb lmb;
+#endif
+	unsigned long addr, time;
+	loff_t maxsize = 0;
+	loff_t len_read;
+	char *ep;
+	int ret;
+
+	if (argc < 5 || argc > 6)
+		return CMD_RET_USAGE;
+
+	addr = simple_strtoul(argv[3], &ep, 16);
+	if (ep == argv[3] || *ep != '\0')
+		return CMD_RET_USAGE;
+	if (argc == 6)
+		maxsize = simple_strtoul(argv[5], NULL, 16);
+
+#ifdef CONFIG_LMB
+	lmb_init_and_reserve(&lmb, gd->bd, (void *)gd->fdt_blob);
+	if (!maxsize)
+		maxsize = lmb_get_free_size(&lmb, addr);
+	ret = maxsize && lmb_alloc_addr(&lmb, addr, maxsize) == addr;
+	lmb_uninit(&lmb);
+	if (!ret) {
+		printf("** Reading file would overwrite reserved memory **\n");
+		return 1;
+	}
+#endif
+	if (!maxsize)
+		return CMD_RET_USAGE;
+
+	if (fs_set_blk_dev(argv[1], argv[2], FS_TYPE_ANY))
+		return 1;
+
+	time = get_timer(0);
+	ret = fs_read_unzip(argv[4], addr, maxsize, &len_read);
+	time = get_timer(time);
+	if (ret < 0)
+		return 1;
+
+	printf("%llu bytes decompressed in %lu ms", len_read, time);
+	if (time > 0) {
+		puts(" (");
+		print_size(div_u64(len_read, time) * 1000, "/s");
+		puts(")");
+	}
+	puts("\n");
+
+	env_set_hex("fileaddr", addr);
+	env_set_hex("filesize", len_read);
+
+	return 0;
+}
+#endif
+
+#ifdef CONFIG_CMD_IMGLOAD
+/* Largest FIT structure read to find the kernel, i.e. with external data */
+#define FS_IMGLOAD_MAX_FIT	SZ_64K
+
+static int fs_read_buf(const char *ifname, const char *dev_part,
+		       const char *filename, void *buf, loff_t offset,
+		       loff_t len)
+{
+	loff_t actread;
+
+	if (fs_set_blk_dev(ifname, dev_part, FS_TYPE_ANY))
+		return -ENODEV;
+	if (fs_read(filename, map_to_sysmem(buf), offset, len, &actread) < 0 ||
+	    actread != len)
+		return -EIO;
+
+	return 0;
+}
+
+/**
+ * fs_image_locate_kernel() - find the kernel data in an image file
+ *
+ * Only the headers are read: the legacy image header, or the structure of
+ * a FIT, which must then keep its data external (mkimage -E).
+ *
+ * @ifname:	interface the file is on
+ * @dev_part:	device and partition the file is on
+ * @filename:	legacy image or FIT holding an uncompressed kernel
+ * @load:	returns the load address of the kernel
+ * @offset:	returns the offset of the kernel data in the file
+ * Return:	0 if OK, -ENOENT if the file holds no uncompressed kernel that
+ *		could run where it is read to, other -ve value on error
+ */
+static int fs_image_locate_kernel(const char *ifname, const char *dev_part,
+				  const char *filename, ulong *load,
+				  ulong *offset)
+{
+	void *buf;
+	ulong size;
+	int conf, noffset, data_off;
+	uint8_t comp;
+	int ret;
+
+	size = max(sizeof(image_header_t), sizeof(struct fdt_header));
+	buf = malloc(size);
+	if (!buf)
+		return -ENOMEM;
+	ret = fs_read_buf(ifname, dev_part, filename, buf, 0, size);
+	if (ret)
+		goto out;
+
+	ret = -ENOENT;
+	switch (genimg_get_format(buf)) {
+#ifdef CONFIG_LEGACY_IMAGE_FORMAT
+	case IMAGE_FORMAT_LEGACY:
+		if (!image_check_hcrc(buf) ||
+		    !image_check_type(buf, IH_TYPE_KERNEL) ||
+		    image_get_comp(buf) != IH_COMP_NONE)
+			break;
+		*load = image_get_load(buf);
+		*offset = image_get_header_size();
+		ret = 0;
+		break;
+#endif
+#if CONFIG_IS_ENABLED(FIT)
+	case IMAGE_FORMAT_FIT:
+		size = fdt_totalsize(buf);
+		if (size > FS_IMGLOAD_MAX_FIT)
+			break;
+		free(buf);
+		buf = malloc(size);
+		if (!buf)
+			return -ENOMEM;
+		ret = fs_read_buf(ifname, dev_part, filename, buf, 0, size);
+		if (ret)
+			goto out;
+
+		ret = -ENOENT;
+		if (!fit_check_format(buf))
+			break;
+		conf = fit_conf_get_node(buf, NULL);
+		if (conf < 0)
+			break;
+		noffset = fit_conf_get_prop_node(buf, conf, FIT_KERNEL_PROP);
+		if (noffset < 0 ||
+		    !fit_image_check_type(buf, noffset, IH_TYPE_KERNEL) ||
+		    fit_image_get_comp(buf, noffset, &comp) ||
+		    comp != IH_COMP_NONE ||
+		    fit_image_get_load(buf, noffset, load))
+			break;
+		if (!fit_image_get_data_position(buf, noffset, &data_off))
+			*offset = data_off;
+		else if (!fit_image_get_data_offset(buf, noffset, &data_off))
+			*offset = ALIGN(size, 4) + data_off;
+		else
+			break;
+		ret = 0;
+		break;
+#endif
+	}
+out:
+	free(buf);
+
+	return ret;
+}
+
+int do_imgload(struct cmd_tbl *cmdtp, int flag, int argc, char *const argv[])
+{
+	const char *filename = argv[3];
+	unsigned long addr, load, offset, time;
+	loff_t size, len_read;
+	bool placed = false;
+	char *ep;
+	int ret;
+
+	if (argc < 4 || argc > 5)
+		return CMD_RET_USAGE;
+
+	if (argc == 5) {
+		addr = simple_strtoul(argv[4], &ep, 16);
+		if (ep == argv[4] || *ep != '\0')
+			return CMD_RET_USAGE;
+	} else {
+		addr = env_get_ulong("loadaddr", 16, CONFIG_SYS_LOAD_ADDR);
+	}
+
+	if (fs_set_blk_dev(argv[1], argv[2], FS_TYPE_ANY) ||
+	    fs_size(filename, &size) < 0)
+		return 1;
+
+	/*
+	 * Read the file so that the kernel lands on its load address and
+	 * bootm can run it where it is, unless that would overwrite reserved
+	 * memory.
+	 */
+	ret = fs_image_locate_kernel(argv[1], argv[2], filename, &load,
+				     &offset);
+	if (!ret && load >= offset) {
+#ifdef CONFIG_LMB
+		struct lmb lmb;
+
+		lmb_init_and_reserve(&lmb, gd->bd, (void *)gd->fdt_blob);
+		placed = lmb_alloc_addr(&lmb, load - offset, size) ==
+			 load - offset;
+		lmb_uninit(&lmb);
+#else
+		placed = true;
+#endif
+	}
+	if (placed) {
+		addr = load - offset;
+		printf("Kernel at its load address %08lx, reading file to %08lx\n",
+		       load, addr);
+	} else if (!ret) {
+		printf("Cannot read kernel to its load address %08lx\n", load);
+	} else if (ret != -ENOENT) {
+		return 1;
+	}
+
+	if (fs_set_blk_dev(argv[1], argv[2], FS_TYPE_ANY))
+		return 1;
+
+	time = get_timer(0);
+	ret = _fs_read(filename, addr, 0, 0, 1, &len_read);
+	time = get_timer(time);
+	if (ret < 0)
+		return 1;
+
+	printf("%llu bytes read in %lu ms", len_read, time);
+	if (time > 0) {
+		puts(" (");
+		print_size(div_u64(len_read, time) * 1000, "/s");
+		puts(")");
+	}
+	puts("\n");
+
+	env_set_hex("fileaddr", addr);
+	env_set_hex("filesize", len_read);
+
+	return 0;
+}
+#endif
+
 int do_ls(struct cmd_tbl *cmdtp, int flag, int argc, char *const argv[],
 	  int fstype)
 {
@@ -139,6 +139,9 @@ int blkcache_read(int iftype, int dev,
  * blkcache_fill() - make data read from a block device available
  * to the block cache
  *
+ * Reads of more than the maximum blocks per cached read are ignored, except
+ * for the readahead returned by blkcache_readahead().
+ *
  * @param iftype - IF_TYPE_x for type of device
  * @param dev - device index of particular type
  * @param start - starting block number
@@ -151,6 +154,41 @@ void blkcache_fill(int iftype, int dev,
 		   lbaint_t start, lbaint_t blkcnt,
 		   unsigned long blksz, void const *buffer);
 
+/**
+ * blkcache_readahead() - decide how many blocks to read on a cache miss
+ *
+ * Tracks sequential access and grows a readahead window while a run of
+ * consecutive reads continues. The caller reads the returned number of
+ * blocks (clamped to the device size) and passes them to blkcache_fill().
+ *
+ * @param iftype - IF_TYPE_x for type of device
+ * @param dev - device index of particular type
+ * @param start - starting block number
+ * @param blkcnt - number of blocks requested
+ *
+ * @return - number of blocks to read, at least @blkcnt
+ */
+lbaint_t blkcache_readahead(int iftype, int dev,
+			    lbaint_t start, lbaint_t blkcnt);
+
+/**
+ * blkcache_write() - keep cached blocks coherent with a write
+ *
+ * Blocks in the range which are present in the cache are updated from
+ * @buffer, so a write does not need to discard the whole cache.
+ *
+ * @param iftype - IF_TYPE_x for type of device
+ * @param dev - device index of particular type
+ * @param start - starting block number
+ * @param blkcnt - number of blocks written
+ * @param blksz - size in bytes of each block
+ * @param buf - buffer containing the data written, or NULL to drop the
+ *		blocks from the cache (e.g. after an erase)
+ */
+void blkcache_write(int iftype, int dev,
+		    lbaint_t start, lbaint_t blkcnt,
+		    unsigned long blksz, void const *buffer);
+
 /**
  * blkcache_invalidate() - discard the cache for a set of blocks
  * because of a write or device (re)initialization.
@@ -163,10 +201,12 @@ void blkcache_invalidate(int iftype, int dev);
 /**
  * blkcache_configure() - configure block cache
  *
- * @param blocks - maximum blocks per entry
- * @param entries - maximum entries in cache
+ * @param blocks - maximum blocks per cached read
+ * @param size_kb - memory budget of the cache in KiB
+ * @param readahead - maximum readahead window in blocks, 0 to disable
  */
-void blkcache_configure(unsigned blocks, unsigned entries);
+void blkcache_configure(unsigned blocks, unsigned size_kb,
+			unsigned readahead);
 
 /*
  * statistics of the block cache
@@ -174,9 +214,13 @@ void blkcache_configure(unsigned blocks, unsigned entries);
 struct block_cache_stats {
 	unsigned hits;
 	unsigned misses;
-	unsigned entries; /* current entry count */
+	unsigned evictions;
+	unsigned readahead; /* blocks requested beyond the read size */
+	unsigned entries; /* current cached block count */
+	unsigned long bytes; /* current cached data size */
 	unsigned max_blocks_per_entry;
-	unsigned max_entries;
+	unsigned max_readahead;
+	unsigned size_kb;
 };
 
 /**
@@ -199,6 +243,16 @@ static inline void blkcache_fill(int iftype, int dev,
 				 lbaint_t start, lbaint_t blkcnt,
 				 unsigned long blksz, void const *buffer) {}
 
+static inline lbaint_t blkcache_readahead(int iftype, int dev,
+					  lbaint_t start, lbaint_t blkcnt)
+{
+	return blkcnt;
+}
+
+static inline void blkcache_write(int iftype, int dev,
+				  lbaint_t start, lbaint_t blkcnt,
+				  unsigned long blksz, void const *buffer) {}
+
 static inline void blkcache_invalidate(int iftype, int dev) {}
 
 #endif
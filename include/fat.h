@@ -27,6 +27,11 @@ struct disk_partition;
 
 #define FATBUFBLOCKS	6
 #define FATBUFSIZE	(mydata->sect_size * FATBUFBLOCKS)
+#if defined(CONFIG_FS_FAT_CACHE_WINDOWS) && !defined(CONFIG_SPL_BUILD)
+#define FATBUFWINDOWS	CONFIG_FS_FAT_CACHE_WINDOWS
+#else
+#define FATBUFWINDOWS	1
+#endif
 #define FAT12BUFSIZE	((FATBUFSIZE*2)/3)
 #define FAT16BUFSIZE	(FATBUFSIZE/2)
 #define FAT32BUFSIZE	(FATBUFSIZE/4)
@@ -156,6 +161,13 @@ typedef struct dir_slot {
 	__u8	name11_12[4];	/* Last 2 characters in name */
 } dir_slot;
 
+/* One FATBUFSIZE window of the FAT cache */
+struct fat_cache_window {
+	int	bufnum;		/* FAT window held here, -1 if unused */
+	__u8	dirty;		/* Set if the window has been modified */
+	__u32	stamp;		/* Last use, for LRU replacement */
+};
+
 /*
  * Private filesystem parameters
  *
@@ -163,16 +175,17 @@ typedef struct dir_slot {
  * (see FAT32 accesses)
  */
 typedef struct {
-	__u8	*fatbuf;	/* Current FAT buffer */
+	__u8	*fatbuf;	/* FAT cache, FATBUFWINDOWS * FATBUFSIZE */
 	int	fatsize;	/* Size of FAT in bits */
 	__u32	fatlength;	/* Length of FAT in sectors */
 	__u16	fat_sect;	/* Starting sector of the FAT */
-	__u8	fat_dirty;      /* Set if fatbuf has been modified */
+	__u8	fat_dirty;      /* Set if any FAT cache window is dirty */
 	__u32	rootdir_sect;	/* Start sector of root directory */
 	__u16	sect_size;	/* Size of sectors in bytes */
 	__u16	clust_size;	/* Size of clusters in sectors */
 	int	data_begin;	/* The sector of the first cluster, can be negative */
-	int	fatbufnum;	/* Used by get_fatent, init to -1 */
+	struct fat_cache_window fatwin[FATBUFWINDOWS];
+	__u32	fatstamp;	/* FAT cache LRU clock */
 	int	rootdir_size;	/* Size of root dir for non-FAT32 */
 	__u32	root_cluster;	/* First cluster of root dir for FAT32 */
 	u32	total_sect;	/* Number of sectors */
@@ -225,6 +225,22 @@ int fs_unlink(const char *filename);
  */
 int fs_mkdir(const char *filename);
 
+/**
+ * fs_read_unzip() - read a gzip-compressed file and decompress it on the fly
+ *
+ * The file is read from the partition previously set by fs_set_blk_dev() one
+ * chunk at a time and each chunk is decompressed before the next one is read,
+ * so only the uncompressed image is ever held in memory.
+ *
+ * @filename:	full path of the file to read from
+ * @addr:	address of the buffer to decompress to
+ * @maxsize:	size of the buffer at @addr
+ * @actread:	returns the number of bytes decompressed
+ * Return:	0 if OK with valid *actread, -1 on error conditions
+ */
+int fs_read_unzip(const char *filename, ulong addr, loff_t maxsize,
+		  loff_t *actread);
+
 /*
  * Common implementation for various filesystem commands, optionally limited
  * to a specific filesystem type via the fstype parameter.
@@ -233,6 +249,8 @@ int do_size(struct cmd_tbl *cmdtp, int flag, int argc, char *const argv[],
 	    int fstype);
 int do_load(struct cmd_tbl *cmdtp, int flag, int argc, char *const argv[],
 	    int fstype);
+int do_zload(struct cmd_tbl *cmdtp, int flag, int argc, char *const argv[]);
+int do_imgload(struct cmd_tbl *cmdtp, int flag, int argc, char *const argv[]);
 int do_ls(struct cmd_tbl *cmdtp, int flag, int argc, char *const argv[],
 	  int fstype);
 int file_exists(const char *dev_type, const char *dev_part, const char *file,
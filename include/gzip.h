@@ -45,6 +45,27 @@ int gunzip(void *dst, int dstlen, unsigned char *src, unsigned long *lenp);
 int zunzip(void *dst, int dstlen, unsigned char *src, unsigned long *lenp,
 	   int stoponerr, int offset);
 
+/**
+ * gunzip_stream() - Decompress gzipped data which is read in chunks
+ *
+ * The compressed data is pulled through @read into a buffer of @chunk bytes
+ * and inflated straight into @dst as it arrives, so the compressed image
+ * never has to be held in memory as a whole.
+ *
+ * @dst: Destination for uncompressed data
+ * @dstlen: Size of destination buffer
+ * @chunk: Number of compressed bytes to read at a time
+ * @read: Reads up to @len bytes at byte offset @pos of the compressed data
+ *	into @buf. Returns the number of bytes read, 0 at the end of the data
+ *	or -ve on error
+ * @priv: Private data passed to @read
+ * @lenp: On exit, number of uncompressed bytes written to @dst
+ * @return 0 if OK, -1 on error
+ */
+int gunzip_stream(void *dst, ulong dstlen, ulong chunk,
+		  long (*read)(void *priv, ulong pos, void *buf, ulong len),
+		  void *priv, ulong *lenp);
+
 /**
  * gzwrite progress indicators: defined weak to allow board-specific
  * overrides:
@@ -32,8 +32,14 @@ struct fdt_region;
 #define CONFIG_FIT_VERBOSE	1 /* enable fit_format_{error,warning}() */
 #define CONFIG_FIT_ENABLE_RSASSA_PSS_SUPPORT 1
 #define CONFIG_FIT_ENABLE_SHA256_SUPPORT
+#define CONFIG_FIT_ENABLE_SHA384_SUPPORT
+#define CONFIG_FIT_ENABLE_SHA512_SUPPORT
+#define CONFIG_FIT_ENABLE_BLAKE2B_SUPPORT
 #define CONFIG_SHA1
 #define CONFIG_SHA256
+#define CONFIG_SHA384
+#define CONFIG_SHA512
+#define CONFIG_BLAKE2B
 
 #define IMAGE_ENABLE_IGNORE	0
 #define IMAGE_INDENT_STRING	""
@@ -92,6 +98,27 @@ struct fdt_region;
 #define IMAGE_ENABLE_SHA256	0
 #endif
 
+#if defined(CONFIG_FIT_ENABLE_SHA384_SUPPORT) || \
+	defined(CONFIG_SPL_SHA384_SUPPORT)
+#define IMAGE_ENABLE_SHA384	1
+#else
+#define IMAGE_ENABLE_SHA384	0
+#endif
+
+#if defined(CONFIG_FIT_ENABLE_SHA512_SUPPORT) || \
+	defined(CONFIG_SPL_SHA512_SUPPORT)
+#define IMAGE_ENABLE_SHA512	1
+#else
+#define IMAGE_ENABLE_SHA512	0
+#endif
+
+#if defined(CONFIG_FIT_ENABLE_BLAKE2B_SUPPORT) && \
+	!defined(CONFIG_SPL_BUILD)
+#define IMAGE_ENABLE_BLAKE2B	1
+#else
+#define IMAGE_ENABLE_BLAKE2B	0
+#endif
+
 #endif /* IMAGE_ENABLE_FIT */
 
 #ifdef CONFIG_SYS_BOOT_GET_CMDLINE
@@ -1162,6 +1189,36 @@ int fit_check_ramdisk(const void *fit, int os_noffset,
 int calculate_hash(const void *data, int data_len, const char *algo,
 			uint8_t *value, int *value_len);
 
+/**
+ * fit_digest_lookup() - Look up a digest computed earlier for an image
+ *
+ * While fit_image_verify_with_data() runs, the digests of the image data
+ * are remembered so that hash and signature nodes over the same data only
+ * hash it once per algorithm.
+ *
+ * @data:	Image data
+ * @size:	Size of image data
+ * @algo:	Hash algorithm name, e.g. "sha256"
+ * @value:	Returns the digest
+ * @value_len:	Returns the digest length, may be NULL
+ * @return 0 if found, -ENOENT if not, if no verification is running, and
+ *	always before relocation, in SPL and in the host tools
+ */
+int fit_digest_lookup(const void *data, size_t size, const char *algo,
+		      uint8_t *value, int *value_len);
+
+/**
+ * fit_digest_store() - Remember a digest for fit_digest_lookup()
+ *
+ * @data:	Image data
+ * @size:	Size of image data
+ * @algo:	Hash algorithm name
+ * @value:	Digest
+ * @value_len:	Digest length
+ */
+void fit_digest_store(const void *data, size_t size, const char *algo,
+		      const uint8_t *value, int value_len);
+
 /*
  * At present we only support signing on the host, and verification on the
  * device
@@ -8,8 +8,13 @@
 #include <linux/types.h>
 /* #include <linux/bitrev.h> */
 
-extern u32  crc32_le(u32 crc, unsigned char const *p, size_t len);
-/* extern u32  crc32_be(u32 crc, unsigned char const *p, size_t len); */
+/* lib/crc32.c, declared here as <u-boot/crc.h> clashes with the macro below */
+uint32_t crc32_no_comp(uint32_t crc, const unsigned char *buf, uint len);
+
+static inline u32 crc32_le(u32 crc, unsigned char const *p, size_t len)
+{
+	return crc32_no_comp(crc, p, len);
+}
 
 #define crc32(seed, data, length)  crc32_le(seed, (unsigned char const *)data, length)
 
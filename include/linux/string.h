@@ -113,6 +113,10 @@ extern void * memcpy(void *,const void *,__kernel_size_t);
 #ifndef __HAVE_ARCH_MEMMOVE
 extern void * memmove(void *,const void *,__kernel_size_t);
 #endif
+/* The C versions from lib/string.c, see there for when they are built */
+void *generic_memset(void *s, int c, __kernel_size_t count);
+void *generic_memcpy(void *dest, const void *src, __kernel_size_t count);
+void *generic_memmove(void *dest, const void *src, __kernel_size_t count);
 #ifndef __HAVE_ARCH_MEMSCAN
 extern void * memscan(void *,int,__kernel_size_t);
 #endif
@@ -12,6 +12,11 @@
  * Copyright (C) 2001 Peter Bergner, IBM Corp.
  */
 
+/*
+ * Number of regions held in struct lmb_region itself. When more are needed
+ * the array is moved to the heap and grown, so a struct lmb must not be
+ * copied and should be released with lmb_uninit() when done.
+ */
 #define MAX_LMB_REGIONS 8
 
 struct lmb_property {
@@ -19,10 +24,16 @@ struct lmb_property {
 	phys_size_t size;
 };
 
+/*
+ * Regions are kept sorted by base address and never overlap, which allows
+ * binary searching them.
+ */
 struct lmb_region {
 	unsigned long cnt;
+	unsigned long max;
 	phys_size_t size;
-	struct lmb_property region[MAX_LMB_REGIONS+1];
+	struct lmb_property *region;
+	struct lmb_property initial_region[MAX_LMB_REGIONS];
 };
 
 struct lmb {
@@ -31,6 +42,7 @@ struct lmb {
 };
 
 extern void lmb_init(struct lmb *lmb);
+extern void lmb_uninit(struct lmb *lmb);
 extern void lmb_init_and_reserve(struct lmb *lmb, bd_t *bd, void *fdt_blob);
 extern void lmb_init_and_reserve_range(struct lmb *lmb, phys_addr_t base,
 				       phys_size_t size, void *fdt_blob);
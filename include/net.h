@@ -104,6 +104,14 @@ enum eth_state_t {
 	ETH_STATE_ACTIVE
 };
 
+/*
+ * Checksums of a received packet as found by the hardware. Those not known
+ * to be correct are verified in software.
+ */
+#define ETH_CSUM_IP	(1 << 0)	/* IPv4 header checksum is correct */
+#define ETH_CSUM_L4	(1 << 1)	/* UDP or TCP checksum is correct */
+#define ETH_CSUM_BAD	(1 << 2)	/* hardware found a bad checksum */
+
 #ifdef CONFIG_DM_ETH
 /**
  * struct eth_pdata - Platform data for Ethernet MAC controllers
@@ -112,6 +120,10 @@ enum eth_state_t {
  * @enetaddr: The Ethernet MAC address that is loaded from EEPROM or env
  * @phy_interface: PHY interface to use - see PHY_INTERFACE_MODE_...
  * @max_speed: Maximum speed of Ethernet connection supported by MAC
+ * @rx_csum: Checksums the hardware verifies on received packets, ETH_CSUM_IP
+ *	     and ETH_CSUM_L4 - set by the driver
+ * @max_mtu: Largest MTU the device can send and receive, 0 for the standard
+ *	     Ethernet MTU of 1500 - set by the driver
  * @priv_pdata: device specific platdata
  */
 struct eth_pdata {
@@ -119,9 +131,25 @@ struct eth_pdata {
 	unsigned char enetaddr[ARP_HLEN];
 	int phy_interface;
 	int max_speed;
+	uint rx_csum;
+	int max_mtu;
 	void *priv_pdata;
 };
 
+/**
+ * struct eth_rx_pkt - a packet returned by the recv_batch() method
+ *
+ * @packet: Start of the Ethernet frame
+ * @length: Length of the frame
+ * @csum: ETH_CSUM_... flags for the checksums the hardware checked, zeroed
+ *	  by the caller
+ */
+struct eth_rx_pkt {
+	uchar *packet;
+	int length;
+	uint csum;
+};
+
 enum eth_recv_flags {
 	/*
 	 * Check hardware device for new packets (otherwise only return those
@@ -140,6 +168,13 @@ enum eth_recv_flags {
  *	 indicate that the hardware receive FIFO is empty. If 0 is returned, the
  *	 network stack will not process the empty packet, but free_pkt() will be
  *	 called if supplied
+ * send_batch: Send "count" packets, returning how many were queued (at least
+ *	       one) or an error. The packets may be copied so that the call
+ *	       does not wait for the hardware to send them - optional
+ * recv_batch: Like recv, but return up to "max" packets at once in "pkts",
+ *	       with their number as the return value. The buffers are not
+ *	       reused until free_pkt() has been called for each of them, in
+ *	       the order they were returned - optional
  * free_pkt: Give the driver an opportunity to manage its packet buffer memory
  *	     when the network stack is finished processing it. This will only be
  *	     called when no error was returned from recv - optional
@@ -160,6 +195,10 @@ struct eth_ops {
 	int (*start)(struct udevice *dev);
 	int (*send)(struct udevice *dev, void *packet, int length);
 	int (*recv)(struct udevice *dev, int flags, uchar **packetp);
+	int (*send_batch)(struct udevice *dev, void **packets, int *lengths,
+			  int count);
+	int (*recv_batch)(struct udevice *dev, int flags,
+			  struct eth_rx_pkt *pkts, int max);
 	int (*free_pkt)(struct udevice *dev, uchar *packet, int length);
 	void (*stop)(struct udevice *dev);
 	int (*mcast)(struct udevice *dev, const u8 *enetaddr, int join);
@@ -181,6 +220,19 @@ unsigned char *eth_get_ethaddr(void); /* get the current device MAC */
 int eth_is_active(struct udevice *dev); /* Test device for active state */
 int eth_init_state_only(void); /* Set active state */
 void eth_halt_state_only(void); /* Set passive state */
+
+/**
+ * eth_send_batch() - send several packets on the current device
+ *
+ * Drivers with a send_batch() method get all the packets in one call, the
+ * others one at a time.
+ *
+ * @packets: packets to send
+ * @lengths: length of each packet
+ * @count: number of packets
+ * @return number of packets sent, or -ve error if none could be
+ */
+int eth_send_batch(void **packets, int *lengths, int count);
 #endif
 
 #ifndef CONFIG_DM_ETH
@@ -304,6 +356,13 @@ extern void (*push_packet)(void *packet, int length);
 int eth_rx(void);			/* Check for received packets */
 void eth_halt(void);			/* stop SCC */
 const char *eth_get_name(void);		/* get name of current device */
+
+/**
+ * eth_get_mtu() - get the MTU of the current device
+ *
+ * @return the smaller of NET_MTU and the largest MTU the device supports
+ */
+int eth_get_mtu(void);
 int eth_mcast_join(struct in_addr mcast_addr, int join);
 
 /**********************************************************************/
@@ -366,6 +425,7 @@ struct vlan_ethernet_hdr {
 #define PROT_NCSI	0x88f8		/* NC-SI control packets        */
 
 #define IPPROTO_ICMP	 1	/* Internet Control Message Protocol	*/
+#define IPPROTO_TCP	 6	/* Transmission Control Protocol	*/
 #define IPPROTO_UDP	17	/* User Datagram Protocol		*/
 
 /*
@@ -488,15 +548,26 @@ struct icmp_hdr {
 #define ICMP_HDR_SIZE		(sizeof(struct icmp_hdr))
 #define IP_ICMP_HDR_SIZE	(IP_HDR_SIZE + ICMP_HDR_SIZE)
 
+/*
+ * Largest IP datagram the stack is built for. A device may support less,
+ * see eth_get_mtu().
+ */
+#ifdef CONFIG_NET_MTU
+#define NET_MTU			CONFIG_NET_MTU
+#else
+#define NET_MTU			ETH_DATA_LEN
+#endif
+
 /*
  * Maximum packet size; used to allocate packet storage. Use
- * the maxium Ethernet frame size as specified by the Ethernet
- * standard including the 802.1Q tag (VLAN tagging).
+ * the maxium Ethernet frame size for NET_MTU including the
+ * 802.1Q tag (VLAN tagging) and the FCS.
+ * For the standard MTU of 1500:
  * maximum packet size =  1522
  * maximum packet size and multiple of 32 bytes =  1536
  */
-#define PKTSIZE			1522
-#define PKTSIZE_ALIGN		1536
+#define PKTSIZE			(NET_MTU + 22)
+#define PKTSIZE_ALIGN		((PKTSIZE + 31) & ~31)
 
 /*
  * Maximum receive ring size; that is, the number of packets
@@ -551,7 +622,7 @@ extern int		net_restart_wrap;	/* Tried all network devices */
 
 enum proto_t {
 	BOOTP, RARP, ARP, TFTPGET, DHCP, PING, DNS, NFS, CDP, NETCONS, SNTP,
-	TFTPSRV, TFTPPUT, LINKLOCAL, FASTBOOT, WOL
+	TFTPSRV, TFTPPUT, LINKLOCAL, FASTBOOT, WOL, WGET
 };
 
 extern char	net_boot_file_name[1024];/* Boot File name */
@@ -700,6 +771,38 @@ int net_send_udp_packet(uchar *ether, struct in_addr dest, int dport,
 /* Processes a received packet */
 void net_process_received_packet(uchar *in_packet, int len);
 
+/**
+ * net_process_received_csum() - process a received packet
+ *
+ * Like net_process_received_packet(), but the checksums the hardware found
+ * correct are not verified again.
+ *
+ * @in_packet: Ethernet frame
+ * @len: length of the frame
+ * @csum: ETH_CSUM_... flags
+ */
+void net_process_received_csum(uchar *in_packet, int len, uint csum);
+
+/**
+ * struct net_csum_stats - checksum errors in received packets
+ *
+ * The counters are cleared at the start of net_loop(), which prints them
+ * when it returns if any of them is non-zero.
+ *
+ * @hw: packets the hardware found bad, which are checked again in software
+ * @ip: packets dropped for a bad IPv4 header checksum
+ * @udp: UDP datagrams dropped for a bad checksum
+ * @tcp: TCP segments dropped for a bad checksum
+ */
+struct net_csum_stats {
+	ulong hw;
+	ulong ip;
+	ulong udp;
+	ulong tcp;
+};
+
+extern struct net_csum_stats net_csum_stats;
+
 #if defined(CONFIG_NETCONSOLE) && !defined(CONFIG_SPL_BUILD)
 void nc_start(void);
 int nc_input_packet(uchar *pkt, struct in_addr src_ip, unsigned dest_port,
@@ -0,0 +1,197 @@
+/* SPDX-License-Identifier: GPL-2.0+ */
+/*
+ * Minimal TCP client: a single active connection at a time, in-order
+ * delivery with cumulative (SACK-free) ACKs, window scaling and delayed
+ * ACKs. The application sends small requests and gets received data as
+ * it arrives, see tcp_connect().
+ */
+
+#ifndef __TCP_H__
+#define __TCP_H__
+
+/*
+ *	Internet Protocol (IP) + TCP header.
+ */
+struct ip_tcp_hdr {
+	u8		ip_hl_v;	/* header length and version	*/
+	u8		ip_tos;		/* type of service		*/
+	u16		ip_len;		/* total length			*/
+	u16		ip_id;		/* identification		*/
+	u16		ip_off;		/* fragment offset field	*/
+	u8		ip_ttl;		/* time to live			*/
+	u8		ip_p;		/* protocol			*/
+	u16		ip_sum;		/* checksum			*/
+	struct in_addr	ip_src;		/* Source IP address		*/
+	struct in_addr	ip_dst;		/* Destination IP address	*/
+	u16		tcp_src;	/* TCP source port		*/
+	u16		tcp_dst;	/* TCP destination port		*/
+	u32		tcp_seq;	/* Sequence number		*/
+	u32		tcp_ack;	/* Acknowledgment number	*/
+	u8		tcp_hlen;	/* Header length (words) << 4	*/
+	u8		tcp_flags;	/* TCP_SYN, TCP_ACK, ...	*/
+	u16		tcp_win;	/* Receive window		*/
+	u16		tcp_xsum;	/* Checksum			*/
+	u16		tcp_urg;	/* Urgent pointer		*/
+} __attribute__((packed));
+
+#define IP_TCP_HDR_SIZE		(sizeof(struct ip_tcp_hdr))
+#define TCP_HDR_SIZE		(IP_TCP_HDR_SIZE - IP_HDR_SIZE)
+
+/* TCP flags */
+#define TCP_FIN		0x01
+#define TCP_SYN		0x02
+#define TCP_RST		0x04
+#define TCP_PUSH	0x08
+#define TCP_ACK		0x10
+
+/* TCP options */
+#define TCP_O_END	0	/* End of option list		*/
+#define TCP_O_NOP	1	/* No operation			*/
+#define TCP_O_MSS	2	/* Maximum segment size		*/
+#define TCP_O_WS	3	/* Window scale			*/
+
+/*
+ * Largest segment the stack is built for: NET_MTU less the IP and TCP
+ * headers. The MSS we advertise follows the MTU of the device instead.
+ */
+#define TCP_MSS		(NET_MTU - IP_TCP_HDR_SIZE)
+
+/*
+ * Receive window. Data is handed to the application as soon as it
+ * arrives in order, so the window only bounds how much the peer may
+ * have in flight; it is advertised with a window scale of
+ * TCP_RCV_WSCALE.
+ */
+#define TCP_RCV_WND	(512 * 1024)
+#define TCP_RCV_WSCALE	4
+
+enum tcp_state {
+	TCP_CLOSED,
+	TCP_SYN_SENT,
+	TCP_ESTABLISHED,
+	TCP_FIN_WAIT_1,		/* we closed, FIN not acknowledged yet */
+	TCP_FIN_WAIT_2,		/* we closed, waiting for the peer's FIN */
+	TCP_CLOSE_WAIT,		/* peer closed, we may still send */
+	TCP_LAST_ACK,		/* both closed, our FIN not acknowledged */
+};
+
+enum tcp_event {
+	TCP_EVENT_CONNECTED,	/* handshake completed */
+	TCP_EVENT_DATA,		/* in-order data received */
+	TCP_EVENT_EOF,		/* peer has sent all its data (FIN) */
+	TCP_EVENT_RESET,	/* connection reset by the peer */
+	TCP_EVENT_TIMEOUT,	/* no progress, connection dropped */
+};
+
+/**
+ * struct tcp_stats - counters of the current connection
+ *
+ * @segments: data segments received in order
+ * @ooo: segments dropped because they were out of order or duplicates
+ * @retransmits: segments we had to send again
+ * @bad_xsum: segments dropped because of a bad checksum
+ */
+struct tcp_stats {
+	ulong segments;
+	ulong ooo;
+	ulong retransmits;
+	ulong bad_xsum;
+};
+
+/**
+ * typedef rxhand_tcp - application handler of a TCP connection
+ *
+ * @event: what happened
+ * @data: received data, for TCP_EVENT_DATA
+ * @len: length of @data
+ */
+typedef void rxhand_tcp(enum tcp_event event, const uchar *data,
+			unsigned int len);
+
+/**
+ * tcp_connect() - open a connection
+ *
+ * Sends a SYN to @dest:@dport from a pseudo-random local port. The
+ * connection uses the net_loop() timeout handler for retransmissions
+ * and delayed ACKs, so the application must not install its own.
+ *
+ * @dest: server IP address
+ * @dport: server port
+ * @handler: called on connection events and received data
+ */
+void tcp_connect(struct in_addr dest, int dport, rxhand_tcp *handler);
+
+/**
+ * tcp_write() - send data on an established connection
+ *
+ * The data is kept until it is acknowledged and retransmitted as needed.
+ * Only one segment may be outstanding.
+ *
+ * @data: data to send
+ * @len: length of @data, at most the MSS of the peer and of our device
+ * @return 0 if OK, -ENOTCONN if not connected, -EBUSY if earlier data is
+ * not acknowledged yet, -E2BIG if @len is too large
+ */
+int tcp_write(const void *data, unsigned int len);
+
+/**
+ * tcp_close() - close our side of the connection by sending a FIN
+ *
+ * Data still arrives until the peer closes its side.
+ */
+void tcp_close(void);
+
+/**
+ * tcp_abort() - reset the connection and forget about it
+ */
+void tcp_abort(void);
+
+/**
+ * tcp_get_state() - get the state of the connection
+ *
+ * @return current state
+ */
+enum tcp_state tcp_get_state(void);
+
+/**
+ * tcp_get_stats() - get the counters of the last connection
+ *
+ * @return pointer to the counters
+ */
+const struct tcp_stats *tcp_get_stats(void);
+
+/**
+ * tcp_set_tcp_header() - set the IP and TCP headers of a segment
+ *
+ * Called by net_send_ip_packet(). SYN segments carry the MSS and window
+ * scale options, which go where the payload starts in other segments.
+ *
+ * @pkt: start of the IP header
+ * @dest: destination IP address
+ * @dport: destination port
+ * @sport: source port
+ * @payload_len: length of the payload, which follows IP_TCP_HDR_SIZE
+ * @action: TCP flags
+ * @tcp_seq_num: sequence number
+ * @tcp_ack_num: acknowledgment number
+ * @return size of the IP and TCP headers, including options
+ */
+int tcp_set_tcp_header(uchar *pkt, struct in_addr dest, int dport, int sport,
+		       int payload_len, u8 action, u32 tcp_seq_num,
+		       u32 tcp_ack_num);
+
+/**
+ * tcp_receive() - handle a received TCP segment
+ *
+ * @tcp: IP and TCP headers, followed by the options and the payload
+ * @len: IP datagram length
+ * @csum_ok: the hardware has verified the checksum of the segment
+ */
+void tcp_receive(struct ip_tcp_hdr *tcp, unsigned int len, bool csum_ok);
+
+/**
+ * tcp_init() - forget any connection left over by a previous net_loop()
+ */
+void tcp_init(void);
+
+#endif /* __TCP_H__ */
@@ -0,0 +1,26 @@
+/* SPDX-License-Identifier: GPL-2.0+ */
+/*
+ * HTTP/1.1 download over TCP
+ */
+
+#ifndef __WGET_H__
+#define __WGET_H__
+
+#include <blk.h>
+
+/* wget.c */
+void wget_start(void);	/* Begin HTTP GET of net_boot_file_name */
+
+/**
+ * wget_set_blk() - select where the next download goes
+ *
+ * The file is written to @count blocks of @desc starting at @start,
+ * instead of to memory at image_load_addr.
+ *
+ * @desc: block device, or NULL to load into memory again
+ * @start: first block to write
+ * @count: number of blocks available from @start
+ */
+void wget_set_blk(struct blk_desc *desc, lbaint_t start, lbaint_t count);
+
+#endif /* __WGET_H__ */
@@ -47,6 +47,10 @@ struct hsearch_data {
 	struct env_entry_node *table;
 	unsigned int size;
 	unsigned int filled;
+	/* Table indices of the used entries, in ascending order of keys */
+	unsigned int *sorted;
+	/* Non-zero while entries must not move, e.g. during callbacks */
+	unsigned int nogrow;
 /*
  * Callback function which will check whether the given change for variable
  * "item" to "newval" may be applied or not, and possibly apply such change.
@@ -58,7 +62,10 @@ struct hsearch_data {
 			 enum env_op, int flag);
 };
 
-/* Create a new hash table which will contain at most "nel" elements.  */
+/*
+ * Create a new hash table which will initially hold "nel" elements. It grows
+ * when it becomes three quarters full.
+ */
 int hcreate_r(size_t nel, struct hsearch_data *htab);
 
 /* Destroy current internal hash table.  */
@@ -0,0 +1,26 @@
+/* SPDX-License-Identifier: GPL-2.0+ */
+#ifndef _BLAKE2B_H
+#define _BLAKE2B_H
+
+#define BLAKE2B_SUM_LEN		64
+#define BLAKE2B_BLOCK_SIZE	128
+
+/* Reset watchdog each time we process this many bytes */
+#define CHUNKSZ_BLAKE2B	(64 * 1024)
+
+typedef struct {
+	uint64_t h[8];
+	uint64_t t[2];
+	uint32_t buflen;
+	uint8_t buf[BLAKE2B_BLOCK_SIZE];
+} blake2b_context;
+
+void blake2b_starts(blake2b_context *ctx);
+void blake2b_update(blake2b_context *ctx, const uint8_t *input,
+		    uint32_t length);
+void blake2b_finish(blake2b_context *ctx, uint8_t digest[BLAKE2B_SUM_LEN]);
+
+void blake2b_csum_wd(const unsigned char *input, unsigned int ilen,
+		     unsigned char *output, unsigned int chunk_sz);
+
+#endif /* _BLAKE2B_H */
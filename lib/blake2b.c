@@ -0,0 +1,196 @@
+// SPDX-License-Identifier: GPL-2.0+
+/*
+ * BLAKE2b-512 (RFC 7693), unkeyed
+ *
+ * BLAKE2b works on 64-bit words and needs no message schedule, so it is
+ * considerably faster than SHA-2 in software on 64-bit CPUs.
+ */
+
+#ifndef USE_HOSTCC
+#include <common.h>
+#include <linux/string.h>
+#else
+#include <string.h>
+#endif /* USE_HOSTCC */
+#include <watchdog.h>
+#include <u-boot/blake2b.h>
+
+static const uint64_t blake2b_iv[8] = {
+	0x6a09e667f3bcc908ULL, 0xbb67ae8584caa73bULL,
+	0x3c6ef372fe94f82bULL, 0xa54ff53a5f1d36f1ULL,
+	0x510e527fade682d1ULL, 0x9b05688c2b3e6c1fULL,
+	0x1f83d9abfb41bd6bULL, 0x5be0cd19137e2179ULL
+};
+
+static const uint8_t blake2b_sigma[12][16] = {
+	{  0,  1,  2,  3,  4,  5,  6,  7,  8,  9, 10, 11, 12, 13, 14, 15 },
+	{ 14, 10,  4,  8,  9, 15, 13,  6,  1, 12,  0,  2, 11,  7,  5,  3 },
+	{ 11,  8, 12,  0,  5,  2, 15, 13, 10, 14,  3,  6,  7,  1,  9,  4 },
+	{  7,  9,  3,  1, 13, 12, 11, 14,  2,  6,  5, 10,  4,  0, 15,  8 },
+	{  9,  0,  5,  7,  2,  4, 10, 15, 14,  1, 11, 12,  6,  8,  3, 13 },
+	{  2, 12,  6, 10,  0, 11,  8,  3,  4, 13,  7,  5, 15, 14,  1,  9 },
+	{ 12,  5,  1, 15, 14, 13,  4, 10,  0,  7,  6,  3,  9,  2,  8, 11 },
+	{ 13, 11,  7, 14, 12,  1,  3,  9,  5,  0, 15,  4,  8,  6,  2, 10 },
+	{  6, 15, 14,  9, 11,  3,  0,  8, 12,  2, 13,  7,  1,  4, 10,  5 },
+	{ 10,  2,  8,  4,  7,  6,  1,  5, 15, 11,  9, 14,  3, 12, 13,  0 },
+	{  0,  1,  2,  3,  4,  5,  6,  7,  8,  9, 10, 11, 12, 13, 14, 15 },
+	{ 14, 10,  4,  8,  9, 15, 13,  6,  1, 12,  0,  2, 11,  7,  5,  3 },
+};
+
+static uint64_t get_uint64_le(const uint8_t *b)
+{
+	return (uint64_t)b[0] | ((uint64_t)b[1] << 8) |
+	       ((uint64_t)b[2] << 16) | ((uint64_t)b[3] << 24) |
+	       ((uint64_t)b[4] << 32) | ((uint64_t)b[5] << 40) |
+	       ((uint64_t)b[6] << 48) | ((uint64_t)b[7] << 56);
+}
+
+#define ROTR64(x, n)	(((x) >> (n)) | ((x) << (64 - (n))))
+
+#define G(a, b, c, d, x, y)		\
+	do {				\
+		a = a + b + (x);	\
+		d = ROTR64(d ^ a, 32);	\
+		c = c + d;		\
+		b = ROTR64(b ^ c, 24);	\
+		a = a + b + (y);	\
+		d = ROTR64(d ^ a, 16);	\
+		c = c + d;		\
+		b = ROTR64(b ^ c, 63);	\
+	} while (0)
+
+static void blake2b_compress(blake2b_context *ctx, const uint8_t *block,
+			     int last)
+{
+	uint64_t v[16], m[16];
+	int i;
+
+	for (i = 0; i < 16; i++)
+		m[i] = get_uint64_le(block + i * 8);
+
+	for (i = 0; i < 8; i++) {
+		v[i] = ctx->h[i];
+		v[i + 8] = blake2b_iv[i];
+	}
+	v[12] ^= ctx->t[0];
+	v[13] ^= ctx->t[1];
+	if (last)
+		v[14] = ~v[14];
+
+	for (i = 0; i < 12; i++) {
+		const uint8_t *s = blake2b_sigma[i];
+
+		G(v[0], v[4], v[8],  v[12], m[s[0]],  m[s[1]]);
+		G(v[1], v[5], v[9],  v[13], m[s[2]],  m[s[3]]);
+		G(v[2], v[6], v[10], v[14], m[s[4]],  m[s[5]]);
+		G(v[3], v[7], v[11], v[15], m[s[6]],  m[s[7]]);
+		G(v[0], v[5], v[10], v[15], m[s[8]],  m[s[9]]);
+		G(v[1], v[6], v[11], v[12], m[s[10]], m[s[11]]);
+		G(v[2], v[7], v[8],  v[13], m[s[12]], m[s[13]]);
+		G(v[3], v[4], v[9],  v[14], m[s[14]], m[s[15]]);
+	}
+
+	for (i = 0; i < 8; i++)
+		ctx->h[i] ^= v[i] ^ v[i + 8];
+}
+
+static void blake2b_count(blake2b_context *ctx, uint32_t n)
+{
+	ctx->t[0] += n;
+	if (ctx->t[0] < n)
+		ctx->t[1]++;
+}
+
+void blake2b_starts(blake2b_context *ctx)
+{
+	int i;
+
+	for (i = 0; i < 8; i++)
+		ctx->h[i] = blake2b_iv[i];
+	/* parameter block: 64-byte digest, no key, fanout and depth of 1 */
+	ctx->h[0] ^= 0x01010000ULL | BLAKE2B_SUM_LEN;
+	ctx->t[0] = 0;
+	ctx->t[1] = 0;
+	ctx->buflen = 0;
+}
+
+void blake2b_update(blake2b_context *ctx, const uint8_t *input,
+		    uint32_t length)
+{
+	uint32_t fill;
+
+	if (!length)
+		return;
+
+	/*
+	 * The final block is compressed with a flag set, so a full block is
+	 * only compressed here once more input is known to follow it.
+	 */
+	fill = BLAKE2B_BLOCK_SIZE - ctx->buflen;
+	if (length > fill) {
+		memcpy(ctx->buf + ctx->buflen, input, fill);
+		blake2b_count(ctx, BLAKE2B_BLOCK_SIZE);
+		blake2b_compress(ctx, ctx->buf, 0);
+		ctx->buflen = 0;
+		input += fill;
+		length -= fill;
+
+		while (length > BLAKE2B_BLOCK_SIZE) {
+			blake2b_count(ctx, BLAKE2B_BLOCK_SIZE);
+			blake2b_compress(ctx, input, 0);
+			input += BLAKE2B_BLOCK_SIZE;
+			length -= BLAKE2B_BLOCK_SIZE;
+		}
+	}
+
+	memcpy(ctx->buf + ctx->buflen, input, length);
+	ctx->buflen += length;
+}
+
+void blake2b_finish(blake2b_context *ctx, uint8_t digest[BLAKE2B_SUM_LEN])
+{
+	uint64_t w;
+	int i, j;
+
+	blake2b_count(ctx, ctx->buflen);
+	memset(ctx->buf + ctx->buflen, 0, BLAKE2B_BLOCK_SIZE - ctx->buflen);
+	blake2b_compress(ctx, ctx->buf, 1);
+
+	for (i = 0; i < 8; i++) {
+		w = ctx->h[i];
+		for (j = 0; j < 8; j++, w >>= 8)
+			digest[i * 8 + j] = (uint8_t)w;
+	}
+}
+
+/*
+ * Output = BLAKE2b( input buffer ). Trigger the watchdog every 'chunk_sz'
+ * bytes of input processed.
+ */
+void blake2b_csum_wd(const unsigned char *input, unsigned int ilen,
+		     unsigned char *output, unsigned int chunk_sz)
+{
+	blake2b_context ctx;
+#if defined(CONFIG_HW_WATCHDOG) || defined(CONFIG_WATCHDOG)
+	const unsigned char *end;
+	unsigned int chunk;
+#endif
+
+	blake2b_starts(&ctx);
+
+#if defined(CONFIG_HW_WATCHDOG) || defined(CONFIG_WATCHDOG)
+	end = input + ilen;
+	while (input < end) {
+		chunk = end - input;
+		if (chunk > chunk_sz)
+			chunk = chunk_sz;
+		blake2b_update(&ctx, input, chunk);
+		input += chunk;
+		WATCHDOG_RESET();
+	}
+#else
+	blake2b_update(&ctx, input, ilen);
+#endif
+
+	blake2b_finish(&ctx, output);
+}
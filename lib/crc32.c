@@ -30,6 +30,21 @@
 
 #define tole(x) cpu_to_le32(x)
 
+/*
+ * With CONFIG_CRC32_SLICE_BY_8, eight bytes are folded in per step using
+ * seven more tables (another 7 KiB), see crc32table.h. The host tools
+ * always use it, SPL only with CONFIG_SPL_CRC32_SLICE_BY_8.
+ */
+#ifdef USE_HOSTCC
+#define CRC32_SLICE8
+#elif CONFIG_IS_ENABLED(CRC32_SLICE_BY_8)
+#define CRC32_SLICE8
+#endif
+
+#if !defined(USE_HOSTCC) && defined(CONFIG_CRC32_ARMV8)
+#include <asm/armv8/crc32.h>
+#endif
+
 #ifdef CONFIG_DYNAMIC_CRC_TABLE
 
 static int __efi_runtime_data crc_table_empty = 1;
@@ -156,6 +171,12 @@ tole(0xb40bbe37L), tole(0xc30c8ea1L), tole(0x5a05df1bL), tole(0x2d02ef8dL)
 };
 #endif
 
+#if defined(CRC32_SLICE8) && __BYTE_ORDER == __LITTLE_ENDIAN
+#include "crc32table.h"
+#else
+#undef CRC32_SLICE8
+#endif
+
 #if 0
 /* =========================================================================
  * This function can be used by asm versions of crc32()
@@ -186,6 +207,10 @@ uint32_t __efi_runtime crc32_no_comp(uint32_t crc, const Bytef *buf, uInt len)
     const uint32_t *tab = crc_table;
     const uint32_t *b =(const uint32_t *)buf;
     size_t rem_len;
+#if !defined(USE_HOSTCC) && defined(CONFIG_CRC32_ARMV8)
+    if (crc32_armv8_available())
+	 return crc32_armv8(crc, buf, len);
+#endif
 #ifdef CONFIG_DYNAMIC_CRC_TABLE
     if (crc_table_empty)
       make_crc_table();
@@ -200,6 +225,22 @@ uint32_t __efi_runtime crc32_no_comp(uint32_t crc, const Bytef *buf, uInt len)
 	 b = (uint32_t *)p;
     }
 
+#ifdef CRC32_SLICE8
+    for (; len >= 8; len -= 8, b += 2) {
+	 uint32_t one = b[0] ^ crc;
+	 uint32_t two = b[1];
+
+	 crc = crc_table_slice[6][one & 255] ^
+	       crc_table_slice[5][(one >> 8) & 255] ^
+	       crc_table_slice[4][(one >> 16) & 255] ^
+	       crc_table_slice[3][one >> 24] ^
+	       crc_table_slice[2][two & 255] ^
+	       crc_table_slice[1][(two >> 8) & 255] ^
+	       crc_table_slice[0][(two >> 16) & 255] ^
+	       tab[two >> 24];
+    }
+#endif
+
     rem_len = len & 3;
     len = len >> 2;
     for (--b; len; --len) {
@@ -82,6 +82,82 @@ int gunzip(void *dst, int dstlen, unsigned char *src, unsigned long *lenp)
 	return zunzip(dst, dstlen, src, lenp, 1, offset);
 }
 
+int gunzip_stream(void *dst, ulong dstlen, ulong chunk,
+		  long (*read)(void *priv, ulong pos, void *buf, ulong len),
+		  void *priv, ulong *lenp)
+{
+	unsigned char *buf;
+	ulong pos;
+	z_stream s;
+	int offset, r, ret = -1;
+	long n;
+
+	*lenp = 0;
+	buf = malloc(chunk);
+	if (!buf) {
+		printf("Error: cannot allocate %lu byte buffer\n", chunk);
+		return -1;
+	}
+
+	n = read(priv, 0, buf, chunk);
+	if (n <= 0)
+		goto out_free;
+	pos = n;
+
+	offset = gzip_parse_header(buf, n);
+	if (offset < 0)
+		goto out_free;
+
+	s.zalloc = gzalloc;
+	s.zfree = gzfree;
+
+	r = inflateInit2(&s, -MAX_WBITS);
+	if (r != Z_OK) {
+		printf("Error: inflateInit2() returned %d\n", r);
+		goto out_free;
+	}
+
+	s.next_in = buf + offset;
+	s.avail_in = n - offset;
+	s.next_out = dst;
+	s.avail_out = dstlen;
+
+	do {
+		if (!s.avail_in) {
+			n = read(priv, pos, buf, chunk);
+			if (n <= 0) {
+				if (!n)
+					printf("Error: compressed data truncated\n");
+				goto out_end;
+			}
+			pos += n;
+			s.next_in = buf;
+			s.avail_in = n;
+		}
+
+		r = inflate(&s, Z_SYNC_FLUSH);
+		if (r != Z_OK && r != Z_STREAM_END && r != Z_BUF_ERROR) {
+			printf("Error: inflate() returned %d\n", r);
+			goto out_end;
+		}
+		if (!s.avail_out && r != Z_STREAM_END) {
+			printf("Error: uncompressed data exceeds %lu bytes\n",
+			       dstlen);
+			goto out_end;
+		}
+		WATCHDOG_RESET();
+	} while (r != Z_STREAM_END);
+	ret = 0;
+
+out_end:
+	*lenp = s.next_out - (unsigned char *)dst;
+	inflateEnd(&s);
+out_free:
+	free(buf);
+
+	return ret;
+}
+
 #ifdef CONFIG_CMD_UNZIP
 __weak
 void gzwrite_progress_init(u64 expectedsize)
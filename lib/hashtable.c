@@ -15,7 +15,6 @@
 #include <errno.h>
 #include <log.h>
 #include <malloc.h>
-#include <sort.h>
 
 #ifdef USE_HOSTCC		/* HOST build */
 # include <string.h>
@@ -127,6 +126,14 @@ int hcreate_r(size_t nel, struct hsearch_data *htab)
 	if (htab->table == NULL)
 		return 0;
 
+	htab->sorted = malloc(htab->size * sizeof(*htab->sorted));
+	if (htab->sorted == NULL) {
+		free(htab->table);
+		htab->table = NULL;
+		return 0;
+	}
+	htab->nogrow = 0;
+
 	/* everything went alright */
 	return 1;
 }
@@ -161,9 +168,141 @@ void hdestroy_r(struct hsearch_data *htab)
 		}
 	}
 	free(htab->table);
+	free(htab->sorted);
 
 	/* the sign for an existing table is an value != NULL in htable */
 	htab->table = NULL;
+	htab->sorted = NULL;
+}
+
+/*
+ * Compute the first hash index for a key, which is never zero. This is also
+ * stored in the used field of the node.
+ */
+static unsigned int hash_key(const char *key, unsigned int size)
+{
+	unsigned int len = strlen(key);
+	unsigned int hval = len;
+	unsigned int count = len;
+
+	/* Compute an value for the given string. Perhaps use a better method. */
+	while (count-- > 0) {
+		hval <<= 4;
+		hval += key[count];
+	}
+
+	/*
+	 * First hash function:
+	 * simply take the modul but prevent zero.
+	 */
+	hval %= size;
+	if (hval == 0)
+		++hval;
+
+	return hval;
+}
+
+/*
+ * The used entries are also kept in an array of table indices sorted by key,
+ * which hexport() walks instead of sorting the table each time. Variables are
+ * mostly entered in order (e.g. when importing an exported environment), so
+ * an insertion usually just appends.
+ */
+
+/* Return the position of the first entry in sorted order not below key */
+static unsigned int hsorted_pos(struct hsearch_data *htab, const char *key)
+{
+	unsigned int lo = 0, hi = htab->filled;
+
+	if (hi && strcmp(htab->table[htab->sorted[hi - 1]].entry.key, key) < 0)
+		return hi;
+
+	while (lo < hi) {
+		unsigned int mid = lo + (hi - lo) / 2;
+
+		if (strcmp(htab->table[htab->sorted[mid]].entry.key, key) < 0)
+			lo = mid + 1;
+		else
+			hi = mid;
+	}
+
+	return lo;
+}
+
+/* Add a new entry to the sorted list, before incrementing htab->filled */
+static void hsorted_insert(struct hsearch_data *htab, unsigned int idx)
+{
+	unsigned int pos = hsorted_pos(htab, htab->table[idx].entry.key);
+
+	memmove(&htab->sorted[pos + 1], &htab->sorted[pos],
+		(htab->filled - pos) * sizeof(*htab->sorted));
+	htab->sorted[pos] = idx;
+}
+
+/* Remove an entry from the sorted list, before decrementing htab->filled */
+static void hsorted_remove(struct hsearch_data *htab, unsigned int idx)
+{
+	unsigned int pos = hsorted_pos(htab, htab->table[idx].entry.key);
+
+	if (pos >= htab->filled || htab->sorted[pos] != idx)
+		return;
+	memmove(&htab->sorted[pos], &htab->sorted[pos + 1],
+		(htab->filled - pos - 1) * sizeof(*htab->sorted));
+}
+
+/*
+ * Move all entries to a table about twice the size. Keys, data, callbacks and
+ * flags move along as they are; only the positions are computed again, and
+ * deleted slots are dropped. Entry pointers handed out before are invalid
+ * afterwards.
+ */
+static int hgrow_r(struct hsearch_data *htab)
+{
+	struct env_entry_node *table;
+	unsigned int *sorted;
+	unsigned int size, i;
+
+	if (htab->nogrow)
+		return -EBUSY;
+
+	size = htab->size * 2 + 1;
+	while (!isprime(size))
+		size += 2;
+
+	table = calloc(size + 1, sizeof(struct env_entry_node));
+	sorted = malloc(size * sizeof(*sorted));
+	if (table == NULL || sorted == NULL) {
+		free(table);
+		free(sorted);
+		return -ENOMEM;
+	}
+
+	for (i = 0; i < htab->filled; i++) {
+		struct env_entry_node *node = &htab->table[htab->sorted[i]];
+		unsigned int hval = hash_key(node->entry.key, size);
+		unsigned int hval2 = 1 + hval % (size - 2);
+		unsigned int idx = hval;
+
+		/* the new table has no deleted or equal entries */
+		while (table[idx].used != USED_FREE) {
+			if (idx <= hval2)
+				idx = size + idx - hval2;
+			else
+				idx -= hval2;
+		}
+		table[idx].used = hval;
+		table[idx].entry = node->entry;
+		sorted[i] = idx;
+	}
+
+	debug("hgrow: %u entries moved to table of %u\n", htab->filled, size);
+	free(htab->table);
+	free(htab->sorted);
+	htab->table = table;
+	htab->sorted = sorted;
+	htab->size = size;
+
+	return 0;
 }
 
 /*
@@ -224,14 +363,20 @@ int hmatch_r(const char *match, int last_idx, struct env_entry **retval,
 }
 
 static int
-do_callback(const struct env_entry *e, const char *name, const char *value,
-	    enum env_op op, int flags)
+do_callback(struct hsearch_data *htab, const struct env_entry *e,
+	    const char *name, const char *value, enum env_op op, int flags)
 {
+	int ret = 0;
+
 #ifndef CONFIG_SPL_BUILD
-	if (e->callback)
-		return e->callback(name, value, op, flags);
+	if (e->callback) {
+		/* the caller holds on to the entry, so it must not move */
+		htab->nogrow++;
+		ret = e->callback(name, value, op, flags);
+		htab->nogrow--;
+	}
 #endif
-	return 0;
+	return ret;
 }
 
 /*
@@ -259,7 +404,7 @@ static inline int _compare_and_overwrite_entry(struct env_entry item,
 			}
 
 			/* If there is a callback, call it */
-			if (do_callback(&htab->table[idx].entry, item.key,
+			if (do_callback(htab, &htab->table[idx].entry, item.key,
 					item.data, env_op_overwrite, flag)) {
 				debug("callback() rejected setting variable "
 					"%s, skipping it!\n", item.key);
@@ -288,27 +433,11 @@ int hsearch_r(struct env_entry item, enum env_action action,
 	      struct env_entry **retval, struct hsearch_data *htab, int flag)
 {
 	unsigned int hval;
-	unsigned int count;
-	unsigned int len = strlen(item.key);
 	unsigned int idx;
 	unsigned int first_deleted = 0;
 	int ret;
 
-	/* Compute an value for the given string. Perhaps use a better method. */
-	hval = len;
-	count = len;
-	while (count-- > 0) {
-		hval <<= 4;
-		hval += item.key[count];
-	}
-
-	/*
-	 * First hash function:
-	 * simply take the modul but prevent zero.
-	 */
-	hval %= htab->size;
-	if (hval == 0)
-		++hval;
+	hval = hash_key(item.key, htab->size);
 
 	/* The first index tried. */
 	idx = hval;
@@ -367,6 +496,14 @@ int hsearch_r(struct env_entry item, enum env_action action,
 
 	/* An empty bucket has been found. */
 	if (action == ENV_ENTER) {
+		/*
+		 * Keep the table at most three quarters full, so that probe
+		 * sequences stay short. Growing moves all entries, so search
+		 * again afterwards.
+		 */
+		if ((htab->filled + 1) * 4 > htab->size * 3 && !hgrow_r(htab))
+			return hsearch_r(item, action, retval, htab, flag);
+
 		/*
 		 * If table is full and another entry should be
 		 * entered return with error.
@@ -394,6 +531,7 @@ int hsearch_r(struct env_entry item, enum env_action action,
 			return 0;
 		}
 
+		hsorted_insert(htab, idx);
 		++htab->filled;
 
 		/* This is a new entry, so look up a possible callback */
@@ -413,8 +551,8 @@ int hsearch_r(struct env_entry item, enum env_action action,
 		}
 
 		/* If there is a callback, call it */
-		if (do_callback(&htab->table[idx].entry, item.key, item.data,
-				env_op_create, flag)) {
+		if (do_callback(htab, &htab->table[idx].entry, item.key,
+				item.data, env_op_create, flag)) {
 			debug("callback() rejected setting variable "
 				"%s, skipping it!\n", item.key);
 			_hdelete(item.key, htab, &htab->table[idx].entry, idx);
@@ -449,6 +587,7 @@ static void _hdelete(const char *key, struct hsearch_data *htab,
 {
 	/* free used entry */
 	debug("hdelete: DELETING key \"%s\"\n", key);
+	hsorted_remove(htab, idx);
 	free((void *)ep->key);
 	free(ep->data);
 	ep->flags = 0;
@@ -482,7 +621,7 @@ int hdelete_r(const char *key, struct hsearch_data *htab, int flag)
 	}
 
 	/* If there is a callback, call it */
-	if (do_callback(&htab->table[idx].entry, key, NULL,
+	if (do_callback(htab, &htab->table[idx].entry, key, NULL,
 			env_op_delete, flag)) {
 		debug("callback() rejected deleting variable "
 			"%s, skipping it!\n", key);
@@ -538,14 +677,6 @@ int hdelete_r(const char *key, struct hsearch_data *htab, int flag)
  *		bytes in the string will be '\0'-padded.
  */
 
-static int cmpkey(const void *p1, const void *p2)
-{
-	struct env_entry *e1 = *(struct env_entry **)p1;
-	struct env_entry *e2 = *(struct env_entry **)p2;
-
-	return (strcmp(e1->key, e2->key));
-}
-
 static int match_string(int flag, const char *str, const char *pat, void *priv)
 {
 	switch (flag & H_MATCH_METHOD) {
@@ -604,14 +735,26 @@ static int match_entry(struct env_entry *ep, int flag, int argc,
 	return 0;
 }
 
+/* Check whether an entry is selected for export */
+static int export_entry(struct env_entry *ep, int flag, int argc,
+			char *const argv[])
+{
+	if ((argc > 0) && (match_entry(ep, flag, argc, argv) == 0))
+		return 0;
+
+	if ((flag & H_HIDE_DOT) && ep->key[0] == '.')
+		return 0;
+
+	return 1;
+}
+
 ssize_t hexport_r(struct hsearch_data *htab, const char sep, int flag,
 		 char **resp, size_t size,
 		 int argc, char *const argv[])
 {
-	struct env_entry *list[htab->size];
 	char *res, *p;
 	size_t totlen;
-	int i, n;
+	int i;
 
 	/* Test for correct arguments.  */
 	if ((resp == NULL) || (htab == NULL)) {
@@ -623,54 +766,32 @@ ssize_t hexport_r(struct hsearch_data *htab, const char sep, int flag,
 	      htab, htab->size, htab->filled, (ulong)size);
 	/*
 	 * Pass 1:
-	 * search used entries,
-	 * save addresses and compute total length
+	 * compute total length of the selected entries
 	 */
-	for (i = 1, n = 0, totlen = 0; i <= htab->size; ++i) {
-
-		if (htab->table[i].used > 0) {
-			struct env_entry *ep = &htab->table[i].entry;
-			int found = match_entry(ep, flag, argc, argv);
-
-			if ((argc > 0) && (found == 0))
-				continue;
-
-			if ((flag & H_HIDE_DOT) && ep->key[0] == '.')
-				continue;
+	for (i = 0, totlen = 0; i < htab->filled; ++i) {
+		struct env_entry *ep = &htab->table[htab->sorted[i]].entry;
 
-			list[n++] = ep;
+		if (!export_entry(ep, flag, argc, argv))
+			continue;
 
-			totlen += strlen(ep->key);
+		totlen += strlen(ep->key);
 
-			if (sep == '\0') {
-				totlen += strlen(ep->data);
-			} else {	/* check if escapes are needed */
-				char *s = ep->data;
+		if (sep == '\0') {
+			totlen += strlen(ep->data);
+		} else {	/* check if escapes are needed */
+			char *s = ep->data;
 
-				while (*s) {
+			while (*s) {
+				++totlen;
+				/* add room for needed escape chars */
+				if ((*s == sep) || (*s == '\\'))
 					++totlen;
-					/* add room for needed escape chars */
-					if ((*s == sep) || (*s == '\\'))
-						++totlen;
-					++s;
-				}
+				++s;
 			}
-			totlen += 2;	/* for '=' and 'sep' char */
 		}
+		totlen += 2;	/* for '=' and 'sep' char */
 	}
 
-#ifdef DEBUG
-	/* Pass 1a: print unsorted list */
-	printf("Unsorted: n=%d\n", n);
-	for (i = 0; i < n; ++i) {
-		printf("\t%3d: %p ==> %-10s => %s\n",
-		       i, list[i], list[i]->key, list[i]->data);
-	}
-#endif
-
-	/* Sort list by keys */
-	qsort(list, n, sizeof(struct env_entry *), cmpkey);
-
 	/* Check if the user supplied buffer size is sufficient */
 	if (size) {
 		if (size < totlen + 1) {	/* provided buffer too small */
@@ -698,17 +819,21 @@ ssize_t hexport_r(struct hsearch_data *htab, const char sep, int flag,
 	}
 	/*
 	 * Pass 2:
-	 * export sorted list of result data
+	 * export selected entries in sorted order
 	 */
-	for (i = 0, p = res; i < n; ++i) {
+	for (i = 0, p = res; i < htab->filled; ++i) {
+		struct env_entry *ep = &htab->table[htab->sorted[i]].entry;
 		const char *s;
 
-		s = list[i]->key;
+		if (!export_entry(ep, flag, argc, argv))
+			continue;
+
+		s = ep->key;
 		while (*s)
 			*p++ = *s++;
 		*p++ = '=';
 
-		s = list[i]->data;
+		s = ep->data;
 
 		while (*s) {
 			if ((*s == sep) || (*s == '\\'))
@@ -794,13 +919,37 @@ static int drop_var_from_set(const char *name, int nvars, char * vars[])
  * '\0' and '\n' have really been tested.
  */
 
+/* Make sure the import buffer can hold len bytes; its contents are lost */
+static int himport_buf(char **buf, size_t *buflen, size_t len)
+{
+	if (len <= *buflen)
+		return 0;
+
+	if (len < 2 * *buflen)
+		len = 2 * *buflen;
+	free(*buf);
+	*buf = malloc(len);
+	if (*buf == NULL) {
+		debug("himport_r: can't malloc %lu bytes\n", (ulong)len);
+		*buflen = 0;
+		__set_errno(ENOMEM);
+		return -ENOMEM;
+	}
+	*buflen = len;
+
+	return 0;
+}
+
 int himport_r(struct hsearch_data *htab,
 		const char *env, size_t size, const char sep, int flag,
 		int crlf_is_lf, int nvars, char * const vars[])
 {
-	char *data, *sp, *dp, *name, *value;
+	char *data = NULL, *buf = NULL, *name, *value;
+	const char *dp, *end, *np, *vp;
+	size_t buflen = 0, name_len, value_len;
 	char *localvars[nvars];
-	int i;
+	int escaped, in_place;
+	int i, ret = 0;
 
 	/* Test for correct arguments.  */
 	if (htab == NULL) {
@@ -808,16 +957,6 @@ int himport_r(struct hsearch_data *htab,
 		return 0;
 	}
 
-	/* we allocate new space to make sure we can write to the array */
-	if ((data = malloc(size + 1)) == NULL) {
-		debug("himport_r: can't malloc %lu bytes\n", (ulong)size + 1);
-		__set_errno(ENOMEM);
-		return 0;
-	}
-	memcpy(data, env, size);
-	data[size] = '\0';
-	dp = data;
-
 	/* make a local copy of the list of variables */
 	if (nvars)
 		memcpy(localvars, vars, sizeof(vars[0]) * nvars);
@@ -845,7 +984,8 @@ int himport_r(struct hsearch_data *htab,
 	 * environment size), so we clip it to a reasonable value.
 	 * On the other hand we need to add some more entries for free
 	 * space when importing very small buffers. Both boundaries can
-	 * be overwritten in the board config file if needed.
+	 * be overwritten in the board config file if needed. The table
+	 * grows when an environment needs more entries.
 	 */
 
 	if (!htab->table) {
@@ -856,55 +996,77 @@ int himport_r(struct hsearch_data *htab,
 
 		debug("Create Hash Table: N=%d\n", nent);
 
-		if (hcreate_r(nent, htab) == 0) {
-			free(data);
+		if (hcreate_r(nent, htab) == 0)
 			return 0;
-		}
 	}
 
-	if (!size) {
-		free(data);
+	if (!size)
 		return 1;		/* everything OK */
-	}
 	if(crlf_is_lf) {
+		char *cp;
+
+		/* we allocate new space to make sure we can write to the array */
+		if ((data = malloc(size + 1)) == NULL) {
+			debug("himport_r: can't malloc %lu bytes\n",
+			      (ulong)size + 1);
+			__set_errno(ENOMEM);
+			return 0;
+		}
+		memcpy(data, env, size);
+		data[size] = '\0';
+
 		/* Remove Carriage Returns in front of Line Feeds */
 		unsigned ignored_crs = 0;
-		for(;dp < data + size && *dp; ++dp) {
-			if(*dp == '\r' &&
-			   dp < data + size - 1 && *(dp+1) == '\n')
+		for(cp = data; cp < data + size && *cp; ++cp) {
+			if(*cp == '\r' &&
+			   cp < data + size - 1 && *(cp+1) == '\n')
 				++ignored_crs;
 			else
-				*(dp-ignored_crs) = *dp;
+				*(cp-ignored_crs) = *cp;
 		}
 		size -= ignored_crs;
-		dp = data;
+		env = data;
 	}
-	/* Parse environment; allow for '\0' and 'sep' as separators */
+	/*
+	 * Parse environment; allow for '\0' and 'sep' as separators. The
+	 * input is only read: names, and values which need unescaping or are
+	 * not NUL terminated, are copied to a small buffer, all other values
+	 * are entered straight from the input.
+	 */
+	dp = env;
+	end = env + size;
 	do {
 		struct env_entry e, *rv;
 
 		/* skip leading white space */
-		while (isblank(*dp))
+		while (dp < end && isblank(*dp))
 			++dp;
 
 		/* skip comment lines */
-		if (*dp == '#') {
-			while (*dp && (*dp != sep))
+		if (dp < end && *dp == '#') {
+			while (dp < end && *dp && (*dp != sep))
 				++dp;
 			++dp;
 			continue;
 		}
 
 		/* parse name */
-		for (name = dp; *dp != '=' && *dp && *dp != sep; ++dp)
+		for (np = dp; dp < end && *dp != '=' && *dp && *dp != sep; ++dp)
 			;
+		name_len = dp - np;
 
 		/* deal with "name" and "name=" entries (delete var) */
-		if (*dp == '\0' || *(dp + 1) == '\0' ||
-		    *dp == sep || *(dp + 1) == sep) {
-			if (*dp == '=')
-				*dp++ = '\0';
-			*dp++ = '\0';	/* terminate name */
+		if (dp == end || *dp != '=' || dp + 1 == end ||
+		    *(dp + 1) == '\0' || *(dp + 1) == sep) {
+			if (dp < end && *dp == '=')
+				++dp;
+			++dp;	/* skip separator */
+
+			if (himport_buf(&buf, &buflen, name_len + 1))
+				goto out;
+			name = buf;
+			memcpy(name, np, name_len);
+			name[name_len] = '\0';
 
 			debug("DELETE CANDIDATE: \"%s\"\n", name);
 			if (!drop_var_from_set(name, nvars, localvars))
@@ -915,22 +1077,45 @@ int himport_r(struct hsearch_data *htab,
 
 			continue;
 		}
-		*dp++ = '\0';	/* terminate name */
+		++dp;	/* skip '=' */
 
 		/* parse value; deal with escapes */
-		for (value = sp = dp; *dp && (*dp != sep); ++dp) {
-			if ((*dp == '\\') && *(dp + 1))
+		escaped = 0;
+		for (vp = dp; dp < end && *dp && (*dp != sep); ++dp) {
+			if ((*dp == '\\') && dp + 1 < end && *(dp + 1)) {
+				escaped = 1;
 				++dp;
-			*sp++ = *dp;
+			}
 		}
-		*sp++ = '\0';	/* terminate value */
+		value_len = dp - vp;
+		in_place = !escaped && dp < end && *dp == '\0';
 		++dp;
 
+		if (himport_buf(&buf, &buflen,
+				name_len + 1 + (in_place ? 0 : value_len + 1)))
+			goto out;
+		name = buf;
+		memcpy(name, np, name_len);
+		name[name_len] = '\0';
+
+		if (in_place) {
+			value = (char *)vp;
+		} else {
+			char *sp;
+
+			value = sp = buf + name_len + 1;
+			for (; vp < dp - 1; ++vp) {
+				if ((*vp == '\\') && vp + 1 < dp - 1)
+					++vp;
+				*sp++ = *vp;
+			}
+			*sp = '\0';	/* terminate value */
+		}
+
 		if (*name == 0) {
 			debug("INSERT: unable to use an empty key\n");
 			__set_errno(EINVAL);
-			free(data);
-			return 0;
+			goto out;
 		}
 
 		/* Skip variables which are not supposed to be processed */
@@ -949,13 +1134,11 @@ int himport_r(struct hsearch_data *htab,
 		debug("INSERT: table %p, filled %d/%d rv %p ==> name=\"%s\" value=\"%s\"\n",
 			htab, htab->filled, htab->size,
 			rv, name, value);
-	} while ((dp < data + size) && *dp);	/* size check needed for text */
-						/* without '\0' termination */
-	debug("INSERT: free(data = %p)\n", data);
-	free(data);
-
+	} while ((dp < end) && *dp);	/* size check needed for text */
+					/* without '\0' termination */
+	ret = 1;
 	if (flag & H_NOCLEAR)
-		goto end;
+		goto out;
 
 	/* process variables which were not considered */
 	for (i = 0; i < nvars; i++) {
@@ -975,9 +1158,11 @@ int himport_r(struct hsearch_data *htab,
 			printf("WARNING: '%s' not in imported env, deleting it!\n", localvars[i]);
 	}
 
-end:
-	debug("INSERT: done\n");
-	return 1;		/* everything OK */
+out:
+	debug("INSERT: free(data = %p, buf = %p)\n", data, buf);
+	free(data);
+	free(buf);
+	return ret;
 }
 
 /*
@@ -991,15 +1176,17 @@ end:
 int hwalk_r(struct hsearch_data *htab, int (*callback)(struct env_entry *entry))
 {
 	int i;
-	int retval;
+	int retval = 0;
 
+	htab->nogrow++;
 	for (i = 1; i <= htab->size; ++i) {
 		if (htab->table[i].used > 0) {
 			retval = callback(&htab->table[i].entry);
 			if (retval)
-				return retval;
+				break;
 		}
 	}
+	htab->nogrow--;
 
-	return 0;
+	return retval;
 }
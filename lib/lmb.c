@@ -74,14 +74,59 @@ static long lmb_regions_adjacent(struct lmb_region *rgn, unsigned long r1,
 	return lmb_addrs_adjacent(base1, size1, base2, size2);
 }
 
-static void lmb_remove_region(struct lmb_region *rgn, unsigned long r)
+/*
+ * Return the index of the last region starting at or below addr, or -1 if
+ * all regions start above it
+ */
+static long lmb_find_region(struct lmb_region *rgn, phys_addr_t addr)
 {
-	unsigned long i;
+	unsigned long lo = 0, hi = rgn->cnt;
+
+	while (lo < hi) {
+		unsigned long mid = lo + (hi - lo) / 2;
 
-	for (i = r; i < rgn->cnt - 1; i++) {
-		rgn->region[i].base = rgn->region[i + 1].base;
-		rgn->region[i].size = rgn->region[i + 1].size;
+		if (rgn->region[mid].base <= addr)
+			lo = mid + 1;
+		else
+			hi = mid;
 	}
+
+	return (long)lo - 1;
+}
+
+/* Double the capacity of the region array, moving it to the heap */
+static int lmb_grow_region(struct lmb_region *rgn)
+{
+	struct lmb_property *region;
+	unsigned long max = rgn->max * 2;
+
+	region = malloc(max * sizeof(*region));
+	if (!region)
+		return -ENOMEM;
+
+	memcpy(region, rgn->region, rgn->cnt * sizeof(*region));
+	if (rgn->region != rgn->initial_region)
+		free(rgn->region);
+	rgn->region = region;
+	rgn->max = max;
+
+	return 0;
+}
+
+static void lmb_insert_region(struct lmb_region *rgn, unsigned long r,
+			      phys_addr_t base, phys_size_t size)
+{
+	memmove(&rgn->region[r + 1], &rgn->region[r],
+		(rgn->cnt - r) * sizeof(*rgn->region));
+	rgn->region[r].base = base;
+	rgn->region[r].size = size;
+	rgn->cnt++;
+}
+
+static void lmb_remove_region(struct lmb_region *rgn, unsigned long r)
+{
+	memmove(&rgn->region[r], &rgn->region[r + 1],
+		(rgn->cnt - r - 1) * sizeof(*rgn->region));
 	rgn->cnt--;
 }
 
@@ -93,12 +138,34 @@ static void lmb_coalesce_regions(struct lmb_region *rgn, unsigned long r1,
 	lmb_remove_region(rgn, r2);
 }
 
+static void lmb_init_region(struct lmb_region *rgn)
+{
+	rgn->cnt = 0;
+	rgn->size = 0;
+	rgn->max = ARRAY_SIZE(rgn->initial_region);
+	rgn->region = rgn->initial_region;
+}
+
 void lmb_init(struct lmb *lmb)
 {
-	lmb->memory.cnt = 0;
-	lmb->memory.size = 0;
-	lmb->reserved.cnt = 0;
-	lmb->reserved.size = 0;
+	lmb_init_region(&lmb->memory);
+	lmb_init_region(&lmb->reserved);
+}
+
+static void lmb_uninit_region(struct lmb_region *rgn)
+{
+	if (rgn->region != rgn->initial_region)
+		free(rgn->region);
+	rgn->region = NULL;
+	rgn->cnt = 0;
+	rgn->max = 0;
+}
+
+/* Free the region arrays grown beyond MAX_LMB_REGIONS entries */
+void lmb_uninit(struct lmb *lmb)
+{
+	lmb_uninit_region(&lmb->memory);
+	lmb_uninit_region(&lmb->reserved);
 }
 
 static void lmb_reserve_common(struct lmb *lmb, void *fdt_blob)
@@ -145,68 +212,49 @@ void lmb_init_and_reserve_range(struct lmb *lmb, phys_addr_t base,
 static long lmb_add_region(struct lmb_region *rgn, phys_addr_t base, phys_size_t size)
 {
 	unsigned long coalesced = 0;
-	long adjacent, i;
+	long i;
 
-	if (rgn->cnt == 0) {
-		rgn->region[0].base = base;
-		rgn->region[0].size = size;
-		rgn->cnt = 1;
-		return 0;
-	}
-
-	/* First try and coalesce this LMB with another. */
-	for (i = 0; i < rgn->cnt; i++) {
+	/* Only the regions either side of base can overlap or be adjacent */
+	i = lmb_find_region(rgn, base);
+	if (i >= 0) {
 		phys_addr_t rgnbase = rgn->region[i].base;
 		phys_size_t rgnsize = rgn->region[i].size;
 
 		if ((rgnbase == base) && (rgnsize == size))
 			/* Already have this region, so we're done */
 			return 0;
-
-		adjacent = lmb_addrs_adjacent(base, size, rgnbase, rgnsize);
-		if (adjacent > 0) {
-			rgn->region[i].base -= size;
-			rgn->region[i].size += size;
-			coalesced++;
-			break;
-		} else if (adjacent < 0) {
-			rgn->region[i].size += size;
-			coalesced++;
-			break;
-		} else if (lmb_addrs_overlap(base, size, rgnbase, rgnsize)) {
-			/* regions overlap */
+		if (lmb_addrs_overlap(base, size, rgnbase, rgnsize))
 			return -1;
-		}
 	}
+	if (i + 1 < rgn->cnt &&
+	    lmb_addrs_overlap(base, size, rgn->region[i + 1].base,
+			      rgn->region[i + 1].size))
+		return -1;
 
-	if ((i < rgn->cnt - 1) && lmb_regions_adjacent(rgn, i, i + 1)) {
-		lmb_coalesce_regions(rgn, i, i + 1);
+	/* First try and coalesce this LMB with its neighbours. */
+	if (i >= 0 && lmb_addrs_adjacent(base, size, rgn->region[i].base,
+					 rgn->region[i].size) < 0) {
+		rgn->region[i].size += size;
+		coalesced++;
+		if ((i + 1 < rgn->cnt) && lmb_regions_adjacent(rgn, i, i + 1)) {
+			lmb_coalesce_regions(rgn, i, i + 1);
+			coalesced++;
+		}
+	} else if (i + 1 < rgn->cnt &&
+		   lmb_addrs_adjacent(base, size, rgn->region[i + 1].base,
+				      rgn->region[i + 1].size) > 0) {
+		rgn->region[i + 1].base -= size;
+		rgn->region[i + 1].size += size;
 		coalesced++;
 	}
 
 	if (coalesced)
 		return coalesced;
-	if (rgn->cnt >= MAX_LMB_REGIONS)
+	if (rgn->cnt >= rgn->max && lmb_grow_region(rgn))
 		return -1;
 
 	/* Couldn't coalesce the LMB, so add it to the sorted table. */
-	for (i = rgn->cnt-1; i >= 0; i--) {
-		if (base < rgn->region[i].base) {
-			rgn->region[i + 1].base = rgn->region[i].base;
-			rgn->region[i + 1].size = rgn->region[i].size;
-		} else {
-			rgn->region[i + 1].base = base;
-			rgn->region[i + 1].size = size;
-			break;
-		}
-	}
-
-	if (base < rgn->region[0].base) {
-		rgn->region[0].base = base;
-		rgn->region[0].size = size;
-	}
-
-	rgn->cnt++;
+	lmb_insert_region(rgn, i + 1, base, size);
 
 	return 0;
 }
@@ -224,21 +272,17 @@ long lmb_free(struct lmb *lmb, phys_addr_t base, phys_size_t size)
 	struct lmb_region *rgn = &(lmb->reserved);
 	phys_addr_t rgnbegin, rgnend;
 	phys_addr_t end = base + size - 1;
-	int i;
-
-	rgnbegin = rgnend = 0; /* supress gcc warnings */
+	long i;
 
 	/* Find the region where (base, size) belongs to */
-	for (i = 0; i < rgn->cnt; i++) {
-		rgnbegin = rgn->region[i].base;
-		rgnend = rgnbegin + rgn->region[i].size - 1;
-
-		if ((rgnbegin <= base) && (end <= rgnend))
-			break;
-	}
+	i = lmb_find_region(rgn, base);
+	if (i < 0)
+		return -1;
+	rgnbegin = rgn->region[i].base;
+	rgnend = rgnbegin + rgn->region[i].size - 1;
 
 	/* Didn't find the region */
-	if (i == rgn->cnt)
+	if (end > rgnend)
 		return -1;
 
 	/* Check to see if we are removing entire region */
@@ -275,19 +319,18 @@ long lmb_reserve(struct lmb *lmb, phys_addr_t base, phys_size_t size)
 	return lmb_add_region(_rgn, base, size);
 }
 
+/* Return the index of the highest region overlapping (base, size), or -1 */
 static long lmb_overlaps_region(struct lmb_region *rgn, phys_addr_t base,
 				phys_size_t size)
 {
-	unsigned long i;
+	long i;
 
-	for (i = 0; i < rgn->cnt; i++) {
-		phys_addr_t rgnbase = rgn->region[i].base;
-		phys_size_t rgnsize = rgn->region[i].size;
-		if (lmb_addrs_overlap(base, size, rgnbase, rgnsize))
-			break;
-	}
+	i = lmb_find_region(rgn, base + size - 1);
+	if (i >= 0 && lmb_addrs_overlap(base, size, rgn->region[i].base,
+					rgn->region[i].size))
+		return i;
 
-	return (i < rgn->cnt) ? i : -1;
+	return -1;
 }
 
 phys_addr_t lmb_alloc(struct lmb *lmb, phys_size_t size, ulong align)
@@ -332,13 +375,25 @@ phys_addr_t __lmb_alloc_base(struct lmb *lmb, phys_size_t size, ulong align, phy
 			if (base < lmbbase)
 				base = -1;
 			base = min(base, max_addr);
+			if (base - lmbbase < size)
+				continue;
 			base = lmb_align_down(base - size, align);
 		} else
 			continue;
 
+		/*
+		 * Walk down the reserved regions from the top of the candidate
+		 * area, each step skipping below the region in the way.
+		 */
+		rgn = lmb_find_region(&lmb->reserved, base + size - 1);
 		while (base && lmbbase <= base) {
-			rgn = lmb_overlaps_region(&lmb->reserved, base, size);
-			if (rgn < 0) {
+			while (rgn >= 0 &&
+			       lmb->reserved.region[rgn].base > base + size - 1)
+				rgn--;
+			if (rgn < 0 ||
+			    !lmb_addrs_overlap(base, size,
+					       lmb->reserved.region[rgn].base,
+					       lmb->reserved.region[rgn].size)) {
 				/* This area isn't reserved, take it */
 				if (lmb_add_region(&lmb->reserved, base,
 						   size) < 0)
@@ -363,7 +418,7 @@ phys_addr_t lmb_alloc_addr(struct lmb *lmb, phys_addr_t base, phys_size_t size)
 	long rgn;
 
 	/* Check if the requested address is in one of the memory regions */
-	rgn = lmb_overlaps_region(&lmb->memory, base, size);
+	rgn = lmb_overlaps_region(&lmb->memory, base, 1);
 	if (rgn >= 0) {
 		/*
 		 * Check if the requested end address is in the same memory
@@ -383,22 +438,20 @@ phys_addr_t lmb_alloc_addr(struct lmb *lmb, phys_addr_t base, phys_size_t size)
 /* Return number of bytes from a given address that are free */
 phys_size_t lmb_get_free_size(struct lmb *lmb, phys_addr_t addr)
 {
-	int i;
-	long rgn;
+	long i, rgn;
 
 	/* check if the requested address is in the memory regions */
 	rgn = lmb_overlaps_region(&lmb->memory, addr, 1);
 	if (rgn >= 0) {
-		for (i = 0; i < lmb->reserved.cnt; i++) {
-			if (addr < lmb->reserved.region[i].base) {
-				/* first reserved range > requested address */
-				return lmb->reserved.region[i].base - addr;
-			}
-			if (lmb->reserved.region[i].base +
-			    lmb->reserved.region[i].size > addr) {
-				/* requested addr is in this reserved range */
-				return 0;
-			}
+		i = lmb_overlaps_region(&lmb->reserved, addr, 1);
+		if (i >= 0) {
+			/* requested addr is in this reserved range */
+			return 0;
+		}
+		i = lmb_find_region(&lmb->reserved, addr) + 1;
+		if (i < lmb->reserved.cnt) {
+			/* first reserved range > requested address */
+			return lmb->reserved.region[i].base - addr;
 		}
 		/* if we come here: no reserved ranges above requested addr */
 		return lmb->memory.region[lmb->memory.cnt - 1].base +
@@ -409,15 +462,7 @@ phys_size_t lmb_get_free_size(struct lmb *lmb, phys_addr_t addr)
 
 int lmb_is_reserved(struct lmb *lmb, phys_addr_t addr)
 {
-	int i;
-
-	for (i = 0; i < lmb->reserved.cnt; i++) {
-		phys_addr_t upper = lmb->reserved.region[i].base +
-			lmb->reserved.region[i].size - 1;
-		if ((addr >= lmb->reserved.region[i].base) && (addr <= upper))
-			return 1;
-	}
-	return 0;
+	return lmb_overlaps_region(&lmb->reserved, addr, 1) >= 0;
 }
 
 __weak void board_lmb_reserve(struct lmb *lmb)
@@ -12,6 +12,8 @@
 #include <linux/errno.h>
 #include <asm/types.h>
 #include <asm/unaligned.h>
+#include <malloc.h>
+DECLARE_GLOBAL_DATA_PTR;
 #else
 #include "fdt_host.h"
 #include "mkimage.h"
@@ -28,21 +30,71 @@
 /* Default public exponent for backward compatibility */
 #define RSA_DEFAULT_PUBEXP	65537
 
+/*
+ * The Montgomery arithmetic works on limbs of the native word size: with a
+ * 64-bit multiplier, 64-bit limbs need a quarter of the multiplications of
+ * 32-bit ones.
+ */
+#ifdef __SIZEOF_INT128__
+typedef uint64_t rsa_limb_t;
+typedef unsigned __int128 rsa_dlimb_t;
+#else
+typedef uint32_t rsa_limb_t;
+typedef uint64_t rsa_dlimb_t;
+#endif
+
+#define RSA_LIMB_BITS		(sizeof(rsa_limb_t) * 8)
+#define RSA_LIMB_WORDS		(sizeof(rsa_limb_t) / sizeof(uint32_t))
+
+/* Sliding window used for exponents with over RSA_WINDOW_ENTRIES bits set */
+#define RSA_WINDOW_BITS		4
+#define RSA_WINDOW_ENTRIES	(1 << (RSA_WINDOW_BITS - 1))
+
+/* Number of keys whose Montgomery parameters are kept between calls */
+#define RSA_KEY_CACHE_SIZE	4
+
+/**
+ * struct rsa_mont_key - RSA modulus prepared for Montgomery arithmetic
+ *
+ * R is 2^(len * RSA_LIMB_BITS). When the key length is not a multiple of
+ * the limb size the modulus is zero-extended, and rr is adjusted to match
+ * the larger R.
+ *
+ * @words:	Key length in 32-bit words
+ * @len:	Length of modulus[] and rr[] in limbs
+ * @n0inv:	-1 / modulus[0] mod 2^RSA_LIMB_BITS
+ * @modulus:	Modulus, as little endian limb array
+ * @rr:		R^2 mod modulus, as little endian limb array
+ */
+struct rsa_mont_key {
+	uint words;
+	uint len;
+	rsa_limb_t n0inv;
+	rsa_limb_t *modulus;
+	rsa_limb_t *rr;
+};
+
+#ifndef USE_HOSTCC
+static struct rsa_mont_key *rsa_key_cache[RSA_KEY_CACHE_SIZE];
+static int rsa_key_cache_next;
+#endif
+
 /**
  * subtract_modulus() - subtract modulus from the given value
  *
  * @key:	Key containing modulus to subtract
- * @num:	Number to subtract modulus from, as little endian word array
+ * @num:	Number to subtract modulus from, as little endian limb array
  */
-static void subtract_modulus(const struct rsa_public_key *key, uint32_t num[])
+static void subtract_modulus(const struct rsa_mont_key *key, rsa_limb_t num[])
 {
-	int64_t acc = 0;
+	rsa_limb_t borrow = 0, m;
 	uint i;
 
 	for (i = 0; i < key->len; i++) {
-		acc += (uint64_t)num[i] - key->modulus[i];
-		num[i] = (uint32_t)acc;
-		acc >>= 32;
+		m = key->modulus[i] + borrow;
+		/* a carry out of m only happens when borrowing from all-ones */
+		borrow = (m < borrow) | (num[i] < m);
+		num[i] -= m;
 	}
 }
 
@@ -50,11 +102,11 @@ static void subtract_modulus(const struct rsa_public_key *key, uint32_t num[])
  * greater_equal_modulus() - check if a value is >= modulus
  *
  * @key:	Key containing modulus to check
- * @num:	Number to check against modulus, as little endian word array
+ * @num:	Number to check against modulus, as little endian limb array
  * @return 0 if num < modulus, 1 if num >= modulus
  */
-static int greater_equal_modulus(const struct rsa_public_key *key,
-				 uint32_t num[])
+static int greater_equal_modulus(const struct rsa_mont_key *key,
+				 rsa_limb_t num[])
 {
 	int i;
 
@@ -74,32 +126,34 @@ static int greater_equal_modulus(const struct rsa_public_key *key,
  * Operation: montgomery result[] += a * b[] / n0inv % modulus
  *
  * @key:	RSA key
- * @result:	Place to put result, as little endian word array
+ * @result:	Place to put result, as little endian limb array
  * @a:		Multiplier
- * @b:		Multiplicand, as little endian word array
+ * @b:		Multiplicand, as little endian limb array
  */
-static void montgomery_mul_add_step(const struct rsa_public_key *key,
-		uint32_t result[], const uint32_t a, const uint32_t b[])
+static void montgomery_mul_add_step(const struct rsa_mont_key *key,
+		rsa_limb_t result[], const rsa_limb_t a, const rsa_limb_t b[])
 {
-	uint64_t acc_a, acc_b;
-	uint32_t d0;
+	rsa_dlimb_t acc_a, acc_b;
+	rsa_limb_t d0;
 	uint i;
 
-	acc_a = (uint64_t)a * b[0] + result[0];
-	d0 = (uint32_t)acc_a * key->n0inv;
-	acc_b = (uint64_t)d0 * key->modulus[0] + (uint32_t)acc_a;
+	acc_a = (rsa_dlimb_t)a * b[0] + result[0];
+	d0 = (rsa_limb_t)acc_a * key->n0inv;
+	acc_b = (rsa_dlimb_t)d0 * key->modulus[0] + (rsa_limb_t)acc_a;
 	for (i = 1; i < key->len; i++) {
-		acc_a = (acc_a >> 32) + (uint64_t)a * b[i] + result[i];
-		acc_b = (acc_b >> 32) + (uint64_t)d0 * key->modulus[i] +
-				(uint32_t)acc_a;
-		result[i - 1] = (uint32_t)acc_b;
+		acc_a = (acc_a >> RSA_LIMB_BITS) + (rsa_dlimb_t)a * b[i] +
+				result[i];
+		acc_b = (acc_b >> RSA_LIMB_BITS) +
+				(rsa_dlimb_t)d0 * key->modulus[i] +
+				(rsa_limb_t)acc_a;
+		result[i - 1] = (rsa_limb_t)acc_b;
 	}
 
-	acc_a = (acc_a >> 32) + (acc_b >> 32);
+	acc_a = (acc_a >> RSA_LIMB_BITS) + (acc_b >> RSA_LIMB_BITS);
 
-	result[i - 1] = (uint32_t)acc_a;
+	result[i - 1] = (rsa_limb_t)acc_a;
 
-	if (acc_a >> 32)
+	if (acc_a >> RSA_LIMB_BITS)
 		subtract_modulus(key, result);
 }
 
@@ -109,12 +163,12 @@ static void montgomery_mul_add_step(const struct rsa_public_key *key,
  * Operation: montgomery result[] = a[] * b[] / n0inv % modulus
  *
  * @key:	RSA key
- * @result:	Place to put result, as little endian word array
- * @a:		Multiplier, as little endian word array
- * @b:		Multiplicand, as little endian word array
+ * @result:	Place to put result, as little endian limb array
+ * @a:		Multiplier, as little endian limb array
+ * @b:		Multiplicand, as little endian limb array
  */
-static void montgomery_mul(const struct rsa_public_key *key,
-		uint32_t result[], uint32_t a[], const uint32_t b[])
+static void montgomery_mul(const struct rsa_mont_key *key,
+		rsa_limb_t result[], const rsa_limb_t a[], const rsa_limb_t b[])
 {
 	uint i;
 
@@ -127,17 +181,14 @@ static void montgomery_mul(const struct rsa_public_key *key,
 /**
  * num_pub_exponent_bits() - Number of bits in the public exponent
  *
- * @key:	RSA key
+ * @exponent:	Public exponent
  * @num_bits:	Storage for the number of public exponent bits
  */
-static int num_public_exponent_bits(const struct rsa_public_key *key,
-		int *num_bits)
+static int num_public_exponent_bits(uint64_t exponent, int *num_bits)
 {
-	uint64_t exponent;
 	int exponent_bits;
 	const uint max_bits = (sizeof(exponent) * 8);
 
-	exponent = key->exponent;
 	exponent_bits = 0;
 
 	if (!exponent) {
@@ -154,46 +205,210 @@ static int num_public_exponent_bits(const struct rsa_public_key *key,
 	return -EINVAL;
 }
 
+/**
+ * num_public_exponent_set_bits() - Number of set bits in the public exponent
+ *
+ * @exponent:	Public exponent
+ */
+static int num_public_exponent_set_bits(uint64_t exponent)
+{
+	int count;
+
+	for (count = 0; exponent; count++)
+		exponent &= exponent - 1;
+
+	return count;
+}
+
 /**
  * is_public_exponent_bit_set() - Check if a bit in the public exponent is set
  *
- * @key:	RSA key
+ * @exponent:	Public exponent
  * @pos:	The bit position to check
  */
-static int is_public_exponent_bit_set(const struct rsa_public_key *key,
-		int pos)
+static bool is_public_exponent_bit_set(uint64_t exponent, int pos)
+{
+	return (exponent >> pos) & 1;
+}
+
+/**
+ * rsa_words_to_limbs() - convert a big-endian word array to limbs
+ *
+ * @dst:	Little endian limb array of @len limbs, zero-extended if needed
+ * @len:	Number of limbs
+ * @src:	Big-endian 32-bit word array
+ * @words:	Number of words in @src
+ */
+static void rsa_words_to_limbs(rsa_limb_t *dst, uint len,
+			       const uint32_t *src, uint words)
 {
-	return key->exponent & (1ULL << pos);
+	uint i, j, w;
+
+	for (i = 0; i < len; i++) {
+		dst[i] = 0;
+		for (j = 0; j < RSA_LIMB_WORDS; j++) {
+			w = i * RSA_LIMB_WORDS + j;
+			if (w < words)
+				dst[i] |= (rsa_limb_t)get_unaligned_be32(
+					&src[words - 1 - w]) << (32 * j);
+		}
+	}
+}
+
+/**
+ * rsa_limbs_to_words() - convert limbs to a big-endian word array
+ *
+ * @dst:	Big-endian 32-bit word array
+ * @words:	Number of words in @dst
+ * @src:	Little endian limb array, long enough to hold @words words
+ */
+static void rsa_limbs_to_words(uint32_t *dst, uint words,
+			       const rsa_limb_t *src)
+{
+	uint w;
+
+	for (w = 0; w < words; w++)
+		put_unaligned_be32((uint32_t)(src[w / RSA_LIMB_WORDS] >>
+					      (32 * (w % RSA_LIMB_WORDS))),
+				   &dst[words - 1 - w]);
+}
+
+/**
+ * pow_mod_binary() - left-to-right binary exponentiation
+ *
+ * This suits exponents with few bits set, such as the usual 65537.
+ *
+ * @key:	RSA key
+ * @exponent:	Public exponent, with its top bit at @k - 1
+ * @k:		Number of bits in @exponent
+ * @val:	Value to exponentiate, below the modulus
+ * @result:	Place to put the result, at most one modulus too large
+ */
+static void pow_mod_binary(const struct rsa_mont_key *key, uint64_t exponent,
+			   int k, const rsa_limb_t val[], rsa_limb_t result[])
+{
+	rsa_limb_t acc_buf[key->len], tmp_buf[key->len], a_scaled[key->len];
+	rsa_limb_t *acc = acc_buf, *tmp = tmp_buf, *swap;
+	int j;
+
+	/* the bit at e[k-1] is 1 by definition, so start with: C := M */
+	montgomery_mul(key, acc, val, key->rr); /* acc = a * RR / R mod n */
+	/* retain scaled version for intermediate use */
+	memcpy(a_scaled, acc, key->len * sizeof(a_scaled[0]));
+
+	for (j = k - 2; j > 0; --j) {
+		montgomery_mul(key, tmp, acc, acc); /* tmp = acc^2 / R mod n */
+
+		if (is_public_exponent_bit_set(exponent, j)) {
+			/* acc = tmp * val / R mod n */
+			montgomery_mul(key, acc, tmp, a_scaled);
+		} else {
+			/* e[j] == 0, carry on from tmp */
+			swap = acc;
+			acc = tmp;
+			tmp = swap;
+		}
+	}
+
+	/* the bit at e[0] is always 1 */
+	montgomery_mul(key, tmp, acc, acc); /* tmp = acc^2 / R mod n */
+	montgomery_mul(key, result, tmp, val); /* result = tmp * a / R mod n */
+}
+
+/**
+ * pow_mod_window() - left-to-right sliding-window exponentiation
+ *
+ * The odd powers a^1, a^3, ... a^(2^RSA_WINDOW_BITS - 1) are computed up
+ * front, so that each run of up to RSA_WINDOW_BITS exponent bits that starts
+ * and ends with a one costs a single multiplication. This roughly halves the
+ * multiplications needed for large exponents with many bits set.
+ *
+ * @key:	RSA key
+ * @exponent:	Public exponent, with its top bit at @k - 1
+ * @k:		Number of bits in @exponent
+ * @val:	Value to exponentiate, below the modulus
+ * @result:	Place to put the result, at most one modulus too large
+ */
+static void pow_mod_window(const struct rsa_mont_key *key, uint64_t exponent,
+			   int k, const rsa_limb_t val[], rsa_limb_t result[])
+{
+	rsa_limb_t table[RSA_WINDOW_ENTRIES][key->len];
+	rsa_limb_t acc_buf[key->len], tmp_buf[key->len];
+	rsa_limb_t *acc = acc_buf, *tmp = tmp_buf, *swap;
+	int i, j, len;
+	uint win;
+
+	/* table[i] = a^(2i + 1) * R mod n, using tmp = a^2 * R mod n */
+	montgomery_mul(key, table[0], val, key->rr);
+	montgomery_mul(key, tmp, table[0], table[0]);
+	for (i = 1; i < RSA_WINDOW_ENTRIES; i++)
+		montgomery_mul(key, table[i], table[i - 1], tmp);
+
+	for (j = k - 1; j >= 0; j -= len) {
+		if (!is_public_exponent_bit_set(exponent, j)) {
+			montgomery_mul(key, tmp, acc, acc);
+			swap = acc;
+			acc = tmp;
+			tmp = swap;
+			len = 1;
+			continue;
+		}
+
+		/* the longest window of up to RSA_WINDOW_BITS ending in a 1 */
+		len = j + 1 < RSA_WINDOW_BITS ? j + 1 : RSA_WINDOW_BITS;
+		while (!is_public_exponent_bit_set(exponent, j - len + 1))
+			len--;
+		win = (exponent >> (j - len + 1)) & ((1 << len) - 1);
+
+		/* the top bit of the exponent starts the first window */
+		if (j == k - 1) {
+			memcpy(acc, table[win >> 1], key->len * sizeof(acc[0]));
+			continue;
+		}
+
+		for (i = 0; i < len; i++) {
+			montgomery_mul(key, tmp, acc, acc);
+			swap = acc;
+			acc = tmp;
+			tmp = swap;
+		}
+		montgomery_mul(key, tmp, acc, table[win >> 1]);
+		swap = acc;
+		acc = tmp;
+		tmp = swap;
+	}
+
+	/* leave the Montgomery domain: result = acc * 1 / R mod n */
+	memset(tmp, '\0', key->len * sizeof(tmp[0]));
+	tmp[0] = 1;
+	montgomery_mul(key, result, acc, tmp);
 }
 
 /**
  * pow_mod() - in-place public exponentiation
  *
  * @key:	RSA key
+ * @exponent:	Public exponent
  * @inout:	Big-endian word array containing value and result
  */
-static int pow_mod(const struct rsa_public_key *key, uint32_t *inout)
+static int pow_mod(const struct rsa_mont_key *key, uint64_t exponent,
+		   uint32_t *inout)
 {
-	uint32_t *result, *ptr;
-	uint i;
-	int j, k;
+	int k;
 
-	/* Sanity check for stack size - key->len is in 32-bit words */
-	if (key->len > RSA_MAX_KEY_BITS / 32) {
-		debug("RSA key words %u exceeds maximum %d\n", key->len,
+	/* Sanity check for stack size - key->words is in 32-bit words */
+	if (key->words > RSA_MAX_KEY_BITS / 32) {
+		debug("RSA key words %u exceeds maximum %d\n", key->words,
 		      RSA_MAX_KEY_BITS / 32);
 		return -EINVAL;
 	}
 
-	uint32_t val[key->len], acc[key->len], tmp[key->len];
-	uint32_t a_scaled[key->len];
-	result = tmp;  /* Re-use location. */
+	rsa_limb_t val[key->len], result[key->len];
 
-	/* Convert from big endian byte array to little endian word array. */
-	for (i = 0, ptr = inout + key->len - 1; i < key->len; i++, ptr--)
-		val[i] = get_unaligned_be32(ptr);
+	/* Convert from big endian byte array to little endian limb array. */
+	rsa_words_to_limbs(val, key->len, inout, key->words);
 
-	if (0 != num_public_exponent_bits(key, &k))
+	if (0 != num_public_exponent_bits(exponent, &k))
 		return -EINVAL;
 
 	if (k < 2) {
@@ -202,43 +417,142 @@ static int pow_mod(const struct rsa_public_key *key, uint32_t *inout)
 		return -EINVAL;
 	}
 
-	if (!is_public_exponent_bit_set(key, 0)) {
+	if (!is_public_exponent_bit_set(exponent, 0)) {
 		debug("LSB of RSA public exponent must be set.\n");
 		return -EINVAL;
 	}
 
-	/* the bit at e[k-1] is 1 by definition, so start with: C := M */
-	montgomery_mul(key, acc, val, key->rr); /* acc = a * RR / R mod n */
-	/* retain scaled version for intermediate use */
-	memcpy(a_scaled, acc, key->len * sizeof(a_scaled[0]));
-
-	for (j = k - 2; j > 0; --j) {
-		montgomery_mul(key, tmp, acc, acc); /* tmp = acc^2 / R mod n */
-
-		if (is_public_exponent_bit_set(key, j)) {
-			/* acc = tmp * val / R mod n */
-			montgomery_mul(key, acc, tmp, a_scaled);
-		} else {
-			/* e[j] == 0, copy tmp back to acc for next operation */
-			memcpy(acc, tmp, key->len * sizeof(acc[0]));
-		}
-	}
-
-	/* the bit at e[0] is always 1 */
-	montgomery_mul(key, tmp, acc, acc); /* tmp = acc^2 / R mod n */
-	montgomery_mul(key, acc, tmp, val); /* acc = tmp * a / R mod M */
-	memcpy(result, acc, key->len * sizeof(result[0]));
+	if (num_public_exponent_set_bits(exponent) > RSA_WINDOW_ENTRIES)
+		pow_mod_window(key, exponent, k, val, result);
+	else
+		pow_mod_binary(key, exponent, k, val, result);
 
 	/* Make sure result < mod; result is at most 1x mod too large. */
 	if (greater_equal_modulus(key, result))
 		subtract_modulus(key, result);
 
 	/* Convert to bigendian byte array */
-	for (i = key->len - 1, ptr = inout; (int)i >= 0; i--, ptr++)
-		put_unaligned_be32(result[i], ptr);
+	rsa_limbs_to_words(inout, key->words, result);
+	return 0;
+}
+
+/**
+ * rsa_key_init() - prepare the Montgomery parameters of a key
+ *
+ * @key:	Key to set up, with words, len and modulus[] already filled in
+ * @prop:	Key properties holding R^2 for R = 2^(32 * words)
+ * @rr:		Storage for key->len limbs of R^2
+ * @return 0 if OK, -EINVAL if the modulus is not usable
+ */
+static int rsa_key_init(struct rsa_mont_key *key, const struct key_prop *prop,
+			rsa_limb_t *rr)
+{
+	rsa_limb_t n0 = key->modulus[0], inv, top;
+	uint i, j, shift;
+
+	if (!(n0 & 1)) {
+		debug("RSA modulus must be odd\n");
+		return -EINVAL;
+	}
+
+	/*
+	 * Newton's iteration doubles the number of correct low bits of the
+	 * inverse each time; n0 is its own inverse modulo 8.
+	 */
+	for (inv = n0, i = 0; i < 5; i++)
+		inv *= 2 - n0 * inv;
+	key->n0inv = -inv;
+
+	key->rr = rr;
+	rsa_words_to_limbs(key->rr, key->len, prop->rr, key->words);
+
+	/*
+	 * When the modulus was zero-extended to whole limbs R grew by 2^shift,
+	 * so R^2 needs doubling 2 * shift times.
+	 */
+	shift = key->len * RSA_LIMB_BITS - key->words * 32;
+	for (i = 0; i < 2 * shift; i++) {
+		top = key->rr[key->len - 1] >> (RSA_LIMB_BITS - 1);
+		for (j = key->len - 1; j > 0; j--)
+			key->rr[j] = key->rr[j] << 1 |
+				     key->rr[j - 1] >> (RSA_LIMB_BITS - 1);
+		key->rr[0] <<= 1;
+		if (top || greater_equal_modulus(key, key->rr))
+			subtract_modulus(key, key->rr);
+	}
+
 	return 0;
 }
 
+#ifndef USE_HOSTCC
+/**
+ * rsa_key_cache_lookup() - find the prepared parameters of a key
+ *
+ * Verified boot usually checks several signatures made with the same key
+ * (the configuration, its images, EFI variables...) so the prepared key is
+ * kept around once U-Boot has relocated and .bss is usable.
+ *
+ * @key:	Key with words, len and modulus[] filled in
+ * @return cached key with the same modulus, or NULL if none
+ */
+static struct rsa_mont_key *rsa_key_cache_lookup(const struct rsa_mont_key *key)
+{
+	int i;
+
+	if (!(gd->flags & GD_FLG_RELOC))
+		return NULL;
+
+	for (i = 0; i < RSA_KEY_CACHE_SIZE; i++) {
+		if (rsa_key_cache[i] && rsa_key_cache[i]->words == key->words &&
+		    !memcmp(rsa_key_cache[i]->modulus, key->modulus,
+			    key->len * sizeof(rsa_limb_t)))
+			return rsa_key_cache[i];
+	}
+
+	return NULL;
+}
+
+/**
+ * rsa_key_cache_add() - remember the prepared parameters of a key
+ *
+ * Entries are replaced round-robin once the cache is full. Failing to
+ * allocate an entry is not an error, the key is just not cached.
+ *
+ * @key:	Prepared key to copy into the cache
+ */
+static void rsa_key_cache_add(const struct rsa_mont_key *key)
+{
+	struct rsa_mont_key *entry;
+	size_t size = key->len * sizeof(rsa_limb_t);
+
+	if (!(gd->flags & GD_FLG_RELOC))
+		return;
+
+	entry = malloc(sizeof(*entry) + 2 * size);
+	if (!entry)
+		return;
+
+	*entry = *key;
+	entry->modulus = (rsa_limb_t *)(entry + 1);
+	entry->rr = entry->modulus + key->len;
+	memcpy(entry->modulus, key->modulus, size);
+	memcpy(entry->rr, key->rr, size);
+
+	free(rsa_key_cache[rsa_key_cache_next]);
+	rsa_key_cache[rsa_key_cache_next] = entry;
+	rsa_key_cache_next = (rsa_key_cache_next + 1) % RSA_KEY_CACHE_SIZE;
+}
+#else
+static struct rsa_mont_key *rsa_key_cache_lookup(const struct rsa_mont_key *key)
+{
+	return NULL;
+}
+
+static void rsa_key_cache_add(const struct rsa_mont_key *key)
+{
+}
+#endif
+
 static void rsa_convert_big_endian(uint32_t *dst, const uint32_t *src, int len)
 {
 	int i;
@@ -250,50 +564,61 @@ static void rsa_convert_big_endian(uint32_t *dst, const uint32_t *src, int len)
 int rsa_mod_exp_sw(const uint8_t *sig, uint32_t sig_len,
 		struct key_prop *prop, uint8_t *out)
 {
-	struct rsa_public_key key;
+	struct rsa_mont_key key, *cached;
+	uint64_t exponent;
 	int ret;
 
 	if (!prop) {
 		debug("%s: Skipping invalid prop", __func__);
 		return -EBADF;
 	}
-	key.n0inv = prop->n0inv;
-	key.len = prop->num_bits;
+	key.words = prop->num_bits;
 
 	if (!prop->public_exponent)
-		key.exponent = RSA_DEFAULT_PUBEXP;
+		exponent = RSA_DEFAULT_PUBEXP;
 	else
-		rsa_convert_big_endian((uint32_t *)&key.exponent,
+		rsa_convert_big_endian((uint32_t *)&exponent,
 				       prop->public_exponent, 2);
 
-	if (!key.len || !prop->modulus || !prop->rr) {
+	if (!key.words || !prop->modulus || !prop->rr) {
 		debug("%s: Missing RSA key info", __func__);
 		return -EFAULT;
 	}
 
 	/* Sanity check for stack size */
-	if (key.len > RSA_MAX_KEY_BITS || key.len < RSA_MIN_KEY_BITS) {
+	if (key.words > RSA_MAX_KEY_BITS || key.words < RSA_MIN_KEY_BITS) {
 		debug("RSA key bits %u outside allowed range %d..%d\n",
-		      key.len, RSA_MIN_KEY_BITS, RSA_MAX_KEY_BITS);
+		      key.words, RSA_MIN_KEY_BITS, RSA_MAX_KEY_BITS);
 		return -EFAULT;
 	}
-	key.len /= sizeof(uint32_t) * 8;
-	uint32_t key1[key.len], key2[key.len];
-
-	key.modulus = key1;
-	key.rr = key2;
-	rsa_convert_big_endian(key.modulus, (uint32_t *)prop->modulus, key.len);
-	rsa_convert_big_endian(key.rr, (uint32_t *)prop->rr, key.len);
-	if (!key.modulus || !key.rr) {
-		debug("%s: Out of memory", __func__);
-		return -ENOMEM;
+	key.words /= sizeof(uint32_t) * 8;
+	key.len = (key.words + RSA_LIMB_WORDS - 1) / RSA_LIMB_WORDS;
+
+	if (sig_len != key.words * sizeof(uint32_t)) {
+		debug("Signature length %u does not match the key\n", sig_len);
+		return -EINVAL;
+	}
+
+	rsa_limb_t modulus[key.len], rr[key.len];
+
+	key.modulus = modulus;
+	rsa_words_to_limbs(key.modulus, key.len, prop->modulus, key.words);
+
+	cached = rsa_key_cache_lookup(&key);
+	if (cached) {
+		key = *cached;
+	} else {
+		ret = rsa_key_init(&key, prop, rr);
+		if (ret)
+			return ret;
+		rsa_key_cache_add(&key);
 	}
 
-	uint32_t buf[sig_len / sizeof(uint32_t)];
+	uint32_t buf[key.words];
 
 	memcpy(buf, sig, sig_len);
 
-	ret = pow_mod(&key, buf);
+	ret = pow_mod(&key, exponent, buf);
 	if (ret)
 		return ret;
 
@@ -318,35 +643,45 @@ int zynq_pow_mod(u32 *keyptr, u32 *inout)
 {
 	u32 *result, *ptr;
 	uint i;
-	struct rsa_public_key *key;
+	struct rsa_public_key *pkey;
+	struct rsa_mont_key key;
 	u32 val[RSA2048_BYTES], acc[RSA2048_BYTES], tmp[RSA2048_BYTES];
 
-	key = (struct rsa_public_key *)keyptr;
+	/* Zynq-7000 is 32-bit only, so the limbs match the key's words */
+	BUILD_BUG_ON(sizeof(rsa_limb_t) != sizeof(u32));
+
+	pkey = (struct rsa_public_key *)keyptr;
 
 	/* Sanity check for stack size - key->len is in 32-bit words */
-	if (key->len > RSA_MAX_KEY_BITS / 32) {
-		debug("RSA key words %u exceeds maximum %d\n", key->len,
+	if (pkey->len > RSA_MAX_KEY_BITS / 32) {
+		debug("RSA key words %u exceeds maximum %d\n", pkey->len,
 		      RSA_MAX_KEY_BITS / 32);
 		return -EINVAL;
 	}
 
+	key.words = pkey->len;
+	key.len = pkey->len;
+	key.n0inv = pkey->n0inv;
+	key.modulus = pkey->modulus;
+	key.rr = pkey->rr;
+
 	result = tmp;  /* Re-use location. */
 
-	for (i = 0, ptr = inout; i < key->len; i++, ptr++)
+	for (i = 0, ptr = inout; i < key.len; i++, ptr++)
 		val[i] = *(ptr);
 
-	montgomery_mul(key, acc, val, key->rr);  /* axx = a * RR / R mod M */
+	montgomery_mul(&key, acc, val, key.rr);  /* axx = a * RR / R mod M */
 	for (i = 0; i < 16; i += 2) {
-		montgomery_mul(key, tmp, acc, acc); /* tmp = acc^2 / R mod M */
-		montgomery_mul(key, acc, tmp, tmp); /* acc = tmp^2 / R mod M */
+		montgomery_mul(&key, tmp, acc, acc); /* tmp = acc^2 / R mod M */
+		montgomery_mul(&key, acc, tmp, tmp); /* acc = tmp^2 / R mod M */
 	}
-	montgomery_mul(key, result, acc, val);  /* result = XX * a / R mod M */
+	montgomery_mul(&key, result, acc, val);  /* result = XX * a / R mod M */
 
 	/* Make sure result < mod; result is at most 1x mod too large. */
-	if (greater_equal_modulus(key, result))
-		subtract_modulus(key, result);
+	if (greater_equal_modulus(&key, result))
+		subtract_modulus(&key, result);
 
-	for (i = 0, ptr = inout; i < key->len; i++, ptr++)
+	for (i = 0, ptr = inout; i < key.len; i++, ptr++)
 		*ptr = result[i];
 
 	return 0;
@@ -24,6 +24,9 @@
 #endif /* USE_HOSTCC */
 #include <watchdog.h>
 #include <u-boot/sha1.h>
+#if !defined(USE_HOSTCC) && defined(CONFIG_SHA_ARMV8_CE)
+#include <asm/armv8/sha_ce.h>
+#endif
 
 const uint8_t sha1_der_prefix[SHA1_DER_LEN] = {
 	0x30, 0x21, 0x30, 0x09, 0x06, 0x05, 0x2b, 0x0e,
@@ -65,7 +68,7 @@ void sha1_starts (sha1_context * ctx)
 	ctx->state[4] = 0xC3D2E1F0;
 }
 
-static void sha1_process(sha1_context *ctx, const unsigned char data[64])
+static void sha1_process_one(sha1_context *ctx, const unsigned char data[64])
 {
 	unsigned long temp, W[16], A, B, C, D, E;
 
@@ -219,6 +222,33 @@ static void sha1_process(sha1_context *ctx, const unsigned char data[64])
 	ctx->state[4] += E;
 }
 
+#if !defined(USE_HOSTCC) && defined(CONFIG_SHA_ARMV8_CE)
+bool sha1_ce_disabled;
+#endif
+
+static void sha1_process(sha1_context *ctx, const unsigned char *data,
+			 unsigned int blocks)
+{
+#if !defined(USE_HOSTCC) && defined(CONFIG_SHA_ARMV8_CE)
+	if (sha1_ce_available()) {
+		uint32_t state[5];
+		int i;
+
+		/* the context holds the state in unsigned longs */
+		for (i = 0; i < 5; i++)
+			state[i] = ctx->state[i];
+		sha1_ce_transform(state, data, blocks);
+		for (i = 0; i < 5; i++)
+			ctx->state[i] = state[i];
+		return;
+	}
+#endif
+	while (blocks--) {
+		sha1_process_one(ctx, data);
+		data += 64;
+	}
+}
+
 /*
  * SHA-1 process buffer
  */
@@ -242,16 +272,16 @@ void sha1_update(sha1_context *ctx, const unsigned char *input,
 
 	if (left && ilen >= fill) {
 		memcpy ((void *) (ctx->buffer + left), (void *) input, fill);
-		sha1_process (ctx, ctx->buffer);
+		sha1_process(ctx, ctx->buffer, 1);
 		input += fill;
 		ilen -= fill;
 		left = 0;
 	}
 
-	while (ilen >= 64) {
-		sha1_process (ctx, input);
-		input += 64;
-		ilen -= 64;
+	if (ilen >= 64) {
+		sha1_process(ctx, input, ilen / 64);
+		input += ilen & ~0x3F;
+		ilen &= 0x3F;
 	}
 
 	if (ilen > 0) {
@@ -16,11 +16,22 @@
  */
 
 #include <config.h>
+#include <linux/compiler.h>
 #include <linux/types.h>
 #include <linux/string.h>
 #include <linux/ctype.h>
 #include <malloc.h>
 
+/*
+ * memset(), memcpy() and memmove() are built as generic_memset() and so on,
+ * with the standard names as aliases when the architecture does not provide
+ * its own. The membench command compares the two, so it needs the C
+ * versions even when they are not used otherwise.
+ */
+#if defined(CONFIG_CMD_MEMBENCH) && !defined(CONFIG_SPL_BUILD)
+#define STRING_GENERIC_MEM
+#endif
+
 
 /**
  * strncasecmp - Case insensitive, length-limited string comparison
@@ -481,7 +492,7 @@ char *strswab(const char *s)
 }
 #endif
 
-#ifndef __HAVE_ARCH_MEMSET
+#if !defined(__HAVE_ARCH_MEMSET) || defined(STRING_GENERIC_MEM)
 /**
  * memset - Fill a region of memory with the given value
  * @s: Pointer to the start of the area.
@@ -490,7 +501,7 @@ char *strswab(const char *s)
  *
  * Do not use memset() to access IO space, use memset_io() instead.
  */
-void * memset(void * s,int c,size_t count)
+void *generic_memset(void *s, int c, size_t count)
 {
 	unsigned long *sl = (unsigned long *) s;
 	char *s8;
@@ -519,7 +530,11 @@ void * memset(void * s,int c,size_t count)
 }
 #endif
 
-#ifndef __HAVE_ARCH_MEMCPY
+#ifndef __HAVE_ARCH_MEMSET
+void *memset(void *s, int c, size_t count) __alias(generic_memset);
+#endif
+
+#if !defined(__HAVE_ARCH_MEMCPY) || defined(STRING_GENERIC_MEM)
 /**
  * memcpy - Copy one area of memory to another
  * @dest: Where to copy to
@@ -529,7 +544,7 @@ void * memset(void * s,int c,size_t count)
  * You should not use this function to access IO space, use memcpy_toio()
  * or memcpy_fromio() instead.
  */
-void * memcpy(void *dest, const void *src, size_t count)
+void *generic_memcpy(void *dest, const void *src, size_t count)
 {
 	unsigned long *dl = (unsigned long *)dest, *sl = (unsigned long *)src;
 	char *d8, *s8;
@@ -554,7 +569,12 @@ void * memcpy(void *dest, const void *src, size_t count)
 }
 #endif
 
-#ifndef __HAVE_ARCH_MEMMOVE
+#ifndef __HAVE_ARCH_MEMCPY
+void *memcpy(void *dest, const void *src, size_t count)
+	__alias(generic_memcpy);
+#endif
+
+#if !defined(__HAVE_ARCH_MEMMOVE) || defined(STRING_GENERIC_MEM)
 /**
  * memmove - Copy one area of memory to another
  * @dest: Where to copy to
@@ -563,7 +583,7 @@ void * memcpy(void *dest, const void *src, size_t count)
  *
  * Unlike memcpy(), memmove() copes with overlapping areas.
  */
-void * memmove(void * dest,const void *src,size_t count)
+void *generic_memmove(void *dest, const void *src, size_t count)
 {
 	char *tmp, *s;
 
@@ -580,6 +600,11 @@ void * memmove(void * dest,const void *src,size_t count)
 }
 #endif
 
+#ifndef __HAVE_ARCH_MEMMOVE
+void *memmove(void *dest, const void *src, size_t count)
+	__alias(generic_memmove);
+#endif
+
 #ifndef __HAVE_ARCH_MEMCMP
 /**
  * memcmp - Compare two areas of memory
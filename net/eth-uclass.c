@@ -23,9 +23,12 @@ DECLARE_GLOBAL_DATA_PTR;
  * struct eth_device_priv - private structure for each Ethernet device
  *
  * @state: The state of the Ethernet MAC driver (defined by enum eth_state_t)
+ * @starts: Number of times the device was started, so that received packets
+ *	    are not given back after the driver has reset its buffers
  */
 struct eth_device_priv {
 	enum eth_state_t state;
+	uint starts;
 };
 
 /**
@@ -37,6 +40,9 @@ struct eth_uclass_priv {
 	struct udevice *current;
 };
 
+/* Most packets processed in one call of eth_rx() */
+#define ETH_RX_BATCH	32
+
 /* eth_errno - This stores the most recent failure code from DM functions */
 static int eth_errno;
 
@@ -153,6 +159,20 @@ unsigned char *eth_get_ethaddr(void)
 	return NULL;
 }
 
+int eth_get_mtu(void)
+{
+	struct eth_pdata *pdata;
+	int mtu = ETH_DATA_LEN;
+
+	if (eth_get_dev()) {
+		pdata = eth_get_dev()->platdata;
+		if (pdata->max_mtu)
+			mtu = pdata->max_mtu;
+	}
+
+	return min(mtu, NET_MTU);
+}
+
 /* Set active state without calling start on the driver */
 int eth_init_state_only(void)
 {
@@ -290,6 +310,7 @@ int eth_init(void)
 						current->uclass_priv;
 
 					priv->state = ETH_STATE_ACTIVE;
+					priv->starts++;
 					return 0;
 				}
 			} else {
@@ -363,6 +384,86 @@ int eth_send(void *packet, int length)
 	return ret;
 }
 
+int eth_send_batch(void **packets, int *lengths, int count)
+{
+	struct udevice *current;
+	struct eth_ops *ops;
+	int ret = 0;
+	int sent, i;
+
+	current = eth_get_dev();
+	if (!current)
+		return -ENODEV;
+
+	if (!eth_is_active(current))
+		return -EINVAL;
+
+	ops = eth_get_ops(current);
+	for (sent = 0; sent < count; sent += ret) {
+		if (ops->send_batch) {
+			ret = ops->send_batch(current, packets + sent,
+					      lengths + sent, count - sent);
+		} else {
+			ret = ops->send(current, packets[sent], lengths[sent]);
+			if (!ret)
+				ret = 1;
+		}
+		if (ret <= 0)
+			break;
+		if (IS_ENABLED(CONFIG_CMD_PCAP)) {
+			for (i = sent; i < sent + ret; i++)
+				pcap_post(packets[i], lengths[i], true);
+		}
+	}
+	if (ret < 0)
+		debug("%s: send returned error %d\n", __func__, ret);
+
+	return sent ? sent : ret;
+}
+
+/*
+ * Process all the packets of a batch before giving them back, so that the
+ * driver can refill its ring in one go
+ */
+static int eth_rx_batch(struct udevice *current)
+{
+	struct eth_device_priv *priv = dev_get_uclass_priv(current);
+	struct eth_pdata *pdata = dev_get_platdata(current);
+	struct eth_ops *ops = eth_get_ops(current);
+	struct eth_rx_pkt pkts[ETH_RX_BATCH];
+	uint starts = priv->starts;
+	uint csum_mask;
+	int ret;
+	int i;
+
+	for (i = 0; i < ETH_RX_BATCH; i++)
+		pkts[i].csum = 0;
+	ret = ops->recv_batch(current, ETH_RECV_CHECK_DEVICE, pkts,
+			      ETH_RX_BATCH);
+	if (ret <= 0)
+		return ret;
+
+	/* Only trust the checks the driver says the hardware does */
+	csum_mask = pdata->rx_csum | ETH_CSUM_BAD;
+	for (i = 0; i < ret; i++) {
+		if (pkts[i].length > 0)
+			net_process_received_csum(pkts[i].packet,
+						  pkts[i].length,
+						  pkts[i].csum & csum_mask);
+	}
+
+	/* A handler restarted the device, which took its buffers back */
+	if (priv->starts != starts || !eth_is_active(current))
+		return ret;
+
+	if (ops->free_pkt) {
+		for (i = 0; i < ret; i++)
+			ops->free_pkt(current, pkts[i].packet, pkts[i].length);
+	}
+
+	return ret;
+}
+
 int eth_rx(void)
 {
 	struct udevice *current;
@@ -378,9 +479,14 @@ int eth_rx(void)
 	if (!eth_is_active(current))
 		return -EINVAL;
 
+	if (eth_get_ops(current)->recv_batch) {
+		ret = eth_rx_batch(current);
+		goto out;
+	}
+
 	/* Process up to 32 packets at one time */
 	flags = ETH_RECV_CHECK_DEVICE;
-	for (i = 0; i < 32; i++) {
+	for (i = 0; i < ETH_RX_BATCH; i++) {
 		ret = eth_get_ops(current)->recv(current, flags, &packet);
 		flags = 0;
 		if (ret > 0)
@@ -390,6 +496,7 @@ int eth_rx(void)
 		if (ret <= 0)
 			break;
 	}
+out:
 	if (ret == -EAGAIN)
 		ret = 0;
 	if (ret < 0) {
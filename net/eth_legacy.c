@@ -102,6 +102,11 @@ int eth_get_dev_index(void)
 	return eth_current->index;
 }
 
+int eth_get_mtu(void)
+{
+	return min(ETH_DATA_LEN, NET_MTU);
+}
+
 static int on_ethaddr(const char *name, const char *value, enum env_op op,
 	int flags)
 {
@@ -84,6 +84,15 @@
  *	Prerequisites:	- own ethernet address
  *	We want:	- magic packet or timeout
  *	Next step:	none
+ *
+ * WGET:
+ *
+ *	Prerequisites:	- own ethernet address
+ *			- own IP address
+ *			- HTTP server IP address
+ *			- path of the file
+ *	We want:	- load the file over a TCP connection
+ *	Next step:	none
  */
 
 
@@ -102,6 +111,12 @@
 #if defined(CONFIG_CMD_PCAP)
 #include <net/pcap.h>
 #endif
+#if defined(CONFIG_PROT_TCP)
+#include <net/tcp.h>
+#endif
+#if defined(CONFIG_CMD_WGET)
+#include <net/wget.h>
+#endif
 #if defined(CONFIG_LED_STATUS)
 #include <miiphy.h>
 #include <status_led.h>
@@ -152,6 +167,8 @@ struct in_addr	net_server_ip;
 uchar *net_rx_packet;
 /* Current rx packet length */
 int		net_rx_packet_len;
+/* Checksum errors since net_loop() started */
+struct net_csum_stats net_csum_stats;
 /* IP packet ID */
 static unsigned	net_ip_id;
 /* Ethernet bcast address */
@@ -440,6 +457,10 @@ restart:
 	 */
 	debug_cond(DEBUG_INT_STATE, "--- net_loop Init\n");
 	net_init_loop();
+	memset(&net_csum_stats, 0, sizeof(net_csum_stats));
+#ifdef CONFIG_PROT_TCP
+	tcp_init();
+#endif
 
 	switch (net_check_prereq(protocol)) {
 	case 1:
@@ -504,6 +525,11 @@ restart:
 			nfs_start();
 			break;
 #endif
+#if defined(CONFIG_CMD_WGET)
+		case WGET:
+			wget_start();
+			break;
+#endif
 #if defined(CONFIG_CMD_CDP)
 		case CDP:
 			cdp_start();
@@ -676,6 +702,12 @@ done:
 #endif
 	net_set_state(prev_net_state);
 
+	if (net_csum_stats.hw || net_csum_stats.ip || net_csum_stats.udp ||
+	    net_csum_stats.tcp)
+		printf("Checksum errors: %lu flagged by hardware, %lu IP, %lu UDP, %lu TCP\n",
+		       net_csum_stats.hw, net_csum_stats.ip,
+		       net_csum_stats.udp, net_csum_stats.tcp);
+
 #if defined(CONFIG_CMD_PCAP)
 	if (pcap_active())
 		pcap_print_status();
@@ -851,6 +883,14 @@ int net_send_ip_packet(uchar *ether, struct in_addr dest, int dport, int sport,
 				   payload_len);
 		pkt_hdr_size = eth_hdr_size + IP_UDP_HDR_SIZE;
 		break;
+#ifdef CONFIG_PROT_TCP
+	case IPPROTO_TCP:
+		pkt_hdr_size = eth_hdr_size +
+			tcp_set_tcp_header(pkt + eth_hdr_size, dest, dport,
+					   sport, payload_len, action,
+					   tcp_seq_num, tcp_ack_num);
+		break;
+#endif
 	default:
 		return -EINVAL;
 	}
@@ -872,8 +912,8 @@ int net_send_ip_packet(uchar *ether, struct in_addr dest, int dport, int sport,
 		arp_request();
 		return 1;	/* waiting */
 	} else {
-		debug_cond(DEBUG_DEV_PKT, "sending UDP to %pI4/%pM\n",
-			   &dest, ether);
+		debug_cond(DEBUG_DEV_PKT, "sending IP proto %d to %pI4/%pM\n",
+			   proto, &dest, ether);
 		net_send_packet(net_tx_packet, pkt_hdr_size + payload_len);
 		return 0;	/* transmitted */
 	}
@@ -1075,7 +1115,36 @@ static void receive_icmp(struct ip_udp_hdr *ip, int len,
 	}
 }
 
+#ifdef CONFIG_UDP_CHECKSUM
+static int udp_checksum_ok(struct ip_udp_hdr *ip)
+{
+	struct {
+		struct in_addr src;
+		struct in_addr dest;
+		u8 zero;
+		u8 proto;
+		u16 len;
+	} __attribute__((packed)) ph;
+	unsigned int len = ntohs(ip->udp_len);
+
+	net_copy_ip(&ph.src, &ip->ip_src);
+	net_copy_ip(&ph.dest, &ip->ip_dst);
+	ph.zero = 0;
+	ph.proto = IPPROTO_UDP;
+	ph.len = ip->udp_len;
+
+	return add_ip_checksums(sizeof(ph),
+				compute_ip_checksum(&ph, sizeof(ph)),
+				compute_ip_checksum(&ip->udp_src, len)) == 0;
+}
+#endif
+
 void net_process_received_packet(uchar *in_packet, int len)
+{
+	net_process_received_csum(in_packet, len, 0);
+}
+
+void net_process_received_csum(uchar *in_packet, int len, uint csum)
 {
 	struct ethernet_hdr *et;
 	struct ip_udp_hdr *ip;
@@ -1100,6 +1169,12 @@ void net_process_received_packet(uchar *in_packet, int len)
 	if (len < ETHER_HDR_SIZE)
 		return;
 
+	/* The software has the last word on what the hardware found bad */
+	if (csum & ETH_CSUM_BAD) {
+		net_csum_stats.hw++;
+		csum = 0;
+	}
+
 #if defined(CONFIG_API) || defined(CONFIG_EFI_LOADER)
 	if (push_packet) {
 		(*push_packet)(in_packet, len);
@@ -1213,10 +1288,15 @@ void net_process_received_packet(uchar *in_packet, int len)
 		if ((ip->ip_hl_v & 0x0f) > 0x05)
 			return;
 		/* Check the Checksum of the header */
-		if (!ip_checksum_ok((uchar *)ip, IP_HDR_SIZE)) {
+		if (!(csum & ETH_CSUM_IP) &&
+		    !ip_checksum_ok((uchar *)ip, IP_HDR_SIZE)) {
 			debug("checksum bad\n");
+			net_csum_stats.ip++;
 			return;
 		}
+		/* The hardware cannot check the payload of a fragment */
+		if (ip->ip_off & htons(IP_OFFS | IP_FLAGS_MFRAG))
+			csum &= ~ETH_CSUM_L4;
 		/* If it is not for us, ignore it */
 		dst_ip = net_read_ip(&ip->ip_dst);
 		if (net_ip.s_addr && dst_ip.s_addr != net_ip.s_addr &&
@@ -1257,6 +1337,15 @@ void net_process_received_packet(uchar *in_packet, int len)
 		if (ip->ip_p == IPPROTO_ICMP) {
 			receive_icmp(ip, len, src_ip, et);
 			return;
+#ifdef CONFIG_PROT_TCP
+		} else if (ip->ip_p == IPPROTO_TCP) {
+			debug_cond(DEBUG_DEV_PKT,
+				   "received TCP (to=%pI4, from=%pI4, len=%d)\n",
+				   &dst_ip, &src_ip, len);
+			tcp_receive((struct ip_tcp_hdr *)ip, len,
+				    csum & ETH_CSUM_L4);
+			return;
+#endif
 		} else if (ip->ip_p != IPPROTO_UDP) {	/* Only UDP packets */
 			return;
 		}
@@ -1269,38 +1358,11 @@ void net_process_received_packet(uchar *in_packet, int len)
 			   &dst_ip, &src_ip, len);
 
 #ifdef CONFIG_UDP_CHECKSUM
-		if (ip->udp_xsum != 0) {
-			ulong   xsum;
-			u8 *sumptr;
-			ushort  sumlen;
-
-			xsum  = ip->ip_p;
-			xsum += (ntohs(ip->udp_len));
-			xsum += (ntohl(ip->ip_src.s_addr) >> 16) & 0x0000ffff;
-			xsum += (ntohl(ip->ip_src.s_addr) >>  0) & 0x0000ffff;
-			xsum += (ntohl(ip->ip_dst.s_addr) >> 16) & 0x0000ffff;
-			xsum += (ntohl(ip->ip_dst.s_addr) >>  0) & 0x0000ffff;
-
-			sumlen = ntohs(ip->udp_len);
-			sumptr = (u8 *)&ip->udp_src;
-
-			while (sumlen > 1) {
-				/* inlined ntohs() to avoid alignment errors */
-				xsum += (sumptr[0] << 8) + sumptr[1];
-				sumptr += 2;
-				sumlen -= 2;
-			}
-			if (sumlen > 0)
-				xsum += (sumptr[0] << 8) + sumptr[0];
-			while ((xsum >> 16) != 0) {
-				xsum = (xsum & 0x0000ffff) +
-				       ((xsum >> 16) & 0x0000ffff);
-			}
-			if ((xsum != 0x00000000) && (xsum != 0x0000ffff)) {
-				printf(" UDP wrong checksum %08lx %08x\n",
-				       xsum, ntohs(ip->udp_xsum));
-				return;
-			}
+		if (ip->udp_xsum != 0 && !(csum & ETH_CSUM_L4) &&
+		    !udp_checksum_ok(ip)) {
+			printf(" UDP wrong checksum %04x\n", ntohs(ip->udp_xsum));
+			net_csum_stats.udp++;
+			return;
 		}
 #endif
 
@@ -1360,6 +1422,9 @@ static int net_check_prereq(enum proto_t protocol)
 #endif
 #if defined(CONFIG_CMD_NFS)
 	case NFS:
+#endif
+#if defined(CONFIG_CMD_WGET)
+	case WGET:
 #endif
 		/* Fall through */
 	case TFTPGET:
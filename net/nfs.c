@@ -37,8 +37,10 @@
 #include "nfs.h"
 #include "bootp.h"
 #include <time.h>
+#include <linux/log2.h>
 
 #define HASHES_PER_LINE 65	/* Number of "loading" hashes per line	*/
+#define HASH_BYTES	(NFS_READ_SIZE / 2 * 10)	/* Bytes per hash	*/
 #define NFS_RETRY_COUNT 30
 #ifndef CONFIG_NFS_TIMEOUT
 # define NFS_TIMEOUT 2000UL
@@ -49,10 +51,30 @@
 #define NFS_RPC_ERR	1
 #define NFS_RPC_DROP	124
 
+/*
+ * A read whose reply has been overtaken by this many replies to later
+ * reads is sent again without waiting for the timeout: its reply, or one
+ * of its fragments, was most likely lost.
+ */
+#define NFS_READ_OVERTAKEN	3
+
+/* A READ request in flight */
+struct nfs_read_slot {
+	ulong id;		/* RPC transaction ID, 0 if the slot is free */
+	unsigned int offset;
+	unsigned int len;
+	int overtaken;		/* replies received to later reads */
+};
+
 static int fs_mounted;
 static unsigned long rpc_id;
-static int nfs_offset = -1;
-static int nfs_len;
+static unsigned int nfs_offset;	/* next offset to read */
+static unsigned int nfs_read_size;
+static unsigned int nfs_read_end;	/* end of the file, once known */
+static struct nfs_read_slot nfs_read_slots[CONFIG_NFS_READ_WINDOW];
+static ulong nfs_received;
+static ulong nfs_next_hash;
+static int nfs_hashes;
 static ulong nfs_timeout = NFS_TIMEOUT;
 
 static char dirfh[NFS_FHSIZE];	/* NFSv2 / NFSv3 file handle of directory */
@@ -73,6 +95,7 @@ static int nfs_state;
 #define STATE_LOOKUP_REQ		5
 #define STATE_READ_REQ			6
 #define STATE_READLINK_REQ		7
+#define STATE_FSINFO_REQ		8
 
 static char *nfs_filename;
 static char *nfs_path;
@@ -315,6 +338,27 @@ static void nfs_readlink_req(void)
 	rpc_req(PROG_NFS, NFS_READLINK, data, len);
 }
 
+/**************************************************************************
+NFS3_FSINFO - Get the read size limits of the server
+**************************************************************************/
+static void nfs3_fsinfo_req(void)
+{
+	uint32_t data[1024];
+	uint32_t *p;
+	int len;
+
+	p = &(data[0]);
+	p = rpc_add_credentials(p);
+
+	*p++ = htonl(filefh3_length);
+	memcpy(p, filefh, filefh3_length);
+	p += (filefh3_length / 4);
+
+	len = (uint32_t *)p - (uint32_t *)&(data[0]);
+
+	rpc_req(PROG_NFS, NFS3PROC_FSINFO, data, len);
+}
+
 /**************************************************************************
 NFS_LOOKUP - Lookup Pathname
 **************************************************************************/
@@ -391,6 +435,78 @@ static void nfs_read_req(int offset, int readlen)
 	rpc_req(PROG_NFS, NFS_READ, data, len);
 }
 
+static void nfs_read_send(struct nfs_read_slot *slot)
+{
+	nfs_read_req(slot->offset, slot->len);
+	slot->id = rpc_id;
+	slot->overtaken = 0;
+}
+
+/* Request the next parts of the file in the free slots */
+static void nfs_read_fill(void)
+{
+	struct nfs_read_slot *slot;
+	int i;
+
+	for (i = 0; i < CONFIG_NFS_READ_WINDOW; i++) {
+		slot = &nfs_read_slots[i];
+		if (slot->id || nfs_offset >= nfs_read_end)
+			continue;
+		slot->offset = nfs_offset;
+		slot->len = min(nfs_read_size, nfs_read_end - nfs_offset);
+		nfs_offset += slot->len;
+		nfs_read_send(slot);
+	}
+}
+
+/* Send all reads in flight again, after a timeout */
+static void nfs_read_resend(void)
+{
+	int i;
+
+	for (i = 0; i < CONFIG_NFS_READ_WINDOW; i++) {
+		if (nfs_read_slots[i].id)
+			nfs_read_send(&nfs_read_slots[i]);
+	}
+}
+
+static void nfs_read_start(void)
+{
+	memset(nfs_read_slots, 0, sizeof(nfs_read_slots));
+	nfs_offset = 0;
+	nfs_read_end = ~0U;
+	nfs_received = 0;
+	nfs_next_hash = HASH_BYTES;
+	nfs_hashes = 0;
+	debug("NFS read size %u, window %d\n", nfs_read_size,
+	      CONFIG_NFS_READ_WINDOW);
+
+	nfs_state = STATE_READ_REQ;
+	nfs_read_fill();
+}
+
+/*
+ * Largest read whose reply we can receive, in a single frame or
+ * reassembled if needed
+ */
+static unsigned int nfs_max_read_size(void)
+{
+	unsigned int size;
+
+	size = rounddown_pow_of_two(eth_get_mtu() - IP_UDP_HDR_SIZE -
+				    NFS_READ_HDR_SIZE);
+#ifdef CONFIG_IP_DEFRAG
+	size = max_t(unsigned int, size,
+		     rounddown_pow_of_two(CONFIG_NET_MAXDEFRAG -
+					  IP_UDP_HDR_SIZE - NFS_READ_HDR_SIZE));
+#endif
+	size = max(size, (unsigned int)NFS_READ_SIZE);
+	if (supported_nfs_versions & NFSV2_FLAG)
+		size = min(size, (unsigned int)NFS2_MAXDATA);
+
+	return size;
+}
+
 /**************************************************************************
 RPC request dispatcher
 **************************************************************************/
@@ -421,11 +537,14 @@ static void nfs_send(void)
 		nfs_lookup_req(nfs_filename);
 		break;
 	case STATE_READ_REQ:
-		nfs_read_req(nfs_offset, nfs_len);
+		nfs_read_resend();
 		break;
 	case STATE_READLINK_REQ:
 		nfs_readlink_req();
 		break;
+	case STATE_FSINFO_REQ:
+		nfs3_fsinfo_req();
+		break;
 	}
 }
 
@@ -664,21 +783,72 @@ static int nfs_readlink_reply(uchar *pkt, unsigned len)
 	return 0;
 }
 
-static int nfs_read_reply(uchar *pkt, unsigned len)
+static int nfs3_fsinfo_reply(uchar *pkt, unsigned len)
 {
 	struct rpc_t rpc_pkt;
-	int rlen;
-	uchar *data_ptr;
+	int nfsv3_data_offset;
+	unsigned int rtmax;
 
 	debug("%s\n", __func__);
 
-	memcpy(&rpc_pkt.u.data[0], pkt, sizeof(rpc_pkt.u.reply));
+	memcpy(&rpc_pkt.u.data[0], pkt, len);
 
 	if (ntohl(rpc_pkt.u.reply.id) > rpc_id)
 		return -NFS_RPC_ERR;
 	else if (ntohl(rpc_pkt.u.reply.id) < rpc_id)
 		return -NFS_RPC_DROP;
 
+	if (rpc_pkt.u.reply.rstatus  ||
+	    rpc_pkt.u.reply.verifier ||
+	    rpc_pkt.u.reply.astatus  ||
+	    rpc_pkt.u.reply.data[0])
+		return -1;
+
+	nfsv3_data_offset = nfs3_get_attributes_offset(rpc_pkt.u.reply.data);
+	if (((uchar *)&(rpc_pkt.u.reply.data[2 + nfsv3_data_offset]) - (uchar *)(&rpc_pkt)) > len)
+		return -NFS_RPC_DROP;
+
+	/* rtmax, the largest read the server supports */
+	rtmax = ntohl(rpc_pkt.u.reply.data[1 + nfsv3_data_offset]);
+	if (rtmax && rtmax < nfs_read_size)
+		nfs_read_size = rounddown_pow_of_two(rtmax);
+
+	return 0;
+}
+
+static struct nfs_read_slot *nfs_read_find(ulong id)
+{
+	int i;
+
+	if (!id)
+		return NULL;
+	for (i = 0; i < CONFIG_NFS_READ_WINDOW; i++) {
+		if (nfs_read_slots[i].id == id)
+			return &nfs_read_slots[i];
+	}
+
+	return NULL;
+}
+
+static int nfs_read_reply(uchar *pkt, unsigned len,
+			  struct nfs_read_slot **slotp, int *eof)
+{
+	struct rpc_t rpc_pkt;
+	struct nfs_read_slot *slot;
+	unsigned int rlen;
+	unsigned int hdr_len;
+
+	debug("%s\n", __func__);
+
+	/* Only the headers, the data is stored straight from the packet */
+	memcpy(&rpc_pkt.u.data[0], pkt,
+	       min_t(unsigned int, len, NFS_READ_HDR_SIZE));
+
+	slot = nfs_read_find(ntohl(rpc_pkt.u.reply.id));
+	if (!slot)
+		return -NFS_RPC_DROP;
+	*slotp = slot;
+
 	if (rpc_pkt.u.reply.rstatus  ||
 	    rpc_pkt.u.reply.verifier ||
 	    rpc_pkt.u.reply.astatus  ||
@@ -690,38 +860,88 @@ static int nfs_read_reply(uchar *pkt, unsigned len)
 		return -ntohl(rpc_pkt.u.reply.data[0]);
 	}
 
-	if ((nfs_offset != 0) && !((nfs_offset) %
-			(NFS_READ_SIZE / 2 * 10 * HASHES_PER_LINE)))
-		puts("\n\t ");
-	if (!(nfs_offset % ((NFS_READ_SIZE / 2) * 10)))
-		putc('#');
-
 	if (supported_nfs_versions & NFSV2_FLAG) {
 		rlen = ntohl(rpc_pkt.u.reply.data[18]);
-		data_ptr = (uchar *)&(rpc_pkt.u.reply.data[19]);
+		hdr_len = (uchar *)&(rpc_pkt.u.reply.data[19]) -
+			  (uchar *)&rpc_pkt;
+		*eof = 0;
 	} else {  /* NFSV3_FLAG */
 		int nfsv3_data_offset =
 			nfs3_get_attributes_offset(rpc_pkt.u.reply.data);
 
 		/* count value */
 		rlen = ntohl(rpc_pkt.u.reply.data[1 + nfsv3_data_offset]);
+		*eof = ntohl(rpc_pkt.u.reply.data[2 + nfsv3_data_offset]);
 		/* Skip unused values :
-			EOF:		32 bits value,
 			data_size:	32 bits value,
 		*/
-		data_ptr = (uchar *)
-			&(rpc_pkt.u.reply.data[4 + nfsv3_data_offset]);
+		hdr_len = (uchar *)
+			&(rpc_pkt.u.reply.data[4 + nfsv3_data_offset]) -
+			(uchar *)&rpc_pkt;
 	}
 
-	if (((uchar *)&(rpc_pkt.u.reply.data[0]) - (uchar *)(&rpc_pkt) + rlen) > len)
-			return -9999;
+	if (rlen > slot->len || hdr_len + rlen > len)
+		return -9999;
 
-	if (store_block(data_ptr, nfs_offset, rlen))
-			return -9999;
+	/* an empty read must not extend the file, it may be past its end */
+	if (rlen && store_block(pkt + hdr_len, slot->offset, rlen))
+		return -9999;
 
 	return rlen;
 }
 
+/* Account for a read of rlen bytes, and request what comes next */
+static void nfs_read_done(struct nfs_read_slot *slot, unsigned int rlen,
+			  int eof)
+{
+	struct nfs_read_slot *s;
+	int i;
+
+	for (i = 0; i < CONFIG_NFS_READ_WINDOW; i++) {
+		s = &nfs_read_slots[i];
+		if (s->id && s->id < slot->id &&
+		    ++s->overtaken >= NFS_READ_OVERTAKEN)
+			nfs_read_send(s);
+	}
+
+	nfs_received += rlen;
+	while (nfs_received >= nfs_next_hash) {
+		putc('#');
+		if (!(++nfs_hashes % HASHES_PER_LINE))
+			puts("\n\t ");
+		nfs_next_hash += HASH_BYTES;
+	}
+
+	if ((eof || !rlen) && slot->offset + rlen < nfs_read_end) {
+		nfs_read_end = slot->offset + rlen;
+		/* forget the reads beyond the end of the file */
+		for (i = 0; i < CONFIG_NFS_READ_WINDOW; i++) {
+			if (nfs_read_slots[i].offset >= nfs_read_end)
+				nfs_read_slots[i].id = 0;
+		}
+	}
+
+	if (rlen && rlen < slot->len && slot->offset + rlen < nfs_read_end) {
+		/* short read, ask for the rest */
+		slot->offset += rlen;
+		slot->len -= rlen;
+		nfs_read_send(slot);
+	} else {
+		slot->id = 0;
+	}
+
+	nfs_read_fill();
+	for (i = 0; i < CONFIG_NFS_READ_WINDOW; i++) {
+		if (nfs_read_slots[i].id)
+			return;
+	}
+
+	/* all read */
+	nfs_download_state = NETLOOP_SUCCESS;
+	nfs_state = STATE_UMOUNT_REQ;
+	nfs_send();
+}
+
 /**************************************************************************
 Interfaces of U-BOOT
 **************************************************************************/
@@ -742,12 +962,15 @@ static void nfs_timeout_handler(void)
 static void nfs_handler(uchar *pkt, unsigned dest, struct in_addr sip,
 			unsigned src, unsigned len)
 {
+	struct nfs_read_slot *slot;
 	int rlen;
 	int reply;
+	int eof;
 
 	debug("%s\n", __func__);
 
-	if (len > sizeof(struct rpc_t))
+	/* Only read replies may be larger, see nfs_max_read_size() */
+	if (len > sizeof(struct rpc_t) && nfs_state != STATE_READ_REQ)
 		return;
 
 	if (dest != nfs_our_port)
@@ -812,14 +1035,26 @@ static void nfs_handler(uchar *pkt, unsigned dest, struct in_addr sip,
 			/* And retry with another supported version */
 			nfs_state = STATE_PRCLOOKUP_PROG_MOUNT_REQ;
 			nfs_send();
-		} else {
-			nfs_state = STATE_READ_REQ;
-			nfs_offset = 0;
-			nfs_len = NFS_READ_SIZE;
+		} else if (supported_nfs_versions & NFSV2_FLAG) {
+			nfs_read_size = nfs_max_read_size();
+			nfs_read_start();
+		} else {  /* NFSV3_FLAG */
+			nfs_read_size = nfs_max_read_size();
+			nfs_state = STATE_FSINFO_REQ;
 			nfs_send();
 		}
 		break;
 
+	case STATE_FSINFO_REQ:
+		reply = nfs3_fsinfo_reply(pkt, len);
+		if (reply == -NFS_RPC_DROP)
+			break;
+		/* without the limits of the server, stay on the safe side */
+		if (reply)
+			nfs_read_size = NFS_READ_SIZE;
+		nfs_read_start();
+		break;
+
 	case STATE_READLINK_REQ:
 		reply = nfs_readlink_reply(pkt, len);
 		if (reply == -NFS_RPC_DROP) {
@@ -839,22 +1074,18 @@ static void nfs_handler(uchar *pkt, unsigned dest, struct in_addr sip,
 		break;
 
 	case STATE_READ_REQ:
-		rlen = nfs_read_reply(pkt, len);
+		rlen = nfs_read_reply(pkt, len, &slot, &eof);
 		if (rlen == -NFS_RPC_DROP)
 			break;
 		net_set_timeout_handler(nfs_timeout, nfs_timeout_handler);
-		if (rlen > 0) {
-			nfs_offset += rlen;
-			nfs_send();
+		if (rlen >= 0) {
+			nfs_read_done(slot, rlen, eof);
 		} else if ((rlen == -NFSERR_ISDIR) || (rlen == -NFSERR_INVAL)) {
 			/* symbolic link */
 			nfs_state = STATE_READLINK_REQ;
 			nfs_send();
 		} else {
-			if (!rlen)
-				nfs_download_state = NETLOOP_SUCCESS;
-			if (rlen < 0)
-				debug("NFS READ error (%d)\n", rlen);
+			debug("NFS READ error (%d)\n", rlen);
 			nfs_state = STATE_UMOUNT_REQ;
 			nfs_send();
 		}
@@ -0,0 +1,460 @@
+// SPDX-License-Identifier: GPL-2.0+
+/*
+ * Minimal TCP client
+ *
+ * Just enough TCP to download files quickly: one active connection at a
+ * time, small requests from us and a bulk transfer from the peer. Data is
+ * accepted in order only and acknowledged cumulatively (no SACK); an
+ * out-of-order segment is dropped and answered with a duplicate ACK, which
+ * makes the sender retransmit from the hole. ACKs are delayed until every
+ * second segment, a pushed segment or the next timer tick, and a window
+ * scale option lets the peer keep more than 64KiB in flight.
+ */
+
+#include <common.h>
+#include <log.h>
+#include <net.h>
+#include <time.h>
+#include <net/tcp.h>
+#include <asm/unaligned.h>
+#include <linux/kernel.h>
+
+/* Initial retransmission timeout, doubled on each retry up to the maximum */
+#define TCP_RTO_MS		1000
+#define TCP_RTO_MAX_MS		4000
+#define TCP_MAX_RETRIES		5
+/* Drop the connection when nothing was received for this long */
+#define TCP_IDLE_TIMEOUT_MS	10000
+/* Interval of the timer sending delayed ACKs and retransmissions */
+#define TCP_TICK_MS		100
+/* Acknowledge at least every second segment (RFC 1122) */
+#define TCP_ACK_EVERY		2
+/* MSS to assume when the peer does not send the option (RFC 879) */
+#define TCP_DEFAULT_MSS		536
+
+#define SEQ_LT(a, b)		((s32)((a) - (b)) < 0)
+#define SEQ_LEQ(a, b)		((s32)((a) - (b)) <= 0)
+
+static struct tcp_conn {
+	enum tcp_state state;
+	struct in_addr remote_ip;
+	uchar remote_ethaddr[ARP_HLEN];
+	int remote_port;
+	int local_port;
+	u32 iss;		/* our initial sequence number */
+	u32 snd_una;		/* oldest unacknowledged sequence number */
+	u32 snd_nxt;		/* next sequence number to send */
+	u32 rcv_nxt;		/* next sequence number expected */
+	unsigned int snd_mss;	/* largest segment the peer accepts */
+	u8 rcv_wscale;		/* scale of the window we advertise */
+	bool fin_sent;
+	unsigned int ack_pending;	/* segments received and not ACKed */
+	uchar txbuf[TCP_MSS];	/* data sent and not acknowledged */
+	unsigned int txlen;
+	ulong tx_time;		/* when snd_una was last sent */
+	ulong rx_time;		/* when the last segment was received */
+	ulong rto;
+	int retries;
+	rxhand_tcp *handler;
+	struct tcp_stats stats;
+} conn;
+
+static u16 tcp_checksum(struct in_addr src, struct in_addr dest,
+			const void *seg, unsigned int len)
+{
+	struct {
+		struct in_addr src;
+		struct in_addr dest;
+		u8 zero;
+		u8 proto;
+		u16 len;
+	} __attribute__((packed)) ph;
+
+	ph.src = src;
+	ph.dest = dest;
+	ph.zero = 0;
+	ph.proto = IPPROTO_TCP;
+	ph.len = htons(len);
+
+	return add_ip_checksums(sizeof(ph), compute_ip_checksum(&ph, sizeof(ph)),
+				compute_ip_checksum(seg, len));
+}
+
+int tcp_set_tcp_header(uchar *pkt, struct in_addr dest, int dport, int sport,
+		       int payload_len, u8 action, u32 tcp_seq_num,
+		       u32 tcp_ack_num)
+{
+	struct ip_tcp_hdr *tcp = (struct ip_tcp_hdr *)pkt;
+	uchar *opt = pkt + IP_TCP_HDR_SIZE;
+	int hdr_len = TCP_HDR_SIZE;
+	ulong wnd = TCP_RCV_WND >> conn.rcv_wscale;
+
+	if (action & TCP_SYN) {
+		/* MSS, then the window scale aligned by a NOP */
+		opt[0] = TCP_O_MSS;
+		opt[1] = 4;
+		put_unaligned_be16(eth_get_mtu() - IP_TCP_HDR_SIZE, opt + 2);
+		opt[4] = TCP_O_NOP;
+		opt[5] = TCP_O_WS;
+		opt[6] = 3;
+		opt[7] = TCP_RCV_WSCALE;
+		hdr_len += 8;
+		/* the window of a SYN is never scaled */
+		wnd = TCP_RCV_WND;
+	}
+
+	net_set_ip_header(pkt, dest, net_ip, IP_HDR_SIZE + hdr_len + payload_len,
+			  IPPROTO_TCP);
+
+	tcp->tcp_src = htons(sport);
+	tcp->tcp_dst = htons(dport);
+	tcp->tcp_seq = htonl(tcp_seq_num);
+	tcp->tcp_ack = action & TCP_ACK ? htonl(tcp_ack_num) : 0;
+	tcp->tcp_hlen = (hdr_len / 4) << 4;
+	tcp->tcp_flags = action;
+	tcp->tcp_win = htons(min(wnd, 0xffffUL));
+	tcp->tcp_urg = 0;
+	tcp->tcp_xsum = 0;
+	tcp->tcp_xsum = tcp_checksum(net_ip, dest, &tcp->tcp_src,
+				     hdr_len + payload_len);
+
+	return IP_HDR_SIZE + hdr_len;
+}
+
+static void tcp_send(u8 action, u32 seq, unsigned int len)
+{
+	/* every segment acknowledges all we have received */
+	conn.ack_pending = 0;
+	net_send_ip_packet(conn.remote_ethaddr, conn.remote_ip,
+			   conn.remote_port, conn.local_port, len, IPPROTO_TCP,
+			   action, seq, conn.rcv_nxt);
+}
+
+static void tcp_send_ack(void)
+{
+	tcp_send(TCP_ACK, conn.snd_nxt, 0);
+}
+
+/* Send everything which is not acknowledged yet, starting at snd_una */
+static void tcp_output(void)
+{
+	u8 action = TCP_ACK;
+
+	conn.tx_time = get_timer(0);
+	if (conn.state == TCP_SYN_SENT) {
+		tcp_send(TCP_SYN, conn.iss, 0);
+		return;
+	}
+
+	if (conn.txlen) {
+		memcpy(net_tx_packet + net_eth_hdr_size() + IP_TCP_HDR_SIZE,
+		       conn.txbuf, conn.txlen);
+		action |= TCP_PUSH;
+	}
+	if (conn.fin_sent)
+		action |= TCP_FIN;
+	tcp_send(action, conn.snd_una, conn.txlen);
+}
+
+static void tcp_drop(enum tcp_event event)
+{
+	conn.state = TCP_CLOSED;
+	conn.handler(event, NULL, 0);
+}
+
+static void tcp_timer(void)
+{
+	if (conn.state == TCP_CLOSED)
+		return;
+
+	if (conn.ack_pending)
+		tcp_send_ack();
+
+	if (conn.snd_una != conn.snd_nxt) {
+		if (get_timer(conn.tx_time) >= conn.rto) {
+			if (++conn.retries > TCP_MAX_RETRIES) {
+				tcp_drop(TCP_EVENT_TIMEOUT);
+				return;
+			}
+			conn.rto = min(conn.rto * 2, (ulong)TCP_RTO_MAX_MS);
+			conn.stats.retransmits++;
+			tcp_output();
+		}
+	} else if (get_timer(conn.rx_time) >= TCP_IDLE_TIMEOUT_MS) {
+		tcp_drop(TCP_EVENT_TIMEOUT);
+		return;
+	}
+
+	net_set_timeout_handler(TCP_TICK_MS, tcp_timer);
+}
+
+void tcp_connect(struct in_addr dest, int dport, rxhand_tcp *handler)
+{
+	u32 ticks = get_ticks();
+
+	memset(&conn, '\0', sizeof(conn));
+	conn.remote_ip = dest;
+	conn.remote_port = dport;
+	/* an ephemeral port (RFC 6335) and sequence number from the timer */
+	conn.local_port = 49152 + (ticks & 0x3fff);
+	conn.iss = ticks * 2654435761U;
+	conn.snd_una = conn.iss;
+	conn.snd_nxt = conn.iss + 1;
+	conn.snd_mss = TCP_DEFAULT_MSS;
+	conn.rto = TCP_RTO_MS;
+	conn.rx_time = get_timer(0);
+	conn.handler = handler;
+	conn.state = TCP_SYN_SENT;
+
+	debug_cond(DEBUG_DEV_PKT, "TCP connect %pI4:%d from port %d\n",
+		   &dest, dport, conn.local_port);
+	net_set_timeout_handler(TCP_TICK_MS, tcp_timer);
+	tcp_output();
+}
+
+int tcp_write(const void *data, unsigned int len)
+{
+	if (conn.state != TCP_ESTABLISHED && conn.state != TCP_CLOSE_WAIT)
+		return -ENOTCONN;
+	if (conn.snd_una != conn.snd_nxt)
+		return -EBUSY;
+	if (len > min(conn.snd_mss, (unsigned int)sizeof(conn.txbuf)) ||
+	    len > eth_get_mtu() - IP_TCP_HDR_SIZE)
+		return -E2BIG;
+
+	memcpy(conn.txbuf, data, len);
+	conn.txlen = len;
+	conn.snd_nxt += len;
+	conn.rto = TCP_RTO_MS;
+	conn.retries = 0;
+	tcp_output();
+
+	return 0;
+}
+
+void tcp_close(void)
+{
+	switch (conn.state) {
+	case TCP_SYN_SENT:
+		conn.state = TCP_CLOSED;
+		return;
+	case TCP_ESTABLISHED:
+		conn.state = TCP_FIN_WAIT_1;
+		break;
+	case TCP_CLOSE_WAIT:
+		conn.state = TCP_LAST_ACK;
+		break;
+	default:
+		return;
+	}
+
+	conn.fin_sent = true;
+	conn.snd_nxt++;
+	conn.rto = TCP_RTO_MS;
+	conn.retries = 0;
+	tcp_output();
+}
+
+void tcp_abort(void)
+{
+	if (conn.state != TCP_CLOSED && conn.state != TCP_SYN_SENT)
+		tcp_send(TCP_RST | TCP_ACK, conn.snd_nxt, 0);
+	conn.state = TCP_CLOSED;
+}
+
+enum tcp_state tcp_get_state(void)
+{
+	return conn.state;
+}
+
+const struct tcp_stats *tcp_get_stats(void)
+{
+	return &conn.stats;
+}
+
+void tcp_init(void)
+{
+	conn.state = TCP_CLOSED;
+}
+
+static void tcp_parse_options(const uchar *opt, int len)
+{
+	while (len > 0 && opt[0] != TCP_O_END) {
+		if (opt[0] == TCP_O_NOP) {
+			opt++;
+			len--;
+			continue;
+		}
+		if (len < 2 || opt[1] < 2 || opt[1] > len)
+			return;
+
+		switch (opt[0]) {
+		case TCP_O_MSS:
+			if (opt[1] == 4)
+				conn.snd_mss = get_unaligned_be16(opt + 2);
+			break;
+		case TCP_O_WS:
+			/* scaling is only used if both ends offer it */
+			if (opt[1] == 3)
+				conn.rcv_wscale = TCP_RCV_WSCALE;
+			break;
+		}
+		len -= opt[1];
+		opt += opt[1];
+	}
+}
+
+static void tcp_rx_syn(struct ip_tcp_hdr *tcp, unsigned int hlen, u8 flags,
+		       u32 seq, u32 ack)
+{
+	if ((flags & TCP_ACK) && ack != conn.iss + 1)
+		return;
+	if (flags & TCP_RST) {
+		/* connection refused */
+		if (flags & TCP_ACK)
+			tcp_drop(TCP_EVENT_RESET);
+		return;
+	}
+	/* simultaneous open is not supported */
+	if (!(flags & TCP_SYN) || !(flags & TCP_ACK))
+		return;
+
+	tcp_parse_options((uchar *)tcp + IP_TCP_HDR_SIZE,
+			  hlen - TCP_HDR_SIZE);
+	conn.rcv_nxt = seq + 1;
+	conn.snd_una = ack;
+	conn.rto = TCP_RTO_MS;
+	conn.retries = 0;
+	conn.state = TCP_ESTABLISHED;
+	debug_cond(DEBUG_DEV_PKT, "TCP established, mss %u wscale %u\n",
+		   conn.snd_mss, conn.rcv_wscale);
+
+	tcp_send_ack();
+	conn.handler(TCP_EVENT_CONNECTED, NULL, 0);
+}
+
+static void tcp_rx_ack(u32 ack)
+{
+	u32 acked = ack - conn.snd_una;
+
+	if (acked >= conn.txlen) {
+		conn.txlen = 0;
+	} else {
+		conn.txlen -= acked;
+		memmove(conn.txbuf, conn.txbuf + acked, conn.txlen);
+	}
+	conn.snd_una = ack;
+	conn.rto = TCP_RTO_MS;
+	conn.retries = 0;
+	conn.tx_time = get_timer(0);
+
+	if (conn.fin_sent && ack == conn.snd_nxt) {
+		if (conn.state == TCP_FIN_WAIT_1)
+			conn.state = TCP_FIN_WAIT_2;
+		else if (conn.state == TCP_LAST_ACK)
+			conn.state = TCP_CLOSED;
+	}
+}
+
+void tcp_receive(struct ip_tcp_hdr *tcp, unsigned int len, bool csum_ok)
+{
+	unsigned int hlen = (tcp->tcp_hlen >> 4) * 4;
+	u8 flags = tcp->tcp_flags;
+	unsigned int dlen;
+	uchar *data;
+	u32 seq, ack;
+
+	if (conn.state == TCP_CLOSED || len < IP_TCP_HDR_SIZE)
+		return;
+	if (hlen < TCP_HDR_SIZE || IP_HDR_SIZE + hlen > len)
+		return;
+	if (net_read_ip(&tcp->ip_src).s_addr != conn.remote_ip.s_addr ||
+	    ntohs(tcp->tcp_src) != conn.remote_port ||
+	    ntohs(tcp->tcp_dst) != conn.local_port)
+		return;
+	if (!csum_ok &&
+	    tcp_checksum(net_read_ip(&tcp->ip_src), net_read_ip(&tcp->ip_dst),
+			 &tcp->tcp_src, len - IP_HDR_SIZE)) {
+		conn.stats.bad_xsum++;
+		net_csum_stats.tcp++;
+		return;
+	}
+
+	seq = ntohl(tcp->tcp_seq);
+	ack = ntohl(tcp->tcp_ack);
+	data = (uchar *)tcp + IP_HDR_SIZE + hlen;
+	dlen = len - IP_HDR_SIZE - hlen;
+	conn.rx_time = get_timer(0);
+
+	if (conn.state == TCP_SYN_SENT) {
+		tcp_rx_syn(tcp, hlen, flags, seq, ack);
+		return;
+	}
+
+	if (flags & TCP_RST) {
+		/* only believe a reset which is within the window */
+		if (SEQ_LEQ(conn.rcv_nxt, seq) &&
+		    SEQ_LT(seq, conn.rcv_nxt + TCP_RCV_WND))
+			tcp_drop(TCP_EVENT_RESET);
+		return;
+	}
+
+	if ((flags & TCP_ACK) && SEQ_LT(conn.snd_una, ack) &&
+	    SEQ_LEQ(ack, conn.snd_nxt))
+		tcp_rx_ack(ack);
+	if (conn.state == TCP_CLOSED || (!dlen && !(flags & TCP_FIN)))
+		return;
+
+	/* drop what we already have, then anything which is not next */
+	if (SEQ_LT(seq, conn.rcv_nxt)) {
+		u32 dup = conn.rcv_nxt - seq;
+
+		if (dup > dlen || (dup == dlen && !(flags & TCP_FIN))) {
+			conn.stats.ooo++;
+			tcp_send_ack();
+			return;
+		}
+		data += dup;
+		dlen -= dup;
+		seq += dup;
+	}
+	if (seq != conn.rcv_nxt) {
+		conn.stats.ooo++;
+		tcp_send_ack();
+		return;
+	}
+
+	if (dlen) {
+		conn.rcv_nxt += dlen;
+		conn.ack_pending++;
+		conn.stats.segments++;
+		conn.handler(TCP_EVENT_DATA, data, dlen);
+		if (conn.state == TCP_CLOSED)
+			return;
+	}
+
+	if (flags & TCP_FIN) {
+		conn.rcv_nxt++;
+		switch (conn.state) {
+		case TCP_ESTABLISHED:
+			conn.state = TCP_CLOSE_WAIT;
+			break;
+		case TCP_FIN_WAIT_1:
+			/* simultaneous close, wait for the ACK of our FIN */
+			conn.state = TCP_LAST_ACK;
+			break;
+		case TCP_FIN_WAIT_2:
+			/* no TIME_WAIT, we won't reuse the port */
+			conn.state = TCP_CLOSED;
+			break;
+		default:
+			break;
+		}
+		tcp_send_ack();
+		conn.handler(TCP_EVENT_EOF, NULL, 0);
+		return;
+	}
+
+	if (conn.ack_pending >= TCP_ACK_EVERY || (flags & TCP_PUSH))
+		tcp_send_ack();
+}
@@ -116,6 +116,8 @@ static int	tftp_put_final_block_sent;
 
 /* default TFTP block size */
 #define TFTP_BLOCK_SIZE		512
+/* opcode and block number in front of the data */
+#define TFTP_DATA_HDR_SIZE	4
 /* sequence number is 16 bit */
 #define TFTP_SEQUENCE_SIZE	((ulong)(1<<16))
 
@@ -134,11 +136,35 @@ static char tftp_filename[MAX_LEN];
  * Minus eth.hdrs thats 1468.  Can get 2x better throughput with
  * almost-MTU block sizes.  At least try... fall back to 512 if need be.
  * (but those using CONFIG_IP_DEFRAG may want to set a larger block in cfg file)
+ * On networks with jumbo frames the block grows with the MTU of the device,
+ * see tftp_mtu_block_size().
  */
 
 static unsigned short tftp_block_size = TFTP_BLOCK_SIZE;
 static unsigned short tftp_block_size_option = CONFIG_TFTP_BLOCKSIZE;
 
+/*
+ * RFC 7440 windowsize: the sender transmits this many blocks before waiting
+ * for an ACK. A window size of 1 is the classic lock-step protocol.
+ */
+static unsigned short tftp_window_size = 1;
+static unsigned short tftp_window_size_option = CONFIG_TFTP_WINDOWSIZE;
+/* block number which completes the current window and must be ACKed */
+static ulong	tftp_next_ack;
+/* last block for which an out-of-order ACK was sent, or -1 */
+static long	tftp_last_nack;
+#ifdef CONFIG_CMD_TFTPSRV
+/* options accepted from a WRQ, to be confirmed with an OACK */
+#define TFTP_OACK_BLKSIZE	(1 << 0)
+#define TFTP_OACK_WINDOWSIZE	(1 << 1)
+static int	tftp_send_oack;
+#endif
+
+/* transfer statistics, printed when non-zero */
+static ulong	tftp_stat_timeouts;
+static ulong	tftp_stat_dups;
+static ulong	tftp_stat_ooo;
+
 static inline int store_block(int block, uchar *src, unsigned int len)
 {
 	ulong offset = block * tftp_block_size + tftp_block_wrap_offset;
@@ -198,6 +224,8 @@ static void new_transfer(void)
 	tftp_prev_block = 0;
 	tftp_block_wrap = 0;
 	tftp_block_wrap_offset = 0;
+	tftp_next_ack = tftp_window_size;
+	tftp_last_nack = -1;
 #ifdef CONFIG_CMD_TFTPPUT
 	tftp_put_final_block_sent = 0;
 #endif
@@ -305,6 +333,9 @@ static void tftp_complete(void)
 		print_size(net_boot_file_size /
 			time_start * 1000, "/s");
 	}
+	if (tftp_stat_timeouts || tftp_stat_dups || tftp_stat_ooo)
+		printf("\n\t %lu timeouts, %lu duplicate, %lu out-of-order blocks",
+		       tftp_stat_timeouts, tftp_stat_dups, tftp_stat_ooo);
 	puts("\ndone\n");
 	net_set_state(NETLOOP_SUCCESS);
 }
@@ -350,17 +381,44 @@ static void tftp_send(void)
 		/* try for more effic. blk size */
 		pkt += sprintf((char *)pkt, "blksize%c%d%c",
 				0, tftp_block_size_option, 0);
+
+		/* try for more effic. window size, only when receiving */
+		if (tftp_state == STATE_SEND_RRQ && tftp_window_size_option > 1)
+			pkt += sprintf((char *)pkt, "windowsize%c%d%c",
+				       0, tftp_window_size_option, 0);
 		len = pkt - xp;
 		break;
 
 	case STATE_OACK:
 
 	case STATE_RECV_WRQ:
+#ifdef CONFIG_CMD_TFTPSRV
+		if (tftp_state == STATE_RECV_WRQ && tftp_send_oack) {
+			xp = pkt;
+			s = (ushort *)pkt;
+			*s++ = htons(TFTP_OACK);
+			pkt = (uchar *)s;
+			if (tftp_send_oack & TFTP_OACK_BLKSIZE)
+				pkt += sprintf((char *)pkt, "blksize%c%d%c",
+					       0, tftp_block_size, 0);
+			if (tftp_send_oack & TFTP_OACK_WINDOWSIZE)
+				pkt += sprintf((char *)pkt, "windowsize%c%d%c",
+					       0, tftp_window_size, 0);
+			len = pkt - xp;
+			break;
+		}
+#endif
 	case STATE_DATA:
 		xp = pkt;
 		s = (ushort *)pkt;
 		s[0] = htons(TFTP_ACK);
-		s[1] = htons(tftp_cur_block);
+		/*
+		 * Always acknowledge the last block received in order, so
+		 * that an ACK sent after a gap in a window makes the sender
+		 * restart from the first missing block.
+		 */
+		s[1] = htons(tftp_put_active ? tftp_cur_block :
+			     tftp_prev_block);
 		pkt = (uchar *)(s + 2);
 #ifdef CONFIG_CMD_TFTPPUT
 		if (tftp_put_active) {
@@ -415,6 +473,48 @@ static void icmp_handler(unsigned type, unsigned code, unsigned dest,
 }
 #endif
 
+#ifdef CONFIG_CMD_TFTPSRV
+/*
+ * Look at the options of a write request (filename, mode, then option/value
+ * pairs) and accept blksize and windowsize, so that the client can send
+ * large blocks in windows. If any is accepted the WRQ is answered with an
+ * OACK rather than ACK(0).
+ */
+static void tftp_parse_wrq_options(char *pkt, unsigned len)
+{
+	char *end = pkt + len;
+	char *opt, *val;
+	ulong n;
+
+	tftp_send_oack = 0;
+
+	/* skip the file name and mode */
+	opt = pkt;
+	for (n = 0; n < 2 && opt < end; n++)
+		opt += strnlen(opt, end - opt) + 1;
+
+	while (opt < end) {
+		val = opt + strnlen(opt, end - opt) + 1;
+		if (val >= end)
+			break;
+		n = simple_strtoul(val, NULL, 10);
+		if (!strcmp(opt, "blksize") && n >= 8) {
+			tftp_block_size = min_t(ulong, n,
+						tftp_block_size_option);
+			tftp_send_oack |= TFTP_OACK_BLKSIZE;
+		} else if (!strcmp(opt, "windowsize") && n >= 1) {
+			tftp_window_size = min_t(ulong, n,
+						 tftp_window_size_option);
+			tftp_send_oack |= TFTP_OACK_WINDOWSIZE;
+		}
+		opt = val + strnlen(val, end - val) + 1;
+	}
+
+	debug("WRQ blksize %d, windowsize %d\n", tftp_block_size,
+	      tftp_window_size);
+}
+#endif
+
 static void tftp_handler(uchar *pkt, unsigned dest, struct in_addr sip,
 			 unsigned src, unsigned len)
 {
@@ -471,8 +571,9 @@ static void tftp_handler(uchar *pkt, unsigned dest, struct in_addr sip,
 		tftp_remote_ip = sip;
 		tftp_remote_port = src;
 		tftp_our_port = 1024 + (get_timer(0) % 3072);
+		tftp_parse_wrq_options((char *)pkt, len);
 		new_transfer();
-		tftp_send(); /* Send ACK(0) */
+		tftp_send(); /* Send ACK(0) or OACK */
 		break;
 #endif
 
@@ -494,6 +595,16 @@ static void tftp_handler(uchar *pkt, unsigned dest, struct in_addr sip,
 				debug("Blocksize ack: %s, %d\n",
 				      (char *)pkt + i + 8, tftp_block_size);
 			}
+			if (i + 11 < len &&
+			    strcmp((char *)pkt + i, "windowsize") == 0) {
+				tftp_window_size = (unsigned short)
+					simple_strtoul((char *)pkt + i + 11,
+						       NULL, 10);
+				if (!tftp_window_size)
+					tftp_window_size = 1;
+				debug("Windowsize ack: %s, %d\n",
+				      (char *)pkt + i + 11, tftp_window_size);
+			}
 #ifdef CONFIG_TFTP_TSIZE
 			if (strcmp((char *)pkt+i, "tsize") == 0) {
 				tftp_tsize = simple_strtoul((char *)pkt + i + 6,
@@ -518,8 +629,6 @@ static void tftp_handler(uchar *pkt, unsigned dest, struct in_addr sip,
 		len -= 2;
 		tftp_cur_block = ntohs(*(__be16 *)pkt);
 
-		update_block_number();
-
 		if (tftp_state == STATE_SEND_RRQ)
 			debug("Server did not acknowledge timeout option!\n");
 
@@ -540,11 +649,34 @@ static void tftp_handler(uchar *pkt, unsigned dest, struct in_addr sip,
 			}
 		}
 
-		if (tftp_cur_block == tftp_prev_block) {
-			/* Same block again; ignore it. */
+		if (tftp_cur_block != ((tftp_prev_block + 1) & 0xffff)) {
+			if (tftp_cur_block == tftp_prev_block ||
+			    ((tftp_prev_block - tftp_cur_block) & 0xffff) <
+			    tftp_window_size) {
+				/* Same or earlier block again; ignore it. */
+				tftp_stat_dups++;
+				break;
+			}
+
+			/*
+			 * A block in the window went missing. Tell the sender
+			 * once where to restart from; further blocks of the
+			 * same window are dropped until it does.
+			 */
+			tftp_stat_ooo++;
+			debug("Got block %lu, expected %lu\n", tftp_cur_block,
+			      (tftp_prev_block + 1) & 0xffff);
+			if (tftp_last_nack != tftp_prev_block) {
+				tftp_last_nack = tftp_prev_block;
+				tftp_next_ack = (tftp_prev_block +
+						 tftp_window_size) & 0xffff;
+				tftp_send();
+			}
 			break;
 		}
 
+		update_block_number();
+
 		tftp_prev_block = tftp_cur_block;
 		timeout_count_max = tftp_timeout_count_max;
 		net_set_timeout_handler(timeout_ms, tftp_timeout_handler);
@@ -555,14 +687,21 @@ static void tftp_handler(uchar *pkt, unsigned dest, struct in_addr sip,
 			break;
 		}
 
+		if (len < tftp_block_size) {
+			tftp_send();
+			tftp_complete();
+			break;
+		}
+
 		/*
-		 *	Acknowledge the block just received, which will prompt
-		 *	the remote for the next one.
+		 *	Acknowledge the last block of the window, which will
+		 *	prompt the remote for the next window.
 		 */
-		tftp_send();
-
-		if (len < tftp_block_size)
-			tftp_complete();
+		if (tftp_cur_block == tftp_next_ack) {
+			tftp_next_ack = (tftp_cur_block + tftp_window_size) &
+					0xffff;
+			tftp_send();
+		}
 		break;
 
 	case TFTP_ERROR:
@@ -597,6 +736,11 @@ static void tftp_timeout_handler(void)
 		restart("Retry count exceeded");
 	} else {
 		puts("T ");
+		tftp_stat_timeouts++;
+		/* (re)acknowledging resynchronises the window */
+		if (!tftp_put_active)
+			tftp_next_ack = (tftp_prev_block + tftp_window_size) &
+					0xffff;
 		net_set_timeout_handler(timeout_ms, tftp_timeout_handler);
 		if (tftp_state != STATE_RECV_WRQ)
 			tftp_send();
@@ -613,6 +757,7 @@ static int tftp_init_load_addr(void)
 	lmb_init_and_reserve(&lmb, gd->bd, (void *)gd->fdt_blob);
 
 	max_size = lmb_get_free_size(&lmb, image_load_addr);
+	lmb_uninit(&lmb);
 	if (!max_size)
 		return -1;
 
@@ -622,11 +767,30 @@ static int tftp_init_load_addr(void)
 	return 0;
 }
 
+/*
+ * CONFIG_TFTP_BLOCKSIZE, or with jumbo frames the largest block whose
+ * packet fits in a single frame on the current device if that is larger
+ */
+static unsigned short tftp_mtu_block_size(void)
+{
+	int mtu = eth_get_mtu();
+
+	if (mtu <= ETH_DATA_LEN)
+		return CONFIG_TFTP_BLOCKSIZE;
+
+	return max_t(int, mtu - IP_UDP_HDR_SIZE - TFTP_DATA_HDR_SIZE,
+		     CONFIG_TFTP_BLOCKSIZE);
+}
+
 void tftp_start(enum proto_t protocol)
 {
 #if CONFIG_NET_TFTP_VARS
 	char *ep;             /* Environment pointer */
+#endif
+
+	tftp_block_size_option = tftp_mtu_block_size();
 
+#if CONFIG_NET_TFTP_VARS
 	/*
 	 * Allow the user to choose TFTP blocksize and timeout.
 	 * TFTP protocol has a minimal timeout of 1 second.
@@ -636,6 +800,10 @@ void tftp_start(enum proto_t protocol)
 	if (ep != NULL)
 		tftp_block_size_option = simple_strtol(ep, NULL, 10);
 
+	ep = env_get("tftpwindowsize");
+	if (ep != NULL)
+		tftp_window_size_option = simple_strtol(ep, NULL, 10);
+
 	ep = env_get("tftptimeout");
 	if (ep != NULL)
 		timeout_ms = simple_strtol(ep, NULL, 10);
@@ -657,8 +825,8 @@ void tftp_start(enum proto_t protocol)
 	}
 #endif
 
-	debug("TFTP blocksize = %i, timeout = %ld ms\n",
-	      tftp_block_size_option, timeout_ms);
+	debug("TFTP blocksize = %i, windowsize = %i, timeout = %ld ms\n",
+	      tftp_block_size_option, tftp_window_size_option, timeout_ms);
 
 	tftp_remote_ip = net_server_ip;
 	if (!net_parse_bootfile(&tftp_remote_ip, tftp_filename, MAX_LEN)) {
@@ -754,11 +922,16 @@ void tftp_start(enum proto_t protocol)
 		tftp_our_port = simple_strtol(ep, NULL, 10);
 #endif
 	tftp_cur_block = 0;
+	tftp_prev_block = 0;
 
 	/* zero out server ether in case the server ip has changed */
 	memset(net_server_ethaddr, 0, 6);
-	/* Revert tftp_block_size to dflt */
+	/* Revert tftp_block_size and tftp_window_size to dflt */
 	tftp_block_size = TFTP_BLOCK_SIZE;
+	tftp_window_size = 1;
+	tftp_stat_timeouts = 0;
+	tftp_stat_dups = 0;
+	tftp_stat_ooo = 0;
 #ifdef CONFIG_TFTP_TSIZE
 	tftp_tsize = 0;
 	tftp_tsize_num_hash = 0;
@@ -771,6 +944,7 @@ void tftp_start(enum proto_t protocol)
 void tftp_start_server(void)
 {
 	tftp_filename[0] = 0;
+	tftp_block_size_option = tftp_mtu_block_size();
 
 	if (tftp_init_load_addr()) {
 		eth_halt();
@@ -789,9 +963,15 @@ void tftp_start_server(void)
 	timeout_ms = TIMEOUT;
 	net_set_timeout_handler(timeout_ms, tftp_timeout_handler);
 
-	/* Revert tftp_block_size to dflt */
+	/* Revert tftp_block_size and tftp_window_size to dflt */
 	tftp_block_size = TFTP_BLOCK_SIZE;
+	tftp_window_size = 1;
+	tftp_send_oack = 0;
+	tftp_stat_timeouts = 0;
+	tftp_stat_dups = 0;
+	tftp_stat_ooo = 0;
 	tftp_cur_block = 0;
+	tftp_prev_block = 0;
 	tftp_our_port = WELL_KNOWN_PORT;
 
 #ifdef CONFIG_TFTP_TSIZE
@@ -0,0 +1,517 @@
+// SPDX-License-Identifier: GPL-2.0+
+/*
+ * HTTP/1.1 client: GET a file over a TCP connection and store the body in
+ * memory, or on a block device, as it arrives.
+ */
+
+#include <common.h>
+#include <blk.h>
+#include <display_options.h>
+#include <env.h>
+#include <image.h>
+#include <lmb.h>
+#include <log.h>
+#include <malloc.h>
+#include <mapmem.h>
+#include <memalign.h>
+#include <net.h>
+#include <net/tcp.h>
+#include <net/wget.h>
+#include <linux/ctype.h>
+
+DECLARE_GLOBAL_DATA_PTR;
+
+#define HTTP_PORT		80
+/* Largest response header we accept */
+#define WGET_HDR_MAX		4096
+/* Data collected before each write to a block device */
+#define WGET_BLK_BUF_SIZE	(1024 * 1024)
+/* Print a hash mark for each 64KiB received */
+#define HASH_BYTES		(64 * 1024)
+#define HASHES_PER_LINE		65
+
+enum wget_state {
+	WGET_CONNECTING,
+	WGET_HEADER,
+	WGET_BODY,
+	WGET_DONE,
+};
+
+/* Decoder of "Transfer-Encoding: chunked" bodies */
+enum chunk_state {
+	CHUNK_SIZE,		/* hexadecimal chunk size */
+	CHUNK_EXT,		/* chunk extension, ignored */
+	CHUNK_DATA,
+	CHUNK_DATA_END,		/* CRLF after the data */
+	CHUNK_TRAILER,		/* trailer fields up to an empty line */
+};
+
+static enum wget_state wget_state;
+static struct in_addr wget_server_ip;
+static int wget_server_port;
+static char wget_path[1024];
+static char wget_hdr[WGET_HDR_MAX + 1];
+static unsigned int wget_hdr_len;
+static bool wget_chunked;
+static bool wget_has_length;
+static ulong wget_length;	/* Content-Length of the body */
+static ulong wget_received;	/* body bytes stored so far */
+static ulong wget_next_hash;
+static int wget_hashes;
+static ulong wget_time_start;
+
+static enum chunk_state chunk_state;
+static ulong chunk_left;
+static unsigned int chunk_line;	/* characters seen on the current line */
+
+static ulong wget_load_addr;
+static ulong wget_load_size;
+
+static struct blk_desc *wget_blk;
+static lbaint_t wget_blk_start;
+static lbaint_t wget_blk_count;
+static lbaint_t wget_blk_done;	/* blocks written so far */
+static uchar *wget_blk_buf;
+static ulong wget_blk_size;
+static ulong wget_blk_fill;
+
+void wget_set_blk(struct blk_desc *desc, lbaint_t start, lbaint_t count)
+{
+	wget_blk = desc;
+	wget_blk_start = start;
+	wget_blk_count = count;
+}
+
+static void wget_cleanup(void)
+{
+	free(wget_blk_buf);
+	wget_blk_buf = NULL;
+	net_set_timeout_handler(0, NULL);
+}
+
+static void wget_fail(const char *msg)
+{
+	printf("\nwget: %s\n", msg);
+	tcp_abort();
+	wget_state = WGET_DONE;
+	wget_cleanup();
+	net_set_state(NETLOOP_FAIL);
+}
+
+/* Write the buffered data, which is only a partial block at the end */
+static int wget_blk_write(void)
+{
+	ulong blksz = wget_blk->blksz;
+	lbaint_t n = DIV_ROUND_UP(wget_blk_fill, blksz);
+	ulong tail = wget_blk_fill % blksz;
+	lbaint_t blk = wget_blk_start + wget_blk_done;
+
+	if (!wget_blk_fill)
+		return 0;
+	if (wget_blk_done + n > wget_blk_count) {
+		wget_fail("file does not fit on the device");
+		return -ENOSPC;
+	}
+
+	/* keep what follows the file in its last block */
+	if (tail) {
+		uchar *last = wget_blk_buf + (n - 1) * blksz;
+		uchar *old = wget_blk_buf + wget_blk_size;
+
+		if (blk_dread(wget_blk, blk + n - 1, 1, old) != 1) {
+			wget_fail("block device read error");
+			return -EIO;
+		}
+		memcpy(last + tail, old + tail, blksz - tail);
+	}
+
+	if (blk_dwrite(wget_blk, blk, n, wget_blk_buf) != n) {
+		wget_fail("block device write error");
+		return -EIO;
+	}
+	wget_blk_done += n;
+	wget_blk_fill = 0;
+
+	return 0;
+}
+
+static int wget_store(const uchar *data, ulong len)
+{
+	ulong left = len;
+
+	if (wget_blk) {
+		while (left) {
+			ulong n = min(left, wget_blk_size - wget_blk_fill);
+
+			memcpy(wget_blk_buf + wget_blk_fill, data, n);
+			wget_blk_fill += n;
+			data += n;
+			left -= n;
+			if (wget_blk_fill == wget_blk_size && wget_blk_write())
+				return -EIO;
+		}
+	} else {
+		void *ptr;
+
+		if (wget_load_size && wget_received + len > wget_load_size) {
+			wget_fail("trying to overwrite reserved memory...");
+			return -ENOSPC;
+		}
+		ptr = map_sysmem(wget_load_addr + wget_received, len);
+		memcpy(ptr, data, len);
+		unmap_sysmem(ptr);
+	}
+
+	wget_received += len;
+	net_boot_file_size = wget_received;
+	while (wget_received >= wget_next_hash) {
+		putc('#');
+		if (++wget_hashes % HASHES_PER_LINE == 0)
+			puts("\n\t ");
+		wget_next_hash += HASH_BYTES;
+	}
+
+	return 0;
+}
+
+static void wget_done(void)
+{
+	const struct tcp_stats *stats = tcp_get_stats();
+	ulong time;
+
+	if (wget_blk && wget_blk_write())
+		return;
+
+	tcp_close();
+	wget_state = WGET_DONE;
+	wget_cleanup();
+
+	time = get_timer(wget_time_start);
+	if (time > 0) {
+		puts("\n\t ");	/* Line up with "Loading: " */
+		print_size(wget_received / time * 1000, "/s");
+	}
+	if (stats->ooo || stats->retransmits || stats->bad_xsum)
+		printf("\n\t %lu out-of-order, %lu bad checksum segments, %lu retransmissions",
+		       stats->ooo, stats->bad_xsum, stats->retransmits);
+	puts("\ndone\n");
+	net_set_state(NETLOOP_SUCCESS);
+}
+
+/* A line with the size of a chunk or a trailer field ended */
+static void wget_chunk_line_end(void)
+{
+	if (chunk_state == CHUNK_TRAILER) {
+		if (!chunk_line)
+			wget_done();
+	} else if (!chunk_line) {
+		wget_fail("bad chunk size");
+	} else {
+		chunk_state = chunk_left ? CHUNK_DATA : CHUNK_TRAILER;
+	}
+	chunk_line = 0;
+}
+
+static void wget_rx_chunked(const uchar *data, unsigned int len)
+{
+	while (len && wget_state == WGET_BODY) {
+		uchar c = *data;
+
+		if (chunk_state == CHUNK_DATA) {
+			ulong n = min((ulong)len, chunk_left);
+
+			if (wget_store(data, n))
+				return;
+			chunk_left -= n;
+			data += n;
+			len -= n;
+			if (!chunk_left)
+				chunk_state = CHUNK_DATA_END;
+			continue;
+		}
+
+		if (c == '\n') {
+			if (chunk_state == CHUNK_DATA_END) {
+				chunk_state = CHUNK_SIZE;
+				chunk_line = 0;
+			} else {
+				wget_chunk_line_end();
+			}
+		} else if (c == '\r') {
+			/* ignored, lines end with the LF */
+		} else if (chunk_state == CHUNK_SIZE && isxdigit(c)) {
+			if (chunk_left >> (BITS_PER_LONG - 4)) {
+				wget_fail("bad chunk size");
+				return;
+			}
+			chunk_left = chunk_left * 16 +
+				     (isdigit(c) ? c - '0' : tolower(c) - 'a' + 10);
+			chunk_line++;
+		} else if (chunk_state == CHUNK_SIZE) {
+			chunk_state = CHUNK_EXT;
+		} else if (chunk_state == CHUNK_TRAILER) {
+			chunk_line++;
+		} else if (chunk_state == CHUNK_DATA_END) {
+			wget_fail("bad chunk end");
+			return;
+		}
+		data++;
+		len--;
+	}
+}
+
+static void wget_rx_body(const uchar *data, unsigned int len)
+{
+	if (wget_chunked) {
+		wget_rx_chunked(data, len);
+		return;
+	}
+
+	/* anything after the announced length is ignored */
+	if (wget_has_length && len > wget_length - wget_received)
+		len = wget_length - wget_received;
+	if (wget_store(data, len))
+		return;
+	if (wget_has_length && wget_received == wget_length)
+		wget_done();
+}
+
+static const char *wget_header_value(const char *line, const char *name)
+{
+	int len = strlen(name);
+
+	if (strncasecmp(line, name, len) || line[len] != ':')
+		return NULL;
+	for (line += len + 1; *line == ' ' || *line == '\t'; line++)
+		;
+
+	return line;
+}
+
+/* Parse the status line and the header fields we care about */
+static int wget_parse_header(void)
+{
+	char *line, *next;
+	const char *val;
+	int status;
+
+	next = strstr(wget_hdr, "\r\n");
+	*next = '\0';
+	if (strncmp(wget_hdr, "HTTP/1.", 7) || wget_hdr[8] != ' ') {
+		wget_fail("not an HTTP response");
+		return -EPROTO;
+	}
+	status = simple_strtoul(wget_hdr + 9, NULL, 10);
+	if (status != 200) {
+		printf("\nwget: server replied '%s'", wget_hdr + 9);
+		wget_fail("file not loaded");
+		return -ENOENT;
+	}
+
+	for (line = next + 2; *line; line = next + 2) {
+		next = strstr(line, "\r\n");
+		*next = '\0';
+
+		val = wget_header_value(line, "Content-Length");
+		if (val) {
+			wget_length = simple_strtoul(val, NULL, 10);
+			wget_has_length = true;
+		}
+		val = wget_header_value(line, "Transfer-Encoding");
+		if (val && strstr(val, "chunked"))
+			wget_chunked = true;
+	}
+
+	/* the chunks carry their own lengths */
+	if (wget_chunked)
+		wget_has_length = false;
+
+	if (wget_has_length) {
+		printf(" Size is 0x%lx Bytes = ", wget_length);
+		print_size(wget_length, "\n\t ");
+		if (wget_blk && DIV_ROUND_UP(wget_length, wget_blk->blksz) >
+				wget_blk_count) {
+			wget_fail("file does not fit on the device");
+			return -ENOSPC;
+		}
+		if (!wget_blk && wget_load_size &&
+		    wget_length > wget_load_size) {
+			wget_fail("trying to overwrite reserved memory...");
+			return -ENOSPC;
+		}
+	}
+
+	return 0;
+}
+
+static void wget_rx_header(const uchar *data, unsigned int len)
+{
+	unsigned int n = min(len, WGET_HDR_MAX - wget_hdr_len);
+	unsigned int from = wget_hdr_len > 3 ? wget_hdr_len - 3 : 0;
+	unsigned int used;
+	char *end;
+
+	memcpy(wget_hdr + wget_hdr_len, data, n);
+	wget_hdr_len += n;
+	wget_hdr[wget_hdr_len] = '\0';
+
+	end = strstr(wget_hdr + from, "\r\n\r\n");
+	if (!end) {
+		if (wget_hdr_len == WGET_HDR_MAX)
+			wget_fail("response header too large");
+		return;
+	}
+
+	/* bytes of this segment which belong to the header */
+	used = end + 4 - wget_hdr - (wget_hdr_len - n);
+	end[2] = '\0';
+	if (wget_parse_header())
+		return;
+
+	wget_state = WGET_BODY;
+	if (wget_has_length && !wget_length)
+		wget_done();
+	else if (len > used)
+		wget_rx_body(data + used, len - used);
+}
+
+static void wget_send_request(void)
+{
+	char req[TCP_MSS];
+	int len;
+
+	if (wget_server_port == HTTP_PORT)
+		len = snprintf(req, sizeof(req),
+			       "GET %s%s HTTP/1.1\r\nHost: %pI4\r\n",
+			       *wget_path == '/' ? "" : "/", wget_path,
+			       &wget_server_ip);
+	else
+		len = snprintf(req, sizeof(req),
+			       "GET %s%s HTTP/1.1\r\nHost: %pI4:%d\r\n",
+			       *wget_path == '/' ? "" : "/", wget_path,
+			       &wget_server_ip, wget_server_port);
+	len += snprintf(req + len, sizeof(req) - len,
+			"User-Agent: U-Boot\r\nConnection: close\r\n\r\n");
+
+	if (len >= sizeof(req) || tcp_write(req, len)) {
+		wget_fail("request too long");
+		return;
+	}
+	wget_state = WGET_HEADER;
+}
+
+static void wget_handler(enum tcp_event event, const uchar *data,
+			 unsigned int len)
+{
+	if (wget_state == WGET_DONE)
+		return;
+
+	switch (event) {
+	case TCP_EVENT_CONNECTED:
+		wget_send_request();
+		break;
+	case TCP_EVENT_DATA:
+		if (wget_state == WGET_HEADER)
+			wget_rx_header(data, len);
+		else if (wget_state == WGET_BODY)
+			wget_rx_body(data, len);
+		break;
+	case TCP_EVENT_EOF:
+		/* without a length, the end of the connection ends the body */
+		if (wget_state == WGET_BODY && !wget_has_length &&
+		    !wget_chunked)
+			wget_done();
+		else
+			wget_fail("connection closed by the server");
+		break;
+	case TCP_EVENT_RESET:
+		wget_fail("connection reset by the server");
+		break;
+	case TCP_EVENT_TIMEOUT:
+		wget_fail(wget_state == WGET_CONNECTING ?
+			  "no answer from the server" : "timeout");
+		break;
+	}
+}
+
+/* Initialize wget_load_addr and wget_load_size from image_load_addr and lmb */
+static int wget_init_load_addr(void)
+{
+#ifdef CONFIG_LMB
+	struct lmb lmb;
+	phys_size_t max_size;
+
+	lmb_init_and_reserve(&lmb, gd->bd, (void *)gd->fdt_blob);
+
+	max_size = lmb_get_free_size(&lmb, image_load_addr);
+	lmb_uninit(&lmb);
+	if (!max_size)
+		return -1;
+
+	wget_load_size = max_size;
+#endif
+	wget_load_addr = image_load_addr;
+	return 0;
+}
+
+void wget_start(void)
+{
+	char *ep;
+
+	wget_state = WGET_CONNECTING;
+	wget_server_ip = net_server_ip;
+	if (!net_parse_bootfile(&wget_server_ip, wget_path,
+				sizeof(wget_path))) {
+		wget_fail("no file name given");
+		return;
+	}
+
+	wget_server_port = HTTP_PORT;
+	ep = env_get("httpdstp");
+	if (ep)
+		wget_server_port = simple_strtol(ep, NULL, 10);
+
+	printf("Using %s device\n", eth_get_name());
+	printf("HTTP from server %pI4:%d; our IP address is %pI4\n",
+	       &wget_server_ip, wget_server_port, &net_ip);
+	printf("Filename '%s'.\n", wget_path);
+
+	if (wget_blk) {
+		wget_blk_size = WGET_BLK_BUF_SIZE / wget_blk->blksz *
+				wget_blk->blksz;
+		/* one more block to merge a partial last block */
+		wget_blk_buf = memalign(ARCH_DMA_MINALIGN,
+					wget_blk_size + wget_blk->blksz);
+		if (!wget_blk_buf) {
+			wget_fail("out of memory");
+			return;
+		}
+		wget_blk_fill = 0;
+		wget_blk_done = 0;
+		printf("Write to %s %d, block 0x" LBAF "\n",
+		       blk_get_if_type_name(wget_blk->if_type),
+		       wget_blk->devnum, wget_blk_start);
+	} else {
+		wget_load_size = 0;
+		if (wget_init_load_addr()) {
+			wget_fail("trying to overwrite reserved memory...");
+			return;
+		}
+		printf("Load address: 0x%lx\n", wget_load_addr);
+	}
+	puts("Loading: *\b");
+
+	wget_hdr_len = 0;
+	wget_chunked = false;
+	wget_has_length = false;
+	wget_length = 0;
+	wget_received = 0;
+	wget_next_hash = HASH_BYTES;
+	wget_hashes = 0;
+	chunk_state = CHUNK_SIZE;
+	chunk_left = 0;
+	chunk_line = 0;
+	wget_time_start = get_timer(0);
+
+	tcp_connect(wget_server_ip, wget_server_port, wget_handler);
+}
@@ -163,3 +163,63 @@ static int dm_test_blk_get_from_parent(struct unit_test_state *uts)
 	return 0;
 }
 DM_TEST(dm_test_blk_get_from_parent, DM_TESTF_SCAN_PDATA | DM_TESTF_SCAN_FDT);
+
+#if CONFIG_IS_ENABLED(BLOCK_CACHE)
+/* Test block cache readahead and eviction */
+static int dm_test_blk_cache(struct unit_test_state *uts)
+{
+	struct block_cache_stats old, stats;
+	u8 buf[32 * 512], out[512];
+	int i;
+
+	for (i = 0; i < sizeof(buf); i++)
+		buf[i] = i / 512;
+
+	/* 4 KiB holds eight blocks; a size change empties the cache */
+	blkcache_stats(&old);
+	blkcache_configure(8, 0, 32);
+	blkcache_configure(8, 4, 32);
+
+	/* a large read that is not readahead is not cached */
+	blkcache_fill(IF_TYPE_HOST, 7, 100, 16, 512, buf);
+	ut_assert(!blkcache_read(IF_TYPE_HOST, 7, 115, 1, 512, out));
+
+	/* sequential reads grow the readahead window up to the limit */
+	ut_asserteq(1, blkcache_readahead(IF_TYPE_HOST, 7, 0, 1));
+	ut_asserteq(2, blkcache_readahead(IF_TYPE_HOST, 7, 1, 1));
+	ut_asserteq(4, blkcache_readahead(IF_TYPE_HOST, 7, 2, 1));
+	ut_asserteq(8, blkcache_readahead(IF_TYPE_HOST, 7, 3, 1));
+	ut_asserteq(16, blkcache_readahead(IF_TYPE_HOST, 7, 4, 1));
+
+	blkcache_fill(IF_TYPE_HOST, 7, 4, 16, 512, buf);
+
+	/* the window stops growing at the readahead limit */
+	ut_asserteq(32, blkcache_readahead(IF_TYPE_HOST, 7, 5, 1));
+	ut_asserteq(32, blkcache_readahead(IF_TYPE_HOST, 7, 6, 1));
+
+	/*
+	 * The readahead was cached even though it is over the fill limit,
+	 * but only the last eight blocks fit in the budget
+	 */
+	ut_assert(!blkcache_read(IF_TYPE_HOST, 7, 4, 1, 512, out));
+	ut_assert(!blkcache_read(IF_TYPE_HOST, 7, 11, 1, 512, out));
+	ut_assert(blkcache_read(IF_TYPE_HOST, 7, 12, 8, 512, buf));
+	ut_assert(blkcache_read(IF_TYPE_HOST, 7, 19, 1, 512, out));
+	ut_asserteq(15, out[0]);
+
+	blkcache_stats(&stats);
+	ut_asserteq(8, stats.entries);
+	ut_asserteq(8, stats.evictions);
+	ut_asserteq(1 + 3 + 7 + 15 + 31 + 31, stats.readahead);
+
+	blkcache_invalidate(IF_TYPE_HOST, 7);
+	blkcache_stats(&stats);
+	ut_asserteq(0, stats.entries);
+
+	blkcache_configure(old.max_blocks_per_entry, old.size_kb,
+			   old.max_readahead);
+
+	return 0;
+}
+DM_TEST(dm_test_blk_cache, 0);
+#endif
@@ -10,9 +10,12 @@
 #include <dm.h>
 #include <env.h>
 #include <fdtdec.h>
+#include <image.h>
 #include <log.h>
 #include <malloc.h>
+#include <mapmem.h>
 #include <net.h>
+#include <net/tcp.h>
 #include <dm/test.h>
 #include <dm/device-internal.h>
 #include <dm/uclass-internal.h>
@@ -430,3 +433,317 @@ static int dm_test_eth_async_ping_reply(struct unit_test_state *uts)
 }
 
 DM_TEST(dm_test_eth_async_ping_reply, DM_TESTF_SCAN_FDT);
+
+static int sb_batch_tx_count;
+
+static int sb_count_tx_handler(struct udevice *dev, void *packet,
+			       unsigned int len)
+{
+	sb_batch_tx_count++;
+
+	return 0;
+}
+
+/* Send and receive several packets with the batch methods */
+static int dm_test_eth_batch(struct unit_test_state *uts)
+{
+	struct eth_sandbox_priv *priv;
+	struct udevice *dev;
+	uchar frames[3][ETHER_HDR_SIZE];
+	void *packets[3];
+	int lengths[3];
+	int i;
+
+	net_init();
+	env_set("ethact", "eth@10002000");
+	ut_assertok(eth_init());
+	dev = eth_get_dev();
+	priv = dev_get_priv(dev);
+	sandbox_eth_set_tx_handler(0, sb_count_tx_handler);
+
+	sb_batch_tx_count = 0;
+	for (i = 0; i < 3; i++) {
+		memset(frames[i], i, ETHER_HDR_SIZE);
+		packets[i] = frames[i];
+		lengths[i] = ETHER_HDR_SIZE;
+	}
+	ut_asserteq(3, eth_send_batch(packets, lengths, 3));
+	ut_asserteq(3, sb_batch_tx_count);
+
+	/* Each ARP request is answered, then all are given back */
+	net_ip = string_to_ip("1.1.2.2");
+	memcpy(net_ethaddr, eth_get_ethaddr(), ARP_HLEN);
+	sb_batch_tx_count = 0;
+	for (i = 0; i < 3; i++)
+		ut_assertok(sandbox_eth_recv_arp_req(dev));
+	ut_asserteq(3, eth_rx());
+	ut_asserteq(3, sb_batch_tx_count);
+	ut_asserteq(0, priv->recv_packets);
+
+	sandbox_eth_set_tx_handler(0, NULL);
+	eth_halt();
+
+	return 0;
+}
+
+DM_TEST(dm_test_eth_batch, DM_TESTF_SCAN_FDT);
+
+/* Checksums the hardware found correct are not verified again */
+static int dm_test_eth_csum(struct unit_test_state *uts)
+{
+	uchar frame[PKTSIZE_ALIGN] __aligned(PKTALIGN);
+	const int len = ETHER_HDR_SIZE + IP_UDP_HDR_SIZE + 7;
+	struct ethernet_hdr *eth = (void *)frame;
+	struct ip_udp_hdr *ip = (void *)frame + ETHER_HDR_SIZE;
+	struct {
+		struct in_addr src;
+		struct in_addr dest;
+		u8 zero;
+		u8 proto;
+		u16 len;
+	} __attribute__((packed)) ph;
+
+	net_init();
+	net_ip = string_to_ip("1.1.2.2");
+	memset(frame, 0, PKTSIZE_ALIGN);
+	memcpy(eth->et_dest, net_ethaddr, ARP_HLEN);
+	eth->et_protlen = htons(PROT_IP);
+	memcpy((uchar *)ip + IP_UDP_HDR_SIZE, "payload", 7);
+	net_set_udp_header((uchar *)ip, net_ip, 1234, 5678, 7);
+
+	/* an odd-sized datagram with a good checksum */
+	ph.src = net_ip;
+	ph.dest = net_ip;
+	ph.zero = 0;
+	ph.proto = IPPROTO_UDP;
+	ph.len = ip->udp_len;
+	ip->udp_xsum = add_ip_checksums(sizeof(ph),
+					compute_ip_checksum(&ph, sizeof(ph)),
+					compute_ip_checksum(&ip->udp_src,
+							    UDP_HDR_SIZE + 7));
+	memset(&net_csum_stats, 0, sizeof(net_csum_stats));
+	net_process_received_csum(frame, len, 0);
+	ut_asserteq(0, net_csum_stats.udp);
+
+	ip->udp_xsum ^= htons(0x5555);
+	net_process_received_csum(frame, len, 0);
+	ut_asserteq(1, net_csum_stats.udp);
+	net_process_received_csum(frame, len, ETH_CSUM_L4);
+	ut_asserteq(1, net_csum_stats.udp);
+
+	/* what the hardware finds bad is checked again */
+	net_process_received_csum(frame, len, ETH_CSUM_BAD | ETH_CSUM_L4);
+	ut_asserteq(1, net_csum_stats.hw);
+	ut_asserteq(2, net_csum_stats.udp);
+
+	ip->ip_sum ^= htons(0x5555);
+	net_process_received_csum(frame, len, ETH_CSUM_L4);
+	ut_asserteq(1, net_csum_stats.ip);
+	net_process_received_csum(frame, len, ETH_CSUM_IP | ETH_CSUM_L4);
+	ut_asserteq(1, net_csum_stats.ip);
+	ut_asserteq(2, net_csum_stats.udp);
+
+	return 0;
+}
+
+DM_TEST(dm_test_eth_csum, 0);
+
+/* The MTU follows the device, up to what the stack is built for */
+static int dm_test_eth_mtu(struct unit_test_state *uts)
+{
+	struct eth_pdata *pdata;
+
+	net_init();
+	env_set("ethact", "eth@10002000");
+	ut_assertok(eth_init());
+	pdata = dev_get_platdata(eth_get_dev());
+
+	ut_asserteq(min(ETH_DATA_LEN, NET_MTU), eth_get_mtu());
+	pdata->max_mtu = 9000;
+	ut_asserteq(NET_MTU, eth_get_mtu());
+	pdata->max_mtu = 576;
+	ut_asserteq(576, eth_get_mtu());
+	pdata->max_mtu = 0;
+
+	eth_halt();
+
+	return 0;
+}
+
+DM_TEST(dm_test_eth_mtu, DM_TESTF_SCAN_FDT);
+
+#if IS_ENABLED(CONFIG_CMD_WGET)
+#define SB_HTTP_PORT	80
+#define SB_HTTP_SEG	1000
+#define SB_HTTP_BODY	5000
+
+/* Fake HTTP server which sends its response from each ACK of the client */
+static struct {
+	u16 port;		/* client port */
+	u32 iss;		/* our initial sequence number */
+	u32 rcv_nxt;		/* next sequence number expected from the client */
+	bool request;		/* the GET request was received */
+	bool swapped;		/* a pair of segments was sent out of order */
+	char resp[SB_HTTP_BODY + 64];
+	int resp_len;
+} sb_http;
+
+static void sb_http_send(struct udevice *dev, struct ethernet_hdr *eth_req,
+			 u8 flags, u32 seq, const void *data, int len)
+{
+	struct eth_sandbox_priv *priv = dev_get_priv(dev);
+	struct ethernet_hdr *eth;
+	struct ip_tcp_hdr *tcp;
+	struct {
+		struct in_addr src;
+		struct in_addr dest;
+		u8 zero;
+		u8 proto;
+		u16 len;
+	} __attribute__((packed)) ph;
+
+	/* Like a full link, drop what does not fit */
+	if (priv->recv_packets >= PKTBUFSRX)
+		return;
+
+	eth = (void *)priv->recv_packet_buffer[priv->recv_packets];
+	memcpy(eth->et_dest, eth_req->et_src, ARP_HLEN);
+	memcpy(eth->et_src, priv->fake_host_hwaddr, ARP_HLEN);
+	eth->et_protlen = htons(PROT_IP);
+
+	tcp = (void *)eth + ETHER_HDR_SIZE;
+	net_set_ip_header((uchar *)tcp, net_ip, priv->fake_host_ipaddr,
+			  IP_TCP_HDR_SIZE + len, IPPROTO_TCP);
+	tcp->tcp_src = htons(SB_HTTP_PORT);
+	tcp->tcp_dst = htons(sb_http.port);
+	tcp->tcp_seq = htonl(seq);
+	tcp->tcp_ack = htonl(sb_http.rcv_nxt);
+	tcp->tcp_hlen = (TCP_HDR_SIZE / 4) << 4;
+	tcp->tcp_flags = flags;
+	tcp->tcp_win = htons(0xffff);
+	tcp->tcp_urg = 0;
+	tcp->tcp_xsum = 0;
+	memcpy(tcp + 1, data, len);
+
+	ph.src = priv->fake_host_ipaddr;
+	ph.dest = net_ip;
+	ph.zero = 0;
+	ph.proto = IPPROTO_TCP;
+	ph.len = htons(TCP_HDR_SIZE + len);
+	tcp->tcp_xsum = add_ip_checksums(sizeof(ph),
+					 compute_ip_checksum(&ph, sizeof(ph)),
+					 compute_ip_checksum(&tcp->tcp_src,
+							     TCP_HDR_SIZE + len));
+
+	priv->recv_packet_length[priv->recv_packets++] =
+		ETHER_HDR_SIZE + IP_TCP_HDR_SIZE + len;
+}
+
+/* Send the next two segments of the response, the first pair swapped */
+static void sb_http_send_from(struct udevice *dev, struct ethernet_hdr *eth,
+			      u32 ack)
+{
+	int off[2], len[2], n, i;
+
+	for (n = 0, i = ack - (sb_http.iss + 1);
+	     n < 2 && i < sb_http.resp_len; n++, i += SB_HTTP_SEG) {
+		off[n] = i;
+		len[n] = min(SB_HTTP_SEG, sb_http.resp_len - i);
+	}
+
+	if (n == 2 && !sb_http.swapped) {
+		sb_http.swapped = true;
+		for (i = 1; i >= 0; i--)
+			sb_http_send(dev, eth, TCP_ACK, sb_http.iss + 1 + off[i],
+				     sb_http.resp + off[i], len[i]);
+		return;
+	}
+	for (i = 0; i < n; i++)
+		sb_http_send(dev, eth, TCP_ACK, sb_http.iss + 1 + off[i],
+			     sb_http.resp + off[i], len[i]);
+}
+
+static int sb_http_handler(struct udevice *dev, void *packet,
+			   unsigned int len)
+{
+	struct eth_sandbox_priv *priv = dev_get_priv(dev);
+	struct unit_test_state *uts = priv->priv;
+	struct ethernet_hdr *eth = packet;
+	struct ip_tcp_hdr *tcp = packet + ETHER_HDR_SIZE;
+	unsigned int hlen, dlen;
+	char *data;
+	u32 seq;
+
+	if (!sandbox_eth_arp_req_to_reply(dev, packet, len))
+		return 0;
+	if (ntohs(eth->et_protlen) != PROT_IP || tcp->ip_p != IPPROTO_TCP)
+		return 0;
+
+	ut_asserteq(SB_HTTP_PORT, ntohs(tcp->tcp_dst));
+	seq = ntohl(tcp->tcp_seq);
+	hlen = (tcp->tcp_hlen >> 4) * 4;
+	dlen = ntohs(tcp->ip_len) - IP_HDR_SIZE - hlen;
+	data = (void *)tcp + IP_HDR_SIZE + hlen;
+
+	if (tcp->tcp_flags & TCP_SYN) {
+		sb_http.port = ntohs(tcp->tcp_src);
+		sb_http.rcv_nxt = seq + 1;
+		sb_http_send(dev, eth, TCP_SYN | TCP_ACK, sb_http.iss, NULL, 0);
+		return 0;
+	}
+	if (tcp->tcp_flags & (TCP_FIN | TCP_RST))
+		return 0;
+
+	if (dlen) {
+		ut_assert(!strncmp(data, "GET /file HTTP/1.1\r\n", 20));
+		sb_http.rcv_nxt = seq + dlen;
+		sb_http.request = true;
+	}
+	if (sb_http.request)
+		sb_http_send_from(dev, eth, ntohl(tcp->tcp_ack));
+
+	return 0;
+}
+
+static int dm_test_eth_wget(struct unit_test_state *uts)
+{
+	ulong addr = image_load_addr;
+	const u8 *buf;
+	int hdr, i;
+
+	hdr = sprintf(sb_http.resp,
+		      "HTTP/1.1 200 OK\r\nContent-Length: %d\r\n\r\n",
+		      SB_HTTP_BODY);
+	for (i = 0; i < SB_HTTP_BODY; i++)
+		sb_http.resp[hdr + i] = i * 7;
+	sb_http.resp_len = hdr + SB_HTTP_BODY;
+	sb_http.iss = 0xfffffc00;	/* wraps around during the transfer */
+	sb_http.request = false;
+	sb_http.swapped = false;
+
+	sandbox_eth_set_tx_handler(0, sb_http_handler);
+	/* Used by all of the ut_assert macros in the tx_handler */
+	sandbox_eth_set_priv(0, uts);
+
+	env_set("ethact", "eth@10002000");
+	net_server_ip = string_to_ip("1.1.2.2");
+	strcpy(net_boot_file_name, "/file");
+	image_load_addr = 0x1000000;
+	ut_asserteq(SB_HTTP_BODY, net_loop(WGET));
+
+	buf = map_sysmem(image_load_addr, SB_HTTP_BODY);
+	for (i = 0; i < SB_HTTP_BODY; i++)
+		ut_asserteq((u8)(i * 7), buf[i]);
+	unmap_sysmem(buf);
+	/* the swapped segment was dropped and sent again */
+	ut_assert(tcp_get_stats()->ooo > 0);
+	ut_asserteq(0, tcp_get_stats()->bad_xsum);
+
+	image_load_addr = addr;
+	sandbox_eth_set_tx_handler(0, NULL);
+
+	return 0;
+}
+
+DM_TEST(dm_test_eth_wget, DM_TESTF_SCAN_FDT);
+#endif
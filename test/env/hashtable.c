@@ -124,3 +124,106 @@ static int env_test_htab_deletes(struct unit_test_state *uts)
 }
 
 ENV_TEST(env_test_htab_deletes, 0);
+
+/* Fill the hashtable far beyond its initial size */
+static int env_test_htab_grow(struct unit_test_state *uts)
+{
+	struct hsearch_data htab;
+	char key[20];
+	int i;
+
+	memset(&htab, 0, sizeof(htab));
+	ut_asserteq(1, hcreate_r(SIZE, &htab));
+
+	ut_assertok(htab_fill(uts, &htab, ITERATIONS / 4));
+	ut_asserteq(ITERATIONS / 4, htab.filled);
+	ut_assert(htab.size * 3 >= htab.filled * 4);
+	ut_assertok(htab_check_fill(uts, &htab, ITERATIONS / 4));
+
+	for (i = SIZE; i < ITERATIONS / 4; i++) {
+		sprintf(key, "%d", i);
+		ut_asserteq(1, hdelete_r(key, &htab, 0));
+	}
+	ut_asserteq(SIZE, htab.filled);
+	ut_assertok(htab_check_fill(uts, &htab, SIZE));
+
+	hdestroy_r(&htab);
+	return 0;
+}
+
+ENV_TEST(env_test_htab_grow, 0);
+
+/* Check that export is sorted whatever the order of insertion */
+static int env_test_htab_export(struct unit_test_state *uts)
+{
+	static const char * const keys[] = {
+		"fdt_addr", "arch", "bootcmd", "zz", "a", "bootargs", "b",
+	};
+	struct hsearch_data htab;
+	struct env_entry item, *ritem;
+	char *res = NULL;
+	int i;
+
+	memset(&htab, 0, sizeof(htab));
+	ut_asserteq(1, hcreate_r(SIZE, &htab));
+
+	item.callback = NULL;
+	item.flags = 0;
+	for (i = 0; i < ARRAY_SIZE(keys); i++) {
+		item.key = keys[i];
+		item.data = (char *)keys[i];
+		ut_asserteq(1, hsearch_r(item, ENV_ENTER, &ritem, &htab, 0));
+	}
+	ut_asserteq(1, hdelete_r("bootcmd", &htab, 0));
+	item.key = "c";
+	item.data = "x\ny";
+	ut_asserteq(1, hsearch_r(item, ENV_ENTER, &ritem, &htab, 0));
+
+	ut_assert(hexport_r(&htab, '\n', 0, &res, 0, 0, NULL) > 0);
+	ut_asserteq_str("a=a\narch=arch\nb=b\nbootargs=bootargs\nc=x\\\ny\n"
+			"fdt_addr=fdt_addr\nzz=zz\n", res);
+	free(res);
+
+	hdestroy_r(&htab);
+	return 0;
+}
+
+ENV_TEST(env_test_htab_export, 0);
+
+/* Import without modifying the input, then export it again */
+static int env_test_htab_import(struct unit_test_state *uts)
+{
+	static const char env[] = "a=1\0b=x\\\\y\0c=\0d=4\0e=55";
+	static const char text[] = "# comment\n  f=6\ng=multi\\\nline\nd\n";
+	char copy[sizeof(env)];
+	struct hsearch_data htab;
+	struct env_entry item, *ritem;
+	char *res = NULL;
+
+	memset(&htab, 0, sizeof(htab));
+	memcpy(copy, env, sizeof(env));
+	ut_asserteq(1, himport_r(&htab, env, sizeof(env) - 1, '\0', 0, 0, 0,
+				 NULL));
+	ut_assertok(memcmp(copy, env, sizeof(env)));
+	ut_asserteq(4, htab.filled);
+
+	item.key = "b";
+	hsearch_r(item, ENV_FIND, &ritem, &htab, 0);
+	ut_assertnonnull(ritem);
+	ut_asserteq_str("x\\y", ritem->data);
+	item.key = "e";
+	hsearch_r(item, ENV_FIND, &ritem, &htab, 0);
+	ut_assertnonnull(ritem);
+	ut_asserteq_str("55", ritem->data);
+
+	ut_asserteq(1, himport_r(&htab, text, sizeof(text) - 1, '\n',
+				 H_NOCLEAR, 0, 0, NULL));
+	ut_assert(hexport_r(&htab, '\n', 0, &res, 0, 0, NULL) > 0);
+	ut_asserteq_str("a=1\nb=x\\\\y\ne=55\nf=6\ng=multi\\\nline\n", res);
+	free(res);
+
+	hdestroy_r(&htab);
+	return 0;
+}
+
+ENV_TEST(env_test_htab_import, 0);
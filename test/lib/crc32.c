@@ -0,0 +1,59 @@
+// SPDX-License-Identifier: GPL-2.0+
+/*
+ * Unit tests for crc32()
+ *
+ * crc32() takes different paths depending on the alignment and length of
+ * the buffer (and on the CPU, see CONFIG_CRC32_ARMV8), so check it against
+ * a bit-at-a-time reference for all alignments and a range of lengths.
+ */
+
+#include <common.h>
+#include <test/lib.h>
+#include <test/test.h>
+#include <test/ut.h>
+#include <u-boot/crc.h>
+
+#define BUFLEN	1100
+
+static u32 crc32_ref(u32 crc, const u8 *buf, int len)
+{
+	int i;
+
+	crc = ~crc;
+	while (len--) {
+		crc ^= *buf++;
+		for (i = 0; i < 8; i++)
+			crc = (crc >> 1) ^ (crc & 1 ? 0xedb88320 : 0);
+	}
+
+	return ~crc;
+}
+
+static int lib_test_crc32(struct unit_test_state *uts)
+{
+	static const int lens[] = { 0, 1, 3, 4, 7, 8, 9, 15, 16, 31, 32, 33,
+				    63, 64, 65, 1024 };
+	u8 buf[BUFLEN];
+	int i, off;
+
+	for (i = 0; i < BUFLEN; i++)
+		buf[i] = (i * 2654435761U) >> 24;
+
+	/* the check value of the CRC-32 */
+	ut_asserteq(0xcbf43926, crc32(0, (const u8 *)"123456789", 9));
+
+	for (off = 0; off < 8; off++) {
+		for (i = 0; i < ARRAY_SIZE(lens); i++) {
+			ut_asserteq(crc32_ref(0, buf + off, lens[i]),
+				    crc32(0, buf + off, lens[i]));
+		}
+	}
+
+	/* chaining must give the same result as a single call */
+	ut_asserteq(crc32_ref(0, buf, BUFLEN),
+		    crc32(crc32(0, buf, 13), buf + 13, BUFLEN - 13));
+
+	return 0;
+}
+
+LIB_TEST(lib_test_crc32, 0);
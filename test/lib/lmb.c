@@ -657,3 +657,108 @@ static int lib_test_lmb_get_free_size(struct unit_test_state *uts)
 
 DM_TEST(lib_test_lmb_get_free_size,
 	DM_TESTF_SCAN_PDATA | DM_TESTF_SCAN_FDT);
+
+/*
+ * Reserve many more regions than fit in struct lmb, in scattered order, then
+ * fill the gaps between them by allocating and free parts again.
+ */
+static int test_many_regions(struct unit_test_state *uts,
+			     const phys_addr_t ram)
+{
+	const phys_size_t ram_size = 0x20000000;
+	const unsigned long num = 1000;
+	const phys_size_t stride = 0x10000;
+	const phys_size_t rsv_size = 0x1000;
+	const phys_addr_t top = ram + num * stride;
+	struct lmb lmb;
+	unsigned long i, j;
+	phys_addr_t a;
+	long ret;
+
+	lmb_init(&lmb);
+	ret = lmb_add(&lmb, ram, ram_size);
+	ut_asserteq(ret, 0);
+
+	/* 7 and 1000 are coprime, so this visits every slot once */
+	for (i = 0, j = 0; i < num; i++, j = (j + 7) % num) {
+		ret = lmb_reserve(&lmb, ram + j * stride, rsv_size);
+		ut_asserteq(ret, 0);
+	}
+	ut_asserteq(lmb.reserved.cnt, num);
+	ut_assert(lmb.reserved.max >= num);
+	for (i = 0; i < num; i++) {
+		ut_asserteq(lmb.reserved.region[i].base, ram + i * stride);
+		ut_asserteq(lmb.reserved.region[i].size, rsv_size);
+	}
+
+	/* overlapping and duplicate reservations */
+	ret = lmb_reserve(&lmb, ram + 500 * stride + 0x800, rsv_size);
+	ut_asserteq(ret, -1);
+	ret = lmb_reserve(&lmb, ram + 500 * stride - 0x800, rsv_size);
+	ut_asserteq(ret, -1);
+	ret = lmb_reserve(&lmb, ram + 500 * stride, rsv_size);
+	ut_asserteq(ret, 0);
+	ut_asserteq(lmb.reserved.cnt, num);
+
+	ut_asserteq(lmb_is_reserved(&lmb, ram + 123 * stride), 1);
+	ut_asserteq(lmb_is_reserved(&lmb, ram + 123 * stride + rsv_size - 1), 1);
+	ut_asserteq(lmb_is_reserved(&lmb, ram + 123 * stride + rsv_size), 0);
+	ut_asserteq(lmb_is_reserved(&lmb, ram + 124 * stride - 1), 0);
+	ut_asserteq(lmb_get_free_size(&lmb, ram + 123 * stride + rsv_size),
+		    stride - rsv_size);
+	ut_asserteq(lmb_get_free_size(&lmb, ram + 123 * stride + 0x800), 0);
+	ut_asserteq(lmb_get_free_size(&lmb, top - 4),
+		    ram + ram_size - top + 4);
+
+	/* no 0x2000-aligned gap below top can hold 0x10000 bytes */
+	a = __lmb_alloc_base(&lmb, stride, 0x2000, top);
+	ut_asserteq(a, 0);
+
+	/* each allocation fills the highest gap below top */
+	for (i = num; i > 0; i--) {
+		a = lmb_alloc_base(&lmb, stride - rsv_size, rsv_size, top);
+		ut_asserteq(a, ram + (i - 1) * stride + rsv_size);
+		ut_asserteq(lmb.reserved.cnt, i == num ? num : i);
+	}
+	ASSERT_LMB(&lmb, ram, ram_size, 1, ram, num * stride, 0, 0, 0, 0);
+	a = __lmb_alloc_base(&lmb, rsv_size, rsv_size, top);
+	ut_asserteq(a, 0);
+
+	/* punch holes again, splitting the single region */
+	for (i = 0; i < num; i++) {
+		ret = lmb_free(&lmb, ram + i * stride + rsv_size,
+			       stride - rsv_size);
+		ut_asserteq(ret, 0);
+	}
+	ut_asserteq(lmb.reserved.cnt, num);
+	ret = lmb_free(&lmb, ram + 10 * stride + rsv_size, rsv_size);
+	ut_asserteq(ret, -1);
+
+	/* unaligned allocations at the bottom of a 0x100-byte gap each */
+	for (i = 0; i < num; i++) {
+		a = lmb_alloc_addr(&lmb, ram + i * stride + rsv_size, 0x100);
+		ut_asserteq(a, ram + i * stride + rsv_size);
+	}
+	ut_asserteq(lmb.reserved.cnt, num);
+	ut_asserteq(lmb.reserved.region[num - 1].size, rsv_size + 0x100);
+
+	lmb_uninit(&lmb);
+
+	return 0;
+}
+
+static int lib_test_lmb_many_regions(struct unit_test_state *uts)
+{
+	int ret;
+
+	/* simulate 512 MiB RAM beginning at 1GiB */
+	ret = test_many_regions(uts, 0x40000000);
+	if (ret)
+		return ret;
+
+	/* simulate 512 MiB RAM beginning at 1.5GiB */
+	return test_many_regions(uts, 0xE0000000);
+}
+
+DM_TEST(lib_test_lmb_many_regions,
+	DM_TESTF_SCAN_PDATA | DM_TESTF_SCAN_FDT);
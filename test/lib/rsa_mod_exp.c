@@ -0,0 +1,352 @@
+// SPDX-License-Identifier: GPL-2.0+
+/*
+ * Unit test for the software RSA modular exponentiation
+ *
+ * The results are compared against values computed independently (with
+ * Python's pow()), covering the usual public exponent 65537, the smallest
+ * allowed exponent and a large one that goes through the sliding-window
+ * code. The 2080-bit modulus is not a multiple of 64 bits, which exercises
+ * the padding needed when working on 64-bit limbs.
+ */
+
+#include <common.h>
+#include <test/lib.h>
+#include <test/test.h>
+#include <test/ut.h>
+#include <u-boot/rsa.h>
+#include <u-boot/rsa-mod-exp.h>
+
+/* 2048-bit modulus, n0inv = 0xa1086fb1 */
+
+static const u8 rsa2048_modulus[] __aligned(4) = {
+	0xab, 0xc4, 0x9f, 0xfb, 0xb0, 0x60, 0x8f, 0xcf, 0x1a, 0x32, 0x86, 0xc5,
+	0x8e, 0x6d, 0xfd, 0x71, 0x13, 0xc8, 0xb5, 0xdd, 0xd2, 0x3f, 0x52, 0x9b,
+	0x00, 0x16, 0xb6, 0xec, 0x7c, 0x34, 0xde, 0xa2, 0xaf, 0xda, 0x79, 0x4b,
+	0xe7, 0xd2, 0xb1, 0xa0, 0xae, 0x7f, 0x4d, 0x8a, 0x18, 0xaf, 0xea, 0xb0,
+	0xbc, 0x24, 0x8d, 0x29, 0xe1, 0x66, 0xae, 0x45, 0x10, 0x19, 0xc4, 0x30,
+	0x80, 0x59, 0x03, 0xbb, 0x8c, 0x29, 0x2a, 0x31, 0xe0, 0x2e, 0x33, 0x77,
+	0x36, 0x4b, 0x3f, 0x95, 0xd1, 0x93, 0x35, 0x12, 0xc0, 0xb2, 0xeb, 0xc7,
+	0x9b, 0x5d, 0xe5, 0xe8, 0x38, 0xe1, 0xf5, 0x90, 0xed, 0x88, 0x6e, 0x9e,
+	0xc9, 0xe9, 0xc8, 0x9d, 0x96, 0xb1, 0x1a, 0xef, 0x13, 0x73, 0x98, 0x77,
+	0x1c, 0x65, 0x57, 0xe6, 0xa3, 0xe8, 0x5c, 0xc2, 0xe5, 0xc9, 0xf1, 0x06,
+	0x20, 0x55, 0x5e, 0x7d, 0xcc, 0x32, 0xbf, 0x8b, 0xdd, 0x56, 0x00, 0xca,
+	0x3d, 0x55, 0x0f, 0x38, 0x0c, 0x91, 0xc8, 0x43, 0xec, 0x32, 0x7e, 0x9c,
+	0x82, 0x0e, 0x81, 0x5b, 0x8a, 0x28, 0x44, 0x8e, 0xbb, 0x4e, 0x15, 0x2c,
+	0x2f, 0x89, 0xa2, 0xad, 0xec, 0xb1, 0x48, 0x8c, 0xd9, 0xcf, 0x7d, 0x3c,
+	0xfb, 0x5f, 0xdd, 0x8e, 0x93, 0x65, 0x33, 0x9d, 0x41, 0x90, 0x2d, 0x77,
+	0x45, 0xcb, 0xf5, 0x1e, 0x9e, 0x11, 0x65, 0xc6, 0x0e, 0x56, 0xec, 0xf8,
+	0xe0, 0x42, 0xd3, 0x2c, 0x38, 0x86, 0xb7, 0x77, 0xd5, 0x3c, 0x68, 0xdb,
+	0x1d, 0x96, 0x9e, 0x0e, 0xca, 0x8b, 0x43, 0x82, 0x8b, 0x86, 0x39, 0x16,
+	0xf3, 0xcb, 0x00, 0x26, 0x80, 0x98, 0x6d, 0xe3, 0x75, 0x13, 0xbd, 0xa5,
+	0xdd, 0x0f, 0xc8, 0xa0, 0x10, 0x53, 0x38, 0x3a, 0xc7, 0xec, 0x2c, 0x92,
+	0x54, 0x57, 0xda, 0x22, 0x33, 0x6d, 0xa9, 0xd8, 0xc8, 0x76, 0x4d, 0x7e,
+	0xdb, 0x55, 0x86, 0xaf,
+};
+
+static const u8 rsa2048_rr[] __aligned(4) = {
+	0x4d, 0xfb, 0x39, 0x9c, 0xe3, 0x29, 0xa7, 0x23, 0x46, 0x49, 0x2f, 0x47,
+	0xee, 0x0e, 0xd4, 0xb7, 0x4e, 0xa1, 0xa0, 0x26, 0xbe, 0x95, 0x00, 0x35,
+	0x1f, 0x48, 0xa0, 0x69, 0xde, 0x9c, 0xb0, 0xff, 0xee, 0xd9, 0x96, 0x3d,
+	0x49, 0xf6, 0xa3, 0x66, 0x30, 0xdc, 0x83, 0xa8, 0x17, 0x42, 0x2c, 0x7c,
+	0x9e, 0x87, 0xb0, 0xfc, 0x09, 0xb0, 0x16, 0x59, 0xc1, 0xff, 0x72, 0x2b,
+	0xd7, 0x2e, 0x62, 0xa9, 0x69, 0x79, 0x3e, 0x86, 0x61, 0x9f, 0x79, 0xfc,
+	0xa2, 0xb2, 0xdb, 0xd7, 0xeb, 0x25, 0x5a, 0x82, 0xfe, 0xeb, 0x94, 0x01,
+	0x0a, 0xe3, 0xcd, 0x8d, 0x6d, 0xe1, 0x45, 0x06, 0xe2, 0x29, 0xd0, 0x54,
+	0xc1, 0xa8, 0xa9, 0x9f, 0x29, 0x6d, 0x5f, 0x83, 0x2e, 0x0d, 0x12, 0x49,
+	0xd9, 0x18, 0x4f, 0x63, 0x7e, 0x1a, 0xff, 0x2a, 0x31, 0x56, 0x29, 0x69,
+	0xed, 0x79, 0x7b, 0x77, 0xad, 0xad, 0x3c, 0x3f, 0x62, 0xf4, 0x34, 0x2f,
+	0xe8, 0xa5, 0x44, 0x85, 0x87, 0xc6, 0xd8, 0xc9, 0x17, 0x0b, 0x7e, 0x4e,
+	0xe5, 0x4e, 0xf5, 0x64, 0x96, 0xe5, 0xc9, 0x18, 0x01, 0x38, 0x9b, 0x2f,
+	0x6d, 0x9f, 0x94, 0xd5, 0x14, 0x73, 0x0e, 0x83, 0x58, 0x6e, 0x7e, 0x9d,
+	0x2e, 0xcf, 0xb8, 0xa7, 0x1f, 0x37, 0xa6, 0xbb, 0xd6, 0x0f, 0x6c, 0x8f,
+	0xf6, 0x79, 0xf8, 0x57, 0x0a, 0x50, 0x0a, 0xae, 0x65, 0x9d, 0x01, 0x76,
+	0xfd, 0xdf, 0xf0, 0x47, 0x37, 0xc4, 0x67, 0x46, 0x76, 0x45, 0xe4, 0xfb,
+	0x34, 0xdc, 0x12, 0xff, 0xe7, 0xd1, 0x7f, 0x64, 0xcb, 0x93, 0x48, 0x4a,
+	0x04, 0x75, 0xe9, 0xbb, 0xfa, 0x3d, 0x2d, 0xc1, 0xbe, 0xf8, 0xab, 0xec,
+	0x13, 0x97, 0x99, 0x64, 0x6e, 0xb5, 0x98, 0x85, 0xa2, 0x6c, 0x7b, 0x7a,
+	0xf7, 0x1b, 0xad, 0xa0, 0xe3, 0x4b, 0x48, 0x21, 0xba, 0xb6, 0xf2, 0xab,
+	0x02, 0x65, 0xf9, 0x56,
+};
+
+/* pattern ^ 65537 mod rsa2048_modulus */
+
+static const u8 rsa2048_exp65537[] __aligned(4) = {
+	0x2b, 0x38, 0x30, 0x48, 0x17, 0x31, 0xd4, 0xca, 0xfa, 0xdb, 0xcc, 0x0d,
+	0xb1, 0x4b, 0x1e, 0xee, 0xe1, 0xd5, 0xbe, 0x7e, 0xb0, 0x6d, 0x16, 0x01,
+	0x97, 0x78, 0x84, 0x4a, 0xd7, 0x97, 0x33, 0x04, 0x0b, 0x16, 0xd2, 0xdc,
+	0x84, 0x34, 0x3c, 0xa4, 0x4c, 0x74, 0x11, 0x72, 0x81, 0x56, 0x3d, 0x0a,
+	0x5d, 0xb5, 0xc2, 0x06, 0x1b, 0x2c, 0x88, 0x8a, 0xc1, 0xba, 0x44, 0x7d,
+	0x41, 0xce, 0x6f, 0x75, 0x1a, 0x22, 0xf5, 0x26, 0xd2, 0x97, 0x67, 0xf2,
+	0xf0, 0xc0, 0xc3, 0xc6, 0x45, 0xca, 0x66, 0x69, 0x79, 0x11, 0xd8, 0xb8,
+	0x8d, 0x6d, 0xc6, 0x8d, 0xe7, 0xa3, 0x7a, 0xfc, 0x1f, 0xb3, 0x8c, 0xdb,
+	0x79, 0xb0, 0x4e, 0x69, 0x61, 0x5a, 0xe0, 0xd1, 0xd8, 0x2e, 0x96, 0x1d,
+	0xa8, 0x6d, 0x86, 0x19, 0x87, 0x49, 0x03, 0x05, 0x1a, 0xfb, 0x5e, 0x19,
+	0x39, 0x41, 0x68, 0x00, 0x6b, 0x99, 0x03, 0x63, 0x05, 0xe6, 0x8f, 0xe5,
+	0x58, 0x82, 0xc9, 0xff, 0x27, 0x5f, 0x5c, 0xba, 0x89, 0x69, 0x05, 0xb5,
+	0x2f, 0xb1, 0x60, 0x06, 0x1c, 0xa9, 0x6d, 0x61, 0x57, 0xbb, 0x39, 0xab,
+	0x19, 0x74, 0xe9, 0x33, 0x61, 0x72, 0x88, 0x1f, 0xe6, 0x9c, 0x30, 0x3b,
+	0x9b, 0xa3, 0xd6, 0x2d, 0x34, 0x93, 0x60, 0xed, 0xbb, 0xcf, 0x71, 0xbe,
+	0x08, 0x4c, 0x5f, 0xdd, 0x2f, 0x23, 0x5a, 0x1e, 0x2a, 0x4b, 0xb0, 0x40,
+	0xaf, 0x3c, 0x65, 0x48, 0xdd, 0xf3, 0x18, 0x69, 0x09, 0x61, 0xa5, 0x7b,
+	0x53, 0xeb, 0x88, 0x47, 0x61, 0xda, 0xcd, 0x91, 0x65, 0x81, 0x3f, 0x68,
+	0xde, 0xea, 0x76, 0x7c, 0xec, 0x3b, 0x56, 0xcc, 0xb9, 0xca, 0x19, 0xaf,
+	0xdd, 0xc1, 0xf6, 0x86, 0x18, 0xdc, 0x52, 0x11, 0x7f, 0x50, 0x8b, 0x9b,
+	0x76, 0x05, 0x27, 0xe6, 0x6b, 0x51, 0x9a, 0x69, 0x84, 0x2a, 0x60, 0x42,
+	0x4f, 0xf2, 0x8d, 0xf2,
+};
+
+/* pattern ^ 3 mod rsa2048_modulus */
+
+static const u8 rsa2048_exp3[] __aligned(4) = {
+	0x97, 0xcb, 0xa4, 0x4e, 0x68, 0x26, 0x88, 0x87, 0xfd, 0x6c, 0x6a, 0xd8,
+	0xd9, 0x16, 0x01, 0x7f, 0x7c, 0x51, 0xc8, 0x70, 0xb8, 0x9a, 0x34, 0xa0,
+	0x78, 0x5b, 0x66, 0x59, 0xa9, 0xf5, 0xdd, 0x69, 0x50, 0xe9, 0xf7, 0x98,
+	0xd9, 0x01, 0x13, 0xf6, 0x2c, 0x8a, 0xe5, 0x5c, 0xb3, 0x7f, 0x25, 0x03,
+	0x5d, 0x23, 0x3e, 0xe2, 0x43, 0x77, 0xbd, 0xa7, 0xfa, 0x27, 0x29, 0x1d,
+	0x48, 0x5d, 0xd8, 0xae, 0x89, 0x2e, 0x6b, 0x3f, 0x64, 0xbb, 0xaf, 0xc1,
+	0x54, 0xc6, 0x2e, 0xa8, 0x04, 0xf4, 0x96, 0x97, 0xc2, 0x81, 0xee, 0x4a,
+	0xc6, 0x99, 0x4a, 0x98, 0xd7, 0xe3, 0x1a, 0x4a, 0x0a, 0xc5, 0xbc, 0xc5,
+	0x04, 0x69, 0xb2, 0x68, 0x27, 0x0f, 0xc5, 0xb2, 0x53, 0x89, 0x47, 0x00,
+	0x5d, 0xc4, 0x68, 0x18, 0x6e, 0x3c, 0x53, 0x53, 0xb5, 0xb0, 0xaf, 0x7d,
+	0x3f, 0x59, 0x27, 0xbe, 0xd8, 0x92, 0x84, 0x0a, 0xca, 0xc4, 0x01, 0xfe,
+	0x03, 0x76, 0x1f, 0x3d, 0x1a, 0x17, 0xe7, 0x34, 0x49, 0xd0, 0x2e, 0x78,
+	0x36, 0xb9, 0xc4, 0x1b, 0x1e, 0xd7, 0x72, 0x97, 0xf3, 0x8a, 0xd5, 0x1e,
+	0xa8, 0xd1, 0xa9, 0xab, 0x6a, 0x49, 0xbd, 0x41, 0x37, 0xa0, 0x74, 0xa2,
+	0xb3, 0x49, 0xe8, 0x65, 0x27, 0x01, 0x9e, 0xb3, 0xf8, 0xdc, 0x64, 0xfc,
+	0xab, 0x3a, 0x02, 0xcd, 0x4a, 0x2c, 0xab, 0xeb, 0x1a, 0xae, 0xf6, 0x64,
+	0x61, 0x79, 0x8f, 0x4f, 0xb3, 0xc4, 0x4c, 0x48, 0xc2, 0x33, 0x75, 0x95,
+	0x45, 0x3b, 0xb4, 0x38, 0x0a, 0xc8, 0x4b, 0x2b, 0x55, 0x1a, 0x4d, 0x85,
+	0x27, 0xfb, 0xca, 0xc1, 0x7c, 0x7b, 0xb0, 0x9d, 0xa1, 0x35, 0x20, 0x9a,
+	0xde, 0xab, 0x53, 0x0b, 0x72, 0x8b, 0x54, 0xc7, 0x97, 0x38, 0xdf, 0xb0,
+	0xda, 0xcf, 0xbd, 0x2a, 0x6e, 0x04, 0xed, 0xd1, 0xc5, 0x15, 0x82, 0xf7,
+	0xc9, 0xb6, 0x1d, 0xda,
+};
+
+/* pattern ^ 0xc0ffee1234567891 mod rsa2048_modulus */
+
+static const u8 rsa2048_expbig[] __aligned(4) = {
+	0x0f, 0x84, 0xfc, 0x20, 0xb8, 0x25, 0xa2, 0x29, 0x18, 0xec, 0xcc, 0x3c,
+	0x35, 0x2f, 0xc2, 0x15, 0x92, 0x43, 0xbc, 0x57, 0x0a, 0xaa, 0x32, 0xed,
+	0x0e, 0xe3, 0x9c, 0xdc, 0x3e, 0xe6, 0xe5, 0x9f, 0xcd, 0x0c, 0xcd, 0x36,
+	0xd7, 0x59, 0xc6, 0x6c, 0xa9, 0xe5, 0x32, 0xcb, 0xed, 0xb0, 0xf0, 0x26,
+	0x04, 0xeb, 0x70, 0x74, 0x76, 0x1a, 0xe5, 0x53, 0x92, 0x8f, 0x1e, 0x23,
+	0xb9, 0x5f, 0xd7, 0x8a, 0xb2, 0x54, 0x1a, 0x9e, 0x10, 0x2f, 0x37, 0xd3,
+	0x14, 0x45, 0x81, 0x20, 0x87, 0xa5, 0x60, 0x64, 0xc1, 0x2b, 0x88, 0x07,
+	0x9e, 0xd2, 0xe8, 0x35, 0xe6, 0x4e, 0xda, 0x64, 0x4a, 0xef, 0xea, 0x5e,
+	0x58, 0xb3, 0xbc, 0x70, 0xdd, 0x82, 0x94, 0x44, 0xfd, 0xfa, 0x2a, 0x58,
+	0x83, 0xcb, 0xc7, 0xbe, 0xf5, 0x47, 0x54, 0x96, 0x36, 0x93, 0xd7, 0xc3,
+	0xa0, 0xd7, 0xbb, 0xc3, 0xac, 0x3d, 0x31, 0x48, 0x55, 0x9b, 0xde, 0xf2,
+	0x18, 0x49, 0x41, 0x68, 0x9f, 0x9a, 0xab, 0x90, 0xed, 0xe0, 0xc1, 0x90,
+	0x63, 0x50, 0x80, 0x61, 0x09, 0x64, 0x32, 0x35, 0xe0, 0x6a, 0x57, 0x43,
+	0xfe, 0xd0, 0x3d, 0x1e, 0x19, 0x20, 0xdf, 0x52, 0xce, 0xc0, 0xac, 0x47,
+	0xa4, 0x53, 0xb2, 0xbb, 0xd7, 0xe4, 0x51, 0xf2, 0xd5, 0x27, 0x8f, 0x5b,
+	0x66, 0x77, 0xf7, 0xbc, 0xb4, 0x74, 0x4e, 0x5e, 0x10, 0x05, 0x77, 0x6f,
+	0x26, 0x29, 0x91, 0xf5, 0x94, 0xa4, 0xaf, 0xea, 0x5e, 0x8f, 0xdf, 0xd8,
+	0x88, 0xd6, 0xe5, 0x4d, 0xc1, 0xea, 0xdf, 0xa3, 0x10, 0x9c, 0x0b, 0x0c,
+	0x9b, 0x6c, 0x6d, 0x18, 0xc7, 0x99, 0x0f, 0xe3, 0x6a, 0x40, 0xb8, 0x5d,
+	0x53, 0x26, 0x43, 0x39, 0x7e, 0xd8, 0x4e, 0x9c, 0xb1, 0x58, 0x38, 0xb9,
+	0xc2, 0xd0, 0x1a, 0xe0, 0x1d, 0xa4, 0xb5, 0x12, 0x6d, 0xb5, 0xfd, 0x67,
+	0xfa, 0x28, 0xa7, 0xa5,
+};
+
+/* 2080-bit modulus, n0inv = 0x56a4615b */
+
+static const u8 rsa2080_modulus[] __aligned(4) = {
+	0xb4, 0x3a, 0xdd, 0x0e, 0x72, 0x4e, 0xd4, 0xc3, 0xb4, 0x19, 0xe8, 0x2a,
+	0x5f, 0xb6, 0x57, 0xdd, 0x5f, 0xcf, 0x63, 0x7e, 0x02, 0x04, 0xfd, 0x88,
+	0xe4, 0xfc, 0x8f, 0xdf, 0x09, 0xa7, 0x0a, 0x6b, 0x33, 0x6c, 0xa2, 0x11,
+	0xe5, 0x70, 0x60, 0x03, 0x67, 0x90, 0x44, 0x03, 0x4e, 0x47, 0x6c, 0x0a,
+	0x1e, 0x37, 0x5f, 0x9d, 0x86, 0x14, 0xd7, 0x41, 0x22, 0x3f, 0x14, 0x51,
+	0x05, 0x9c, 0x57, 0xf8, 0xfc, 0x22, 0x1a, 0x97, 0xbb, 0xa1, 0xb2, 0xa9,
+	0x32, 0x90, 0xde, 0xd0, 0x33, 0x24, 0xc3, 0xeb, 0xd3, 0x75, 0xbc, 0x4a,
+	0xad, 0x62, 0xc4, 0xf8, 0x92, 0x75, 0xe8, 0x2b, 0x7f, 0x20, 0x3c, 0x37,
+	0xf2, 0x8a, 0x07, 0x59, 0xb7, 0x96, 0xe3, 0x59, 0xbf, 0xb0, 0x42, 0xf2,
+	0x07, 0xaa, 0x70, 0x81, 0x32, 0x96, 0x04, 0x10, 0x84, 0xe6, 0x03, 0xf2,
+	0x6e, 0x40, 0x2f, 0xfb, 0xf5, 0x41, 0x04, 0x00, 0xde, 0x60, 0xa8, 0xa9,
+	0xd7, 0xb5, 0x99, 0xdc, 0x83, 0x33, 0x25, 0xe5, 0x7d, 0xb7, 0x2a, 0x3f,
+	0x79, 0x3a, 0x92, 0x53, 0xbf, 0xb1, 0xda, 0x07, 0xfc, 0xc3, 0xa2, 0x42,
+	0xe7, 0x8a, 0x9b, 0xc3, 0x3a, 0x74, 0xeb, 0x91, 0x84, 0x9c, 0xd1, 0x65,
+	0x75, 0xad, 0xdd, 0x99, 0xc5, 0xfa, 0xa4, 0x7a, 0xb5, 0x5c, 0xae, 0xcb,
+	0x14, 0x40, 0xaf, 0x79, 0x0e, 0xd3, 0x16, 0x0d, 0x90, 0x88, 0x8c, 0x08,
+	0x18, 0xe9, 0x6c, 0x55, 0x4b, 0x5f, 0xf9, 0xe5, 0xe6, 0xfc, 0x1c, 0x13,
+	0x1d, 0x7b, 0xac, 0x5b, 0xb6, 0x77, 0xbe, 0x97, 0xf5, 0xd1, 0x40, 0x2d,
+	0x8c, 0x35, 0xe4, 0x68, 0x56, 0x53, 0x0a, 0xa4, 0x08, 0x3e, 0xfb, 0x59,
+	0xd2, 0x99, 0x63, 0x01, 0x91, 0x6e, 0xc3, 0xea, 0x0a, 0xf0, 0xe9, 0xe6,
+	0xec, 0x36, 0x2a, 0xbf, 0x95, 0x3e, 0xc5, 0xf8, 0xa0, 0x22, 0x8d, 0xf8,
+	0x17, 0x35, 0xad, 0x5d, 0xc9, 0x1b, 0x19, 0x2d,
+};
+
+static const u8 rsa2080_rr[] __aligned(4) = {
+	0x47, 0xeb, 0x44, 0x08, 0xf7, 0xdf, 0x16, 0x23, 0xcb, 0xd8, 0xdd, 0x7f,
+	0x8f, 0xad, 0x37, 0xf6, 0xc0, 0x39, 0x1f, 0x14, 0xbb, 0x41, 0x6f, 0x47,
+	0xc6, 0x20, 0x8b, 0xc4, 0x14, 0x1d, 0x70, 0x42, 0xae, 0x43, 0x84, 0x94,
+	0x0d, 0x04, 0xd1, 0x36, 0xf2, 0xdf, 0x0c, 0x4c, 0x91, 0xdc, 0x37, 0x02,
+	0xc3, 0x5f, 0xe0, 0x5b, 0x34, 0x9e, 0x91, 0xeb, 0x3c, 0xd9, 0xfd, 0x9a,
+	0x1c, 0x71, 0x42, 0xb2, 0x38, 0x6f, 0x94, 0x1d, 0x75, 0xf0, 0x6a, 0x8e,
+	0xcb, 0x5e, 0xef, 0x93, 0x4b, 0xed, 0x4d, 0x03, 0x25, 0x89, 0x33, 0x7d,
+	0x96, 0x51, 0x8e, 0xe8, 0x01, 0xff, 0x84, 0x07, 0x35, 0x30, 0xdf, 0xee,
+	0x97, 0xbc, 0xeb, 0xb8, 0x6f, 0x08, 0xb7, 0xe5, 0x52, 0xc5, 0x9e, 0xe5,
+	0xc4, 0x30, 0x72, 0xc9, 0x17, 0x5b, 0xee, 0x0a, 0x43, 0x54, 0x84, 0x67,
+	0x4a, 0xba, 0xe0, 0xee, 0x85, 0x70, 0xcc, 0xbc, 0xd0, 0x94, 0xee, 0x24,
+	0xd0, 0xdf, 0x12, 0xec, 0xdc, 0xce, 0x84, 0x14, 0xda, 0x09, 0xe6, 0x13,
+	0x82, 0x22, 0x7a, 0xf8, 0x63, 0x3d, 0xee, 0xd7, 0x82, 0x97, 0xe7, 0xfc,
+	0x42, 0x01, 0x49, 0x48, 0x41, 0x8b, 0x0f, 0x42, 0x42, 0x51, 0xac, 0x78,
+	0x26, 0x3a, 0x17, 0xb6, 0x43, 0x1e, 0x05, 0xe3, 0xd8, 0x60, 0xd4, 0x8c,
+	0x5c, 0x7d, 0xee, 0x69, 0x9d, 0x9d, 0xca, 0x84, 0xd7, 0x91, 0xd6, 0x81,
+	0x46, 0xe0, 0x08, 0xcf, 0xdb, 0xe6, 0x84, 0xb3, 0x04, 0xfa, 0x91, 0xc8,
+	0xd8, 0xac, 0x82, 0xf5, 0xd6, 0x8b, 0x8e, 0xa0, 0x7c, 0x4a, 0xc7, 0xa1,
+	0xbc, 0x9f, 0x8e, 0x2c, 0xae, 0xf9, 0x8a, 0xc4, 0x30, 0xf7, 0xa3, 0x63,
+	0xfe, 0xb1, 0x77, 0x9a, 0xbc, 0x69, 0x74, 0x94, 0x08, 0xbb, 0xd6, 0x53,
+	0xdd, 0x0c, 0xb3, 0xaf, 0x00, 0x49, 0xc1, 0x1b, 0x7a, 0xa4, 0xec, 0x4c,
+	0xa5, 0x4c, 0x65, 0x9f, 0x72, 0x1b, 0x39, 0xb2,
+};
+
+/* pattern ^ 65537 mod rsa2080_modulus */
+
+static const u8 rsa2080_exp65537[] __aligned(4) = {
+	0x2c, 0x2c, 0x94, 0x82, 0x2f, 0xf7, 0x4f, 0x2b, 0xe3, 0x6c, 0x41, 0x29,
+	0x73, 0x90, 0xb5, 0x2b, 0xab, 0x2d, 0xfa, 0xc7, 0xdb, 0x21, 0x60, 0x79,
+	0xd7, 0x79, 0x2e, 0x20, 0x30, 0x10, 0xd4, 0x6f, 0x00, 0x57, 0x36, 0x42,
+	0x21, 0xd1, 0xc9, 0x87, 0x7c, 0x46, 0xd0, 0x0e, 0x7e, 0xd4, 0x69, 0x2c,
+	0xad, 0xfe, 0xf1, 0xfd, 0x96, 0x7c, 0x0b, 0xed, 0x00, 0x56, 0x96, 0x3d,
+	0x84, 0x15, 0x89, 0x9b, 0x68, 0x6a, 0xc3, 0x8a, 0xe8, 0x34, 0xa9, 0x6c,
+	0xff, 0xa2, 0x0e, 0x8b, 0xe4, 0x22, 0x96, 0x17, 0x04, 0x97, 0xe0, 0xfe,
+	0xe8, 0x78, 0xb9, 0x37, 0x2d, 0xf0, 0xe5, 0xf0, 0x69, 0xcf, 0x37, 0x18,
+	0x76, 0x6c, 0x0f, 0xbf, 0x17, 0x0a, 0x80, 0xbc, 0xa1, 0xde, 0x12, 0xc3,
+	0x2c, 0x0d, 0xd5, 0x82, 0x34, 0x99, 0x26, 0xc7, 0x98, 0xa8, 0x6e, 0x24,
+	0xf3, 0x12, 0xc6, 0xe1, 0x46, 0x45, 0x7c, 0xd2, 0x31, 0xa4, 0xa1, 0x5d,
+	0x13, 0xec, 0xa3, 0x43, 0x3c, 0x4f, 0xb6, 0xa3, 0xdc, 0x6c, 0xcf, 0x74,
+	0x51, 0x20, 0x5a, 0xe0, 0x9d, 0x49, 0x06, 0x86, 0xb5, 0x28, 0xce, 0xe7,
+	0x85, 0x6f, 0xfa, 0xfc, 0x10, 0xaa, 0xbc, 0xe3, 0x7f, 0x03, 0x6f, 0x4a,
+	0x06, 0x10, 0xb0, 0xdd, 0x44, 0xe1, 0x2b, 0x4d, 0xec, 0x8f, 0xe0, 0x13,
+	0xe4, 0x1e, 0x68, 0x17, 0xf8, 0x78, 0x47, 0x2b, 0x32, 0xd1, 0x5e, 0xdd,
+	0xb3, 0x0a, 0x0f, 0xfb, 0x6b, 0x03, 0x4a, 0x4c, 0xcc, 0xe2, 0x82, 0xfc,
+	0xf6, 0x5c, 0xdd, 0x16, 0xa9, 0xa9, 0x0a, 0xa7, 0x74, 0x7e, 0x18, 0x21,
+	0x86, 0x26, 0x27, 0x31, 0x14, 0x69, 0xaf, 0x65, 0x7c, 0xc8, 0x30, 0x76,
+	0x7a, 0x64, 0x3f, 0xed, 0x68, 0xac, 0x54, 0x16, 0xf3, 0x25, 0xeb, 0xd6,
+	0xc8, 0x94, 0x2b, 0x0b, 0xaa, 0x50, 0xd7, 0x8c, 0x55, 0x20, 0xde, 0x3f,
+	0xb0, 0xbf, 0x00, 0xa9, 0xf0, 0x74, 0xa9, 0xc2,
+};
+
+/* pattern ^ 3 mod rsa2080_modulus */
+
+static const u8 rsa2080_exp3[] __aligned(4) = {
+	0xa0, 0x76, 0xdc, 0xc8, 0xee, 0x2c, 0x17, 0x7e, 0x73, 0x11, 0x24, 0xb9,
+	0x5e, 0x69, 0x14, 0x6d, 0x4f, 0xaa, 0x78, 0x26, 0x43, 0x41, 0xee, 0x42,
+	0xed, 0x74, 0x11, 0x75, 0x77, 0x17, 0xcf, 0x3a, 0xa7, 0x8e, 0x9c, 0x3e,
+	0xf7, 0xcd, 0x7a, 0xb5, 0x22, 0xa5, 0x06, 0x5c, 0xfb, 0xe7, 0x1c, 0xae,
+	0xbb, 0x7f, 0xf5, 0x18, 0x9f, 0x93, 0x2d, 0xb4, 0xeb, 0xb4, 0xbd, 0x39,
+	0x3e, 0xde, 0xea, 0x65, 0xeb, 0x28, 0x1e, 0xd0, 0xb7, 0xbd, 0x5d, 0xc7,
+	0x26, 0xf9, 0xef, 0x34, 0xd6, 0x40, 0x56, 0x42, 0x02, 0xc1, 0x02, 0xc0,
+	0xc9, 0x84, 0x19, 0xc5, 0xce, 0x90, 0x17, 0xaa, 0xbd, 0xe7, 0xad, 0x91,
+	0x4a, 0x9e, 0x70, 0x3f, 0x9b, 0xd3, 0x7c, 0x63, 0x32, 0xb2, 0x67, 0x47,
+	0xb7, 0x86, 0x03, 0x97, 0x6c, 0xce, 0xdd, 0xbb, 0xd6, 0x9b, 0xea, 0x3b,
+	0x34, 0xc9, 0x0a, 0x75, 0x35, 0x7a, 0xfb, 0xac, 0x9c, 0x1c, 0xb9, 0x4f,
+	0x32, 0xe3, 0xfb, 0x8d, 0x45, 0x67, 0x76, 0xa8, 0x04, 0x76, 0x97, 0xf3,
+	0xfd, 0x71, 0x89, 0x01, 0xe0, 0x70, 0xcc, 0xf5, 0xa7, 0xc1, 0x70, 0xfc,
+	0xce, 0xde, 0xc6, 0xc2, 0x17, 0x92, 0xa2, 0x42, 0x73, 0x25, 0x20, 0x94,
+	0x40, 0x42, 0x1a, 0x84, 0xdd, 0x3b, 0x50, 0x14, 0x31, 0xc5, 0x34, 0x4e,
+	0x6f, 0xea, 0x07, 0xc4, 0x9a, 0xab, 0xb6, 0xcf, 0x87, 0xb7, 0x0d, 0xfa,
+	0xd3, 0xff, 0x7c, 0x28, 0x44, 0x5b, 0x09, 0xf9, 0x87, 0x80, 0xba, 0xad,
+	0xb0, 0xab, 0xe2, 0xe2, 0xec, 0x58, 0x12, 0x2e, 0x39, 0x3e, 0x86, 0x9c,
+	0x58, 0x4e, 0x0b, 0x3c, 0x12, 0x9e, 0x7d, 0x43, 0x55, 0xd1, 0x27, 0x25,
+	0xf6, 0xb4, 0xa8, 0xa0, 0x91, 0xe9, 0x8d, 0x02, 0x8f, 0x9a, 0x19, 0xb4,
+	0xcc, 0x9e, 0x11, 0x17, 0xb5, 0x88, 0xcd, 0x12, 0xeb, 0x4d, 0x55, 0x54,
+	0xbd, 0xcf, 0x0d, 0x77, 0x41, 0xca, 0xb0, 0x68,
+};
+
+/* pattern ^ 0xc0ffee1234567891 mod rsa2080_modulus */
+
+static const u8 rsa2080_expbig[] __aligned(4) = {
+	0xab, 0x64, 0x2e, 0x4c, 0xce, 0x9f, 0xbe, 0xc6, 0xde, 0x48, 0x3e, 0x6e,
+	0xaf, 0xcd, 0xb0, 0xa8, 0x93, 0xd9, 0x6f, 0xa5, 0x4c, 0x9c, 0x61, 0x03,
+	0x3c, 0x7b, 0x85, 0x10, 0x63, 0x42, 0x8f, 0xc3, 0x9a, 0x59, 0x80, 0x23,
+	0xba, 0xb2, 0x61, 0x8c, 0x39, 0xbb, 0x3a, 0xca, 0xd5, 0x7d, 0x85, 0xfd,
+	0xf3, 0x07, 0xe1, 0xe1, 0xaa, 0xa9, 0x8b, 0xb2, 0x9a, 0x1c, 0x71, 0xe0,
+	0x63, 0xd4, 0x43, 0x60, 0xbf, 0x7f, 0x89, 0x10, 0x6f, 0xc3, 0x30, 0xf0,
+	0x28, 0x2c, 0xf2, 0x6b, 0xe1, 0xcb, 0x06, 0xda, 0x70, 0xd2, 0x3a, 0x5f,
+	0x9f, 0x2f, 0x26, 0xbb, 0x90, 0x78, 0xb6, 0x74, 0x12, 0x19, 0x43, 0xeb,
+	0x4c, 0xcd, 0xc6, 0xa6, 0x86, 0x46, 0x14, 0x5e, 0x7b, 0xba, 0x44, 0xe8,
+	0x38, 0xb3, 0x35, 0xc1, 0xc0, 0xd7, 0xaa, 0xf4, 0xdb, 0xad, 0x81, 0x6c,
+	0xee, 0xa1, 0xc4, 0x0e, 0x32, 0xcf, 0x6b, 0x8d, 0x0f, 0x2e, 0x07, 0xa5,
+	0xd0, 0xd9, 0x65, 0x60, 0x87, 0xac, 0xca, 0x97, 0x26, 0x1b, 0x1c, 0x58,
+	0x9e, 0xa7, 0xe9, 0xac, 0xe7, 0x24, 0x08, 0xe2, 0x0d, 0x1a, 0x08, 0x33,
+	0x00, 0x95, 0xcf, 0x37, 0xfc, 0x56, 0x05, 0x31, 0xcb, 0x62, 0x0a, 0x47,
+	0x81, 0x84, 0x41, 0x51, 0xe9, 0xc5, 0x2c, 0x8d, 0x88, 0x83, 0x9c, 0x78,
+	0x45, 0xa4, 0xcb, 0xbb, 0x01, 0x0a, 0x48, 0x1a, 0x0e, 0xb1, 0xf0, 0xd7,
+	0x0d, 0x1b, 0x8c, 0x5f, 0x4d, 0x9a, 0x18, 0xcb, 0x22, 0x19, 0x0b, 0xa0,
+	0x9c, 0x8e, 0x95, 0x5d, 0x63, 0xaa, 0x9d, 0xd9, 0x97, 0x36, 0x88, 0x7e,
+	0xad, 0x8b, 0x4e, 0x70, 0x30, 0x17, 0xd0, 0x8f, 0x9f, 0x0e, 0xde, 0xdc,
+	0x24, 0x84, 0x9e, 0x20, 0x4e, 0x64, 0x86, 0xca, 0xf5, 0x14, 0xa3, 0xe8,
+	0x21, 0x28, 0x44, 0xea, 0xf7, 0x9b, 0xd6, 0xd0, 0xf2, 0x9a, 0x46, 0x47,
+	0x62, 0x11, 0x64, 0x65, 0xf9, 0xc2, 0xc1, 0x69,
+};
+
+struct rsa_mod_exp_vector {
+	int bits;
+	u32 n0inv;
+	u64 exponent;
+	const u8 *modulus;
+	const u8 *rr;
+	const u8 *expected;
+};
+
+static const struct rsa_mod_exp_vector rsa_mod_exp_vectors[] = {
+	{ 2048, 0xa1086fb1, 65537, rsa2048_modulus, rsa2048_rr,
+	  rsa2048_exp65537 },
+	{ 2048, 0xa1086fb1, 3, rsa2048_modulus, rsa2048_rr, rsa2048_exp3 },
+	{ 2048, 0xa1086fb1, 0xc0ffee1234567891ULL, rsa2048_modulus, rsa2048_rr,
+	  rsa2048_expbig },
+	{ 2080, 0x56a4615b, 65537, rsa2080_modulus, rsa2080_rr,
+	  rsa2080_exp65537 },
+	{ 2080, 0x56a4615b, 3, rsa2080_modulus, rsa2080_rr, rsa2080_exp3 },
+	{ 2080, 0x56a4615b, 0xc0ffee1234567891ULL, rsa2080_modulus, rsa2080_rr,
+	  rsa2080_expbig },
+};
+
+/**
+ * lib_rsa_mod_exp() - unit test for rsa_mod_exp_sw()
+ *
+ * Raise a fixed pattern to the power of each vector's exponent. Every
+ * vector is run twice so that the second pass uses the key parameters
+ * remembered from the first one.
+ *
+ * @uts:	unit test state
+ * Return:	0 = success, 1 = failure
+ */
+static int lib_rsa_mod_exp(struct unit_test_state *uts)
+{
+	const struct rsa_mod_exp_vector *vec;
+	u8 sig[RSA_MAX_KEY_BITS / 8], out[RSA_MAX_KEY_BITS / 8];
+	struct key_prop prop;
+	fdt64_t exponent;
+	int pass, i, j, len;
+
+	for (pass = 0; pass < 2; pass++) {
+		for (i = 0; i < ARRAY_SIZE(rsa_mod_exp_vectors); i++) {
+			vec = &rsa_mod_exp_vectors[i];
+			len = vec->bits / 8;
+
+			/* leading zero byte keeps the value below the modulus */
+			sig[0] = 0;
+			for (j = 1; j < len; j++)
+				sig[j] = j * 37 + 11;
+
+			exponent = cpu_to_fdt64(vec->exponent);
+			memset(&prop, '\0', sizeof(prop));
+			prop.modulus = vec->modulus;
+			prop.rr = vec->rr;
+			prop.n0inv = vec->n0inv;
+			prop.num_bits = vec->bits;
+			prop.public_exponent = &exponent;
+			prop.exp_len = sizeof(exponent);
+
+			ut_assertok(rsa_mod_exp_sw(sig, len, &prop, out));
+			ut_asserteq_mem(vec->expected, out, len);
+		}
+	}
+
+	return 0;
+}
+
+LIB_TEST(lib_rsa_mod_exp, 0);
@@ -0,0 +1,453 @@
+// SPDX-License-Identifier: GPL-2.0+
+/*
+ * Unit tests for the SHA-1, SHA-2 and BLAKE2b implementations
+ *
+ * The digests are checked against fixed reference values, so the same tests
+ * cover both the generic C code and the ARMv8 Crypto Extensions code
+ * (CONFIG_SHA_ARMV8_CE), whichever one the CPU ends up using. With the
+ * Crypto Extensions the two are also checked against each other on random
+ * data.
+ */
+
+#include <common.h>
+#include <malloc.h>
+#include <rand.h>
+#include <test/lib.h>
+#include <test/test.h>
+#include <test/ut.h>
+#include <u-boot/sha1.h>
+#include <u-boot/sha256.h>
+#include <u-boot/sha512.h>
+#include <u-boot/blake2b.h>
+#ifdef CONFIG_SHA_ARMV8_CE
+#include <asm/armv8/sha_ce.h>
+#endif
+
+/* Length of the generated test pattern, not a multiple of the block size */
+#define PATTERN_LEN	8195
+#define MILLION		1000000
+/* Watchdog chunk size for the one-shot functions */
+#define SHA_TEST_WD_CHUNK	4096
+
+struct sha_test_vector {
+	const char *data;	/* NULL for the generated pattern */
+	int len;
+	u8 sha1[SHA1_SUM_LEN];
+	u8 sha256[SHA256_SUM_LEN];
+	u8 sha384[SHA384_SUM_LEN];
+	u8 sha512[SHA512_SUM_LEN];
+	u8 blake2b[BLAKE2B_SUM_LEN];
+};
+
+static const struct sha_test_vector sha_test_vectors[] = {
+	{
+		"", 0,
+		{ 0xda, 0x39, 0xa3, 0xee, 0x5e, 0x6b, 0x4b, 0x0d, 0x32, 0x55,
+		  0xbf, 0xef, 0x95, 0x60, 0x18, 0x90, 0xaf, 0xd8, 0x07, 0x09 },
+		{ 0xe3, 0xb0, 0xc4, 0x42, 0x98, 0xfc, 0x1c, 0x14, 0x9a, 0xfb,
+		  0xf4, 0xc8, 0x99, 0x6f, 0xb9, 0x24, 0x27, 0xae, 0x41, 0xe4,
+		  0x64, 0x9b, 0x93, 0x4c, 0xa4, 0x95, 0x99, 0x1b, 0x78, 0x52,
+		  0xb8, 0x55 },
+		{ 0x38, 0xb0, 0x60, 0xa7, 0x51, 0xac, 0x96, 0x38, 0x4c, 0xd9,
+		  0x32, 0x7e, 0xb1, 0xb1, 0xe3, 0x6a, 0x21, 0xfd, 0xb7, 0x11,
+		  0x14, 0xbe, 0x07, 0x43, 0x4c, 0x0c, 0xc7, 0xbf, 0x63, 0xf6,
+		  0xe1, 0xda, 0x27, 0x4e, 0xde, 0xbf, 0xe7, 0x6f, 0x65, 0xfb,
+		  0xd5, 0x1a, 0xd2, 0xf1, 0x48, 0x98, 0xb9, 0x5b },
+		{ 0xcf, 0x83, 0xe1, 0x35, 0x7e, 0xef, 0xb8, 0xbd, 0xf1, 0x54,
+		  0x28, 0x50, 0xd6, 0x6d, 0x80, 0x07, 0xd6, 0x20, 0xe4, 0x05,
+		  0x0b, 0x57, 0x15, 0xdc, 0x83, 0xf4, 0xa9, 0x21, 0xd3, 0x6c,
+		  0xe9, 0xce, 0x47, 0xd0, 0xd1, 0x3c, 0x5d, 0x85, 0xf2, 0xb0,
+		  0xff, 0x83, 0x18, 0xd2, 0x87, 0x7e, 0xec, 0x2f, 0x63, 0xb9,
+		  0x31, 0xbd, 0x47, 0x41, 0x7a, 0x81, 0xa5, 0x38, 0x32, 0x7a,
+		  0xf9, 0x27, 0xda, 0x3e },
+		{ 0x78, 0x6a, 0x02, 0xf7, 0x42, 0x01, 0x59, 0x03, 0xc6, 0xc6,
+		  0xfd, 0x85, 0x25, 0x52, 0xd2, 0x72, 0x91, 0x2f, 0x47, 0x40,
+		  0xe1, 0x58, 0x47, 0x61, 0x8a, 0x86, 0xe2, 0x17, 0xf7, 0x1f,
+		  0x54, 0x19, 0xd2, 0x5e, 0x10, 0x31, 0xaf, 0xee, 0x58, 0x53,
+		  0x13, 0x89, 0x64, 0x44, 0x93, 0x4e, 0xb0, 0x4b, 0x90, 0x3a,
+		  0x68, 0x5b, 0x14, 0x48, 0xb7, 0x55, 0xd5, 0x6f, 0x70, 0x1a,
+		  0xfe, 0x9b, 0xe2, 0xce },
+	},
+	{
+		"abc", 3,
+		{ 0xa9, 0x99, 0x3e, 0x36, 0x47, 0x06, 0x81, 0x6a, 0xba, 0x3e,
+		  0x25, 0x71, 0x78, 0x50, 0xc2, 0x6c, 0x9c, 0xd0, 0xd8, 0x9d },
+		{ 0xba, 0x78, 0x16, 0xbf, 0x8f, 0x01, 0xcf, 0xea, 0x41, 0x41,
+		  0x40, 0xde, 0x5d, 0xae, 0x22, 0x23, 0xb0, 0x03, 0x61, 0xa3,
+		  0x96, 0x17, 0x7a, 0x9c, 0xb4, 0x10, 0xff, 0x61, 0xf2, 0x00,
+		  0x15, 0xad },
+		{ 0xcb, 0x00, 0x75, 0x3f, 0x45, 0xa3, 0x5e, 0x8b, 0xb5, 0xa0,
+		  0x3d, 0x69, 0x9a, 0xc6, 0x50, 0x07, 0x27, 0x2c, 0x32, 0xab,
+		  0x0e, 0xde, 0xd1, 0x63, 0x1a, 0x8b, 0x60, 0x5a, 0x43, 0xff,
+		  0x5b, 0xed, 0x80, 0x86, 0x07, 0x2b, 0xa1, 0xe7, 0xcc, 0x23,
+		  0x58, 0xba, 0xec, 0xa1, 0x34, 0xc8, 0x25, 0xa7 },
+		{ 0xdd, 0xaf, 0x35, 0xa1, 0x93, 0x61, 0x7a, 0xba, 0xcc, 0x41,
+		  0x73, 0x49, 0xae, 0x20, 0x41, 0x31, 0x12, 0xe6, 0xfa, 0x4e,
+		  0x89, 0xa9, 0x7e, 0xa2, 0x0a, 0x9e, 0xee, 0xe6, 0x4b, 0x55,
+		  0xd3, 0x9a, 0x21, 0x92, 0x99, 0x2a, 0x27, 0x4f, 0xc1, 0xa8,
+		  0x36, 0xba, 0x3c, 0x23, 0xa3, 0xfe, 0xeb, 0xbd, 0x45, 0x4d,
+		  0x44, 0x23, 0x64, 0x3c, 0xe8, 0x0e, 0x2a, 0x9a, 0xc9, 0x4f,
+		  0xa5, 0x4c, 0xa4, 0x9f },
+		{ 0xba, 0x80, 0xa5, 0x3f, 0x98, 0x1c, 0x4d, 0x0d, 0x6a, 0x27,
+		  0x97, 0xb6, 0x9f, 0x12, 0xf6, 0xe9, 0x4c, 0x21, 0x2f, 0x14,
+		  0x68, 0x5a, 0xc4, 0xb7, 0x4b, 0x12, 0xbb, 0x6f, 0xdb, 0xff,
+		  0xa2, 0xd1, 0x7d, 0x87, 0xc5, 0x39, 0x2a, 0xab, 0x79, 0x2d,
+		  0xc2, 0x52, 0xd5, 0xde, 0x45, 0x33, 0xcc, 0x95, 0x18, 0xd3,
+		  0x8a, 0xa8, 0xdb, 0xf1, 0x92, 0x5a, 0xb9, 0x23, 0x86, 0xed,
+		  0xd4, 0x00, 0x99, 0x23 },
+	},
+	{
+		"abcdbcdecdefdefgefghfghighijhijkijkljklmklmnlmnomnopnopq", 56,
+		{ 0x84, 0x98, 0x3e, 0x44, 0x1c, 0x3b, 0xd2, 0x6e, 0xba, 0xae,
+		  0x4a, 0xa1, 0xf9, 0x51, 0x29, 0xe5, 0xe5, 0x46, 0x70, 0xf1 },
+		{ 0x24, 0x8d, 0x6a, 0x61, 0xd2, 0x06, 0x38, 0xb8, 0xe5, 0xc0,
+		  0x26, 0x93, 0x0c, 0x3e, 0x60, 0x39, 0xa3, 0x3c, 0xe4, 0x59,
+		  0x64, 0xff, 0x21, 0x67, 0xf6, 0xec, 0xed, 0xd4, 0x19, 0xdb,
+		  0x06, 0xc1 },
+		{ 0x33, 0x91, 0xfd, 0xdd, 0xfc, 0x8d, 0xc7, 0x39, 0x37, 0x07,
+		  0xa6, 0x5b, 0x1b, 0x47, 0x09, 0x39, 0x7c, 0xf8, 0xb1, 0xd1,
+		  0x62, 0xaf, 0x05, 0xab, 0xfe, 0x8f, 0x45, 0x0d, 0xe5, 0xf3,
+		  0x6b, 0xc6, 0xb0, 0x45, 0x5a, 0x85, 0x20, 0xbc, 0x4e, 0x6f,
+		  0x5f, 0xe9, 0x5b, 0x1f, 0xe3, 0xc8, 0x45, 0x2b },
+		{ 0x20, 0x4a, 0x8f, 0xc6, 0xdd, 0xa8, 0x2f, 0x0a, 0x0c, 0xed,
+		  0x7b, 0xeb, 0x8e, 0x08, 0xa4, 0x16, 0x57, 0xc1, 0x6e, 0xf4,
+		  0x68, 0xb2, 0x28, 0xa8, 0x27, 0x9b, 0xe3, 0x31, 0xa7, 0x03,
+		  0xc3, 0x35, 0x96, 0xfd, 0x15, 0xc1, 0x3b, 0x1b, 0x07, 0xf9,
+		  0xaa, 0x1d, 0x3b, 0xea, 0x57, 0x78, 0x9c, 0xa0, 0x31, 0xad,
+		  0x85, 0xc7, 0xa7, 0x1d, 0xd7, 0x03, 0x54, 0xec, 0x63, 0x12,
+		  0x38, 0xca, 0x34, 0x45 },
+		{ 0x72, 0x85, 0xff, 0x3e, 0x8b, 0xd7, 0x68, 0xd6, 0x9b, 0xe6,
+		  0x2b, 0x3b, 0xf1, 0x87, 0x65, 0xa3, 0x25, 0x91, 0x7f, 0xa9,
+		  0x74, 0x4a, 0xc2, 0xf5, 0x82, 0xa2, 0x08, 0x50, 0xbc, 0x2b,
+		  0x11, 0x41, 0xed, 0x1b, 0x3e, 0x45, 0x28, 0x59, 0x5a, 0xcc,
+		  0x90, 0x77, 0x2b, 0xdf, 0x2d, 0x37, 0xdc, 0x8a, 0x47, 0x13,
+		  0x0b, 0x44, 0xf3, 0x3a, 0x02, 0xe8, 0x73, 0x0e, 0x5a, 0xd8,
+		  0xe1, 0x66, 0xe8, 0x88 },
+	},
+	{
+		NULL, PATTERN_LEN,
+		{ 0x42, 0x92, 0xbf, 0xb8, 0x23, 0xf8, 0x7b, 0xcf, 0x79, 0x3f,
+		  0x09, 0xc4, 0x0f, 0x79, 0xb5, 0x52, 0x8c, 0x33, 0x9f, 0x72 },
+		{ 0x62, 0x35, 0xad, 0xfd, 0x31, 0xdc, 0xdd, 0xa8, 0x37, 0x75,
+		  0x99, 0x89, 0x10, 0xc8, 0x89, 0xab, 0x8c, 0xfe, 0xac, 0xd2,
+		  0x46, 0xbe, 0xeb, 0x47, 0x5e, 0xb8, 0x7f, 0x13, 0x03, 0xea,
+		  0x37, 0x38 },
+		{ 0x6c, 0x18, 0x95, 0xdf, 0xa8, 0x54, 0x97, 0xd1, 0xd1, 0xea,
+		  0x04, 0x32, 0x9c, 0xb2, 0x89, 0x69, 0x07, 0xc6, 0x59, 0xd1,
+		  0x30, 0x18, 0x62, 0x0d, 0xb0, 0xa1, 0x4d, 0xa7, 0xb1, 0xc3,
+		  0x42, 0x84, 0xb0, 0xcf, 0xc6, 0x8d, 0xd9, 0x26, 0x5e, 0x4a,
+		  0x64, 0x92, 0xe1, 0x3b, 0xad, 0x97, 0x3a, 0xb7 },
+		{ 0xa8, 0x76, 0x09, 0x6e, 0xfa, 0x27, 0x48, 0x76, 0x94, 0xf9,
+		  0xa0, 0xeb, 0xb9, 0x12, 0xbb, 0x6c, 0x68, 0xe0, 0x99, 0x26,
+		  0x47, 0xb7, 0xa7, 0x1c, 0xc0, 0x76, 0x14, 0xfd, 0x41, 0xe5,
+		  0xa6, 0xec, 0x59, 0x98, 0xd1, 0x12, 0xbf, 0xb3, 0xe0, 0x7f,
+		  0xe8, 0x8b, 0x47, 0x74, 0x84, 0x9f, 0x41, 0x4c, 0xbe, 0x3f,
+		  0x61, 0x11, 0xdf, 0xb1, 0x9c, 0xa7, 0xac, 0x60, 0xfc, 0x37,
+		  0x20, 0x21, 0xc0, 0xee },
+		{ 0x1b, 0x35, 0xc5, 0xf8, 0xb8, 0x35, 0x54, 0xc4, 0x2e, 0x25,
+		  0x43, 0x0b, 0x74, 0x42, 0x95, 0x75, 0xd3, 0xdd, 0x98, 0xc7,
+		  0x4c, 0x4d, 0x69, 0xb4, 0x7f, 0x37, 0x11, 0x25, 0x34, 0xdd,
+		  0x5a, 0xf5, 0xac, 0x10, 0xf8, 0xa7, 0xfb, 0x9b, 0x0b, 0x8e,
+		  0x5f, 0x05, 0x04, 0xcc, 0x4c, 0x91, 0xfa, 0x64, 0x9d, 0x0c,
+		  0x25, 0xf5, 0x3c, 0xee, 0xf5, 0x7b, 0x67, 0x62, 0x90, 0x0f,
+		  0x38, 0x4b, 0xe4, 0x88 },
+	},
+	{
+		NULL, MILLION,	/* one million times 'a' */
+		{ 0x34, 0xaa, 0x97, 0x3c, 0xd4, 0xc4, 0xda, 0xa4, 0xf6, 0x1e,
+		  0xeb, 0x2b, 0xdb, 0xad, 0x27, 0x31, 0x65, 0x34, 0x01, 0x6f },
+		{ 0xcd, 0xc7, 0x6e, 0x5c, 0x99, 0x14, 0xfb, 0x92, 0x81, 0xa1,
+		  0xc7, 0xe2, 0x84, 0xd7, 0x3e, 0x67, 0xf1, 0x80, 0x9a, 0x48,
+		  0xa4, 0x97, 0x20, 0x0e, 0x04, 0x6d, 0x39, 0xcc, 0xc7, 0x11,
+		  0x2c, 0xd0 },
+		{ 0x9d, 0x0e, 0x18, 0x09, 0x71, 0x64, 0x74, 0xcb, 0x08, 0x6e,
+		  0x83, 0x4e, 0x31, 0x0a, 0x4a, 0x1c, 0xed, 0x14, 0x9e, 0x9c,
+		  0x00, 0xf2, 0x48, 0x52, 0x79, 0x72, 0xce, 0xc5, 0x70, 0x4c,
+		  0x2a, 0x5b, 0x07, 0xb8, 0xb3, 0xdc, 0x38, 0xec, 0xc4, 0xeb,
+		  0xae, 0x97, 0xdd, 0xd8, 0x7f, 0x3d, 0x89, 0x85 },
+		{ 0xe7, 0x18, 0x48, 0x3d, 0x0c, 0xe7, 0x69, 0x64, 0x4e, 0x2e,
+		  0x42, 0xc7, 0xbc, 0x15, 0xb4, 0x63, 0x8e, 0x1f, 0x98, 0xb1,
+		  0x3b, 0x20, 0x44, 0x28, 0x56, 0x32, 0xa8, 0x03, 0xaf, 0xa9,
+		  0x73, 0xeb, 0xde, 0x0f, 0xf2, 0x44, 0x87, 0x7e, 0xa6, 0x0a,
+		  0x4c, 0xb0, 0x43, 0x2c, 0xe5, 0x77, 0xc3, 0x1b, 0xeb, 0x00,
+		  0x9c, 0x5c, 0x2c, 0x49, 0xaa, 0x2e, 0x4e, 0xad, 0xb2, 0x17,
+		  0xad, 0x8c, 0xc0, 0x9b },
+		{ 0x98, 0xfb, 0x3e, 0xfb, 0x72, 0x06, 0xfd, 0x19, 0xeb, 0xf6,
+		  0x9b, 0x6f, 0x31, 0x2c, 0xf7, 0xb6, 0x4e, 0x3b, 0x94, 0xdb,
+		  0xe1, 0xa1, 0x71, 0x07, 0x91, 0x39, 0x75, 0xa7, 0x93, 0xf1,
+		  0x77, 0xe1, 0xd0, 0x77, 0x60, 0x9d, 0x7f, 0xba, 0x36, 0x3c,
+		  0xbb, 0xa0, 0x0d, 0x05, 0xf7, 0xaa, 0x4e, 0x4f, 0xa8, 0x71,
+		  0x5d, 0x64, 0x28, 0x10, 0x4c, 0x0a, 0x75, 0x64, 0x3b, 0x0f,
+		  0xf3, 0xfd, 0x3e, 0xaf },
+	},
+};
+
+/* Chunk sizes used to feed the data piecewise, cycled through in turn */
+static const int sha_test_chunks[] = { 1, 63, 64, 65, 127, 128, 130, 7, 1000 };
+#define NUM_CHUNKS	ARRAY_SIZE(sha_test_chunks)
+
+/**
+ * sha_test_data() - get the input data of a test vector
+ *
+ * @vec:	test vector
+ * Return:	allocated buffer holding @vec->len bytes, or NULL
+ */
+static u8 *sha_test_data(const struct sha_test_vector *vec)
+{
+	u8 *buf;
+	int i;
+
+	buf = malloc(vec->len + 1);
+	if (!buf)
+		return NULL;
+
+	if (vec->data)
+		memcpy(buf, vec->data, vec->len);
+	else if (vec->len == MILLION)
+		memset(buf, 'a', vec->len);
+	else
+		for (i = 0; i < vec->len; i++)
+			buf[i] = (i * 2654435761U) >> 24;
+
+	return buf;
+}
+
+/* Any of the contexts, so that one set of test operations fits them all */
+union sha_test_ctx {
+	sha1_context sha1;
+	sha256_context sha256;
+	sha512_context sha512;
+	blake2b_context blake2b;
+};
+
+/**
+ * struct sha_test_algo - an algorithm under test
+ *
+ * @name:	algorithm name
+ * @digest_len:	length of the digest in bytes
+ * @expected:	offset of the expected digest in struct sha_test_vector
+ * @csum_wd:	one-shot function with watchdog
+ * @starts:	start a progressive hash
+ * @update:	add data to a progressive hash
+ * @finish:	write out the digest of a progressive hash
+ * @ce_disabled: flag forcing the generic C code, NULL if there is no Crypto
+ *		Extensions code
+ */
+struct sha_test_algo {
+	const char *name;
+	int digest_len;
+	size_t expected;
+	void (*csum_wd)(const unsigned char *input, unsigned int ilen,
+			unsigned char *output, unsigned int chunk_sz);
+	void (*starts)(union sha_test_ctx *ctx);
+	void (*update)(union sha_test_ctx *ctx, const u8 *input,
+		       unsigned int len);
+	void (*finish)(union sha_test_ctx *ctx, u8 *output);
+	bool *ce_disabled;
+};
+
+#define SHA_TEST_OPS(_algo, _ctx)					\
+static void _algo##_test_starts(union sha_test_ctx *ctx)		\
+{									\
+	_algo##_starts(&ctx->_ctx);					\
+}									\
+									\
+static void _algo##_test_update(union sha_test_ctx *ctx,		\
+				const u8 *input, unsigned int len)	\
+{									\
+	_algo##_update(&ctx->_ctx, input, len);				\
+}									\
+									\
+static void _algo##_test_finish(union sha_test_ctx *ctx, u8 *output)	\
+{									\
+	_algo##_finish(&ctx->_ctx, output);				\
+}
+
+#define SHA_TEST_ALGO(_algo, _len, _ce) {				\
+	.name		= #_algo,					\
+	.digest_len	= _len,						\
+	.expected	= offsetof(struct sha_test_vector, _algo),	\
+	.csum_wd	= _algo##_csum_wd,				\
+	.starts		= _algo##_test_starts,				\
+	.update		= _algo##_test_update,				\
+	.finish		= _algo##_test_finish,				\
+	.ce_disabled	= _ce,						\
+}
+
+#ifdef CONFIG_SHA_ARMV8_CE
+#define SHA_TEST_CE(_algo)	(&_algo##_ce_disabled)
+#else
+#define SHA_TEST_CE(_algo)	NULL
+#endif
+
+#ifdef CONFIG_SHA1
+SHA_TEST_OPS(sha1, sha1)
+#endif
+SHA_TEST_OPS(sha256, sha256)
+#ifdef CONFIG_SHA384
+SHA_TEST_OPS(sha384, sha512)
+#endif
+#ifdef CONFIG_SHA512
+SHA_TEST_OPS(sha512, sha512)
+#endif
+#ifdef CONFIG_BLAKE2B
+SHA_TEST_OPS(blake2b, blake2b)
+#endif
+
+static const struct sha_test_algo sha_test_algos[] = {
+#ifdef CONFIG_SHA1
+	SHA_TEST_ALGO(sha1, SHA1_SUM_LEN, SHA_TEST_CE(sha1)),
+#endif
+	SHA_TEST_ALGO(sha256, SHA256_SUM_LEN, SHA_TEST_CE(sha256)),
+#ifdef CONFIG_SHA384
+	SHA_TEST_ALGO(sha384, SHA384_SUM_LEN, NULL),
+#endif
+#ifdef CONFIG_SHA512
+	SHA_TEST_ALGO(sha512, SHA512_SUM_LEN, NULL),
+#endif
+#ifdef CONFIG_BLAKE2B
+	SHA_TEST_ALGO(blake2b, BLAKE2B_SUM_LEN, NULL),
+#endif
+};
+
+/**
+ * sha_test_one() - check one algorithm against one test vector
+ *
+ * The data is hashed in one go and then fed piecewise, cycling through
+ * sha_test_chunks[].
+ *
+ * @uts:	test state
+ * @algo:	algorithm under test
+ * @vec:	test vector
+ * @buf:	input data of @vec
+ * Return:	0 if OK, CMD_RET_FAILURE on mismatch
+ */
+static int sha_test_one(struct unit_test_state *uts,
+			const struct sha_test_algo *algo,
+			const struct sha_test_vector *vec, const u8 *buf)
+{
+	const u8 *expected = (const u8 *)vec + algo->expected;
+	u8 digest[SHA512_SUM_LEN];
+	union sha_test_ctx ctx;
+	int pos, len, chunk;
+
+	algo->csum_wd(buf, vec->len, digest, SHA_TEST_WD_CHUNK);
+	ut_asserteq_mem(expected, digest, algo->digest_len);
+
+	algo->starts(&ctx);
+	for (pos = 0, chunk = 0; pos < vec->len; pos += len, chunk++) {
+		len = min(sha_test_chunks[chunk % NUM_CHUNKS], vec->len - pos);
+		algo->update(&ctx, buf + pos, len);
+	}
+	algo->finish(&ctx, digest);
+	ut_asserteq_mem(expected, digest, algo->digest_len);
+
+	return 0;
+}
+
+static int lib_test_sha(struct unit_test_state *uts)
+{
+	const struct sha_test_algo *algo;
+	const struct sha_test_vector *vec;
+	int i, j;
+	u8 *buf;
+
+	for (i = 0; i < ARRAY_SIZE(sha_test_vectors); i++) {
+		vec = &sha_test_vectors[i];
+		buf = sha_test_data(vec);
+		ut_assertnonnull(buf);
+
+		for (j = 0; j < ARRAY_SIZE(sha_test_algos); j++) {
+			algo = &sha_test_algos[j];
+			ut_assertf(!sha_test_one(uts, algo, vec, buf),
+				   "%s, vector %d\n", algo->name, i);
+		}
+
+		free(buf);
+	}
+
+	return 0;
+}
+
+LIB_TEST(lib_test_sha, 0);
+
+#ifdef CONFIG_SHA_ARMV8_CE
+/* Random data for the C vs. Crypto Extensions comparison */
+#define SHA_TEST_CE_ROUNDS	64
+#define SHA_TEST_CE_MAX_LEN	4096
+#define SHA_TEST_CE_MAX_CHUNK	300
+
+/**
+ * sha_test_random_chunks() - hash data fed in chunks of random size
+ *
+ * @algo:	algorithm to use
+ * @buf:	input data
+ * @len:	length of @buf
+ * @seed:	seed for the chunk sizes, so that they can be repeated
+ * @digest:	returns the digest
+ */
+static void sha_test_random_chunks(const struct sha_test_algo *algo,
+				   const u8 *buf, int len, unsigned int seed,
+				   u8 *digest)
+{
+	union sha_test_ctx ctx;
+	int pos, size;
+
+	algo->starts(&ctx);
+	for (pos = 0; pos < len; pos += size) {
+		size = min((int)(rand_r(&seed) % SHA_TEST_CE_MAX_CHUNK) + 1,
+			   len - pos);
+		algo->update(&ctx, buf + pos, size);
+	}
+	algo->finish(&ctx, digest);
+}
+
+/* Check the Crypto Extensions code against the generic C code */
+static int lib_test_sha_ce(struct unit_test_state *uts)
+{
+	u8 ce_digest[SHA512_SUM_LEN], c_digest[SHA512_SUM_LEN];
+	const struct sha_test_algo *algo;
+	unsigned int seed;
+	int i, j, len;
+	u8 *buf;
+
+	buf = malloc(SHA_TEST_CE_MAX_LEN);
+	ut_assertnonnull(buf);
+
+	for (i = 0; i < SHA_TEST_CE_ROUNDS; i++) {
+		len = rand() % (SHA_TEST_CE_MAX_LEN + 1);
+		for (j = 0; j < len; j++)
+			buf[j] = rand();
+		seed = rand();
+
+		for (j = 0; j < ARRAY_SIZE(sha_test_algos); j++) {
+			algo = &sha_test_algos[j];
+			if (!algo->ce_disabled)
+				continue;
+
+			algo->csum_wd(buf, len, ce_digest, SHA_TEST_WD_CHUNK);
+			*algo->ce_disabled = true;
+			algo->csum_wd(buf, len, c_digest, SHA_TEST_WD_CHUNK);
+			*algo->ce_disabled = false;
+			ut_assertf(!memcmp(ce_digest, c_digest,
+					   algo->digest_len),
+				   "%s, len %d\n", algo->name, len);
+
+			sha_test_random_chunks(algo, buf, len, seed, ce_digest);
+			*algo->ce_disabled = true;
+			sha_test_random_chunks(algo, buf, len, seed, c_digest);
+			*algo->ce_disabled = false;
+			ut_assertf(!memcmp(ce_digest, c_digest,
+					   algo->digest_len),
+				   "%s, len %d, seed %u\n", algo->name, len,
+				   seed);
+		}
+	}
+
+	free(buf);
+
+	return 0;
+}
+
+LIB_TEST(lib_test_sha_ce, 0);
+#endif